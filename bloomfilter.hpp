@@ -0,0 +1,210 @@
+﻿/*****************************************************************
+ * @file   bloomfilter.hpp
+ * @brief  Blokkosított Bloom szűrő a HashTable sikertelen kereséseinek gyorsítására.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+#include <memory>
+#include <cstdint>
+#include <cmath>
+#include <atomic>
+
+#include "memtrace.h"
+
+/**
+ * A Bloom szűrő statisztikái.
+ */
+struct BloomStats {
+	size_t memoryBytes; //< A szűrő által foglalt memória
+	size_t keys; //< A szűrőbe tett kulcsok száma (a törölteket is beleértve, azok nem vehetők ki)
+	double estimatedFalsePositiveRate; //< A becsült téves pozitív arány a jelenlegi kitöltöttség mellett
+	size_t queries; //< A szűrőtől kérdezett keresések száma
+	size_t filtered; //< Ennyi keresést utasított el a szűrő a vödrök érintése nélkül
+	size_t falsePositives; //< Ennyiszer mondta a szűrő, hogy lehet benne, de nem volt benne
+
+	/**
+	 * @return a mért téves pozitív arány a szűrő által át nem szűrt sikertelen keresések között
+	 */
+	double falsePositiveRate() const {
+		size_t negatives = filtered + falsePositives;
+		return negatives == 0 ? 0.0 : (double)falsePositives / (double)negatives;
+	}
+};
+
+/**
+ * Blokkosított Bloom szűrő.
+ * Egy kulcs minden bitje ugyanabba a 64 byte-os (egy cache line-nyi) blokkba esik,
+ * így egy kérdés legfeljebb egy cache line-t érint. Törölni nem lehet belőle, ezért újra kell építeni.
+ * A kulcsok helyett 64 bites hash értékekkel dolgozik: a hash felső 32 bitje választja a blokkot,
+ * az alsó 32 bitből jön a blokkon belüli bitek két hash-e, így a kettő független.
+ * A mayContain több szálból is hívható (a statisztikák atomiak), az add és a reset nem.
+ * @tparam Alloc allokátor, a blokkok ebből foglalódnak
+ */
+template <typename Alloc = std::allocator<char>>
+class BloomFilter {
+	/**
+	 * Egy cache line-nyi bit.
+	 */
+	struct alignas(64) Block {
+		uint64_t words[8];
+	};
+	static const size_t blockBits = 512;
+
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Block> blockAlloc;
+	typedef std::allocator_traits<blockAlloc> traits;
+
+	blockAlloc alloc; //< A blokkok allokátora
+	Block* blocks; //< A bitek
+	size_t nBlocks; //< A blokkok száma, 0: a szűrő ki van kapcsolva
+	size_t nHashes; //< Ennyi bitet állít be egy kulcs
+	size_t nKeys; //< A betett kulcsok száma
+	size_t sizedKeys; //< Ennyi kulcsra van méretezve
+	mutable std::atomic<size_t> nQueries; //< Statisztika
+	mutable std::atomic<size_t> nFiltered; //< Statisztika
+	mutable std::atomic<size_t> nFalsePositives; //< Statisztika
+
+	/**
+	 * Felszabadítja a blokkokat.
+	 */
+	void deallocate() {
+		if (blocks != nullptr)
+			traits::deallocate(alloc, blocks, nBlocks);
+		blocks = nullptr;
+		nBlocks = 0;
+	}
+
+	/**
+	 * Összekeveri a hash bitjeit (splitmix64), hogy a gyenge hash függvényekből is egyenletes bitek legyenek.
+	 */
+	static uint64_t mix(uint64_t h) {
+		h += 0x9e3779b97f4a7c15ULL;
+		h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+		return h ^ (h >> 31);
+	}
+
+	/**
+	 * A hash blokkja. A felső 32 bitből.
+	 */
+	Block& block(uint64_t h) const {
+		return blocks[(size_t)((h >> 32) % nBlocks)];
+	}
+
+	/**
+	 * A blokkon belüli i. bit: (h1 + i * h2) % blockBits, ahol h1 a 0-8., h2 a 16-24. bitekből jön.
+	 */
+	static uint32_t bitIndex(uint64_t h, size_t i) {
+		uint32_t h1 = (uint32_t)h;
+		uint32_t h2 = ((uint32_t)h >> 16) | 1;
+		return (h1 + (uint32_t)i * h2) % blockBits;
+	}
+
+	BloomFilter(const BloomFilter&); //< Másoló konstruktor tiltása
+	BloomFilter& operator=(const BloomFilter&); //< Értékadás tiltása
+public:
+	/**
+	 * Kikapcsolt szűrőt hoz létre.
+	 * @param alloc a blokkok allokátora
+	 */
+	BloomFilter(const Alloc& alloc = Alloc()) :alloc(alloc), blocks(nullptr), nBlocks(0), nHashes(0), nKeys(0), sizedKeys(0), nQueries(0), nFiltered(0), nFalsePositives(0) {};
+
+	/**
+	 * Kiüríti és újraméretezi a szűrőt. A statisztikák megmaradnak.
+	 * @param expectedKeys ennyi kulcsra méretez
+	 * @param bitsPerKey kulcsonként ennyi bit. 0: kikapcsolja a szűrőt
+	 */
+	void reset(size_t expectedKeys, size_t bitsPerKey) {
+		deallocate();
+		nKeys = 0;
+		sizedKeys = expectedKeys;
+		if (bitsPerKey == 0) return;
+		nBlocks = (expectedKeys * bitsPerKey + blockBits - 1) / blockBits;
+		if (nBlocks == 0) nBlocks = 1;
+		// Az optimális bitszám kulcsonként: bitsPerKey * ln 2
+		nHashes = (size_t)(bitsPerKey * 0.69 + 0.5);
+		if (nHashes < 1) nHashes = 1;
+		if (nHashes > 16) nHashes = 16;
+		blocks = traits::allocate(alloc, nBlocks);
+		for (size_t i = 0; i < nBlocks; ++i)
+			for (size_t w = 0; w < 8; ++w)
+				blocks[i].words[w] = 0;
+	}
+
+	/**
+	 * @return be van-e kapcsolva a szűrő
+	 */
+	bool enabled() const {
+		return nBlocks != 0;
+	}
+
+	/**
+	 * @return elérte-e a kulcsok száma azt, amire a szűrő méretezve van. Ezután a téves pozitív arány
+	 *         gyorsan nő, ezért a következő add előtt érdemes nagyobb méretre újraépíteni.
+	 */
+	bool full() const {
+		return nKeys >= sizedKeys;
+	}
+
+	/**
+	 * Beteszi a hash értéket a szűrőbe.
+	 */
+	void add(uint64_t hash) {
+		uint64_t h = mix(hash);
+		Block& b = block(h);
+		for (size_t i = 0; i < nHashes; ++i) {
+			uint32_t bit = bitIndex(h, i);
+			b.words[bit / 64] |= (uint64_t)1 << (bit % 64);
+		}
+		++nKeys;
+	}
+
+	/**
+	 * @return false, ha a hash érték biztosan nincs a szűrőben, true, ha lehet benne
+	 */
+	bool mayContain(uint64_t hash) const {
+		nQueries.fetch_add(1, std::memory_order_relaxed);
+		uint64_t h = mix(hash);
+		const Block& b = block(h);
+		for (size_t i = 0; i < nHashes; ++i) {
+			uint32_t bit = bitIndex(h, i);
+			if ((b.words[bit / 64] & ((uint64_t)1 << (bit % 64))) == 0) {
+				nFiltered.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Jelzi, hogy a legutóbbi mayContain igaz volt, de a kulcs mégsem volt benne.
+	 */
+	void falsePositive() const {
+		nFalsePositives.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @return a szűrő statisztikái
+	 */
+	BloomStats stats() const {
+		BloomStats s;
+		s.memoryBytes = nBlocks * sizeof(Block);
+		s.keys = nKeys;
+		double m = (double)(nBlocks * blockBits);
+		s.estimatedFalsePositiveRate = enabled() ? std::pow(1.0 - std::exp(-(double)nHashes * (double)nKeys / m), (double)nHashes) : 0.0;
+		s.queries = nQueries.load(std::memory_order_relaxed);
+		s.filtered = nFiltered.load(std::memory_order_relaxed);
+		s.falsePositives = nFalsePositives.load(std::memory_order_relaxed);
+		return s;
+	}
+
+	~BloomFilter() {
+		deallocate();
+	}
+};
+
+#endif // !BLOOMFILTER_H
@@ -0,0 +1,257 @@
+﻿/*****************************************************************
+ * @file   buckets.hpp
+ * @brief  A HArray vödreinek (láncolt listáinak) tárolási módjai.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef BUCKETS_H
+#define BUCKETS_H
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include "fixarray.hpp"
+
+#include "memtrace.h"
+
+/**
+ * Szegmentált tárolás: nArrays darab defSize méretű FixArray.
+ * Az indexelés osztással keresi meg a tömböt, és kivételt dob, ha túlindexelünk.
+ * @tparam List a vödrök típusa
+ * @tparam defSize egy tömb mérete
+ * @tparam Alloc allokátor, a tömbök és a vödrök is ebből foglalnak
+ */
+template <typename List, size_t defSize, typename Alloc>
+class SegmentedBuckets {
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<List> listAlloc;
+	typedef FixArray<List, defSize, listAlloc> fixarr; //= FixArray<LinkedList<HashItem>, size>
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<fixarr> arrAlloc;
+	typedef std::allocator_traits<arrAlloc> traits;
+
+	arrAlloc alloc; //< A tömbök allokátora, a tömbök is ezzel foglalnak.
+	size_t nArrays; //< A tömbök száma
+	fixarr* pData; //< Láncolt listákkal feltöltött fix tömbök tárolója.
+
+	/**
+	 * Lefoglal és létrehoz nArrays darab tömböt.
+	 */
+	void allocate() {
+		if (nArrays == 0) {
+			pData = nullptr;
+			return;
+		}
+		pData = traits::allocate(alloc, nArrays);
+		for (size_t i = 0; i < nArrays; i++) {
+			constructWithAllocator(pData + i, alloc);
+		}
+	}
+
+	/**
+	 * Megszünteti és felszabadítja a tömböket.
+	 */
+	void deallocate() {
+		if (pData == nullptr) return;
+		for (size_t i = 0; i < nArrays; i++) {
+			traits::destroy(alloc, pData + i);
+		}
+		traits::deallocate(alloc, pData, nArrays);
+		pData = nullptr;
+	}
+	SegmentedBuckets(const SegmentedBuckets&); //< Másoló konstruktor tiltása
+public:
+	/**
+	 * Konstruktor.
+	 * @param nArrays ennyi tömböt foglal
+	 * @param alloc a foglalásokhoz használt allokátor
+	 */
+	SegmentedBuckets(size_t nArrays, const Alloc& alloc) :alloc(alloc), nArrays(nArrays), pData(nullptr) {
+		allocate();
+	}
+
+	/**
+	 * Értékadás, az allokátor csak akkor kerül át, ha az allokátor ezt kéri.
+	 */
+	SegmentedBuckets& operator=(const SegmentedBuckets& rhs) {
+		if (this == &rhs) return *this;
+		deallocate();
+		if constexpr (traits::propagate_on_container_copy_assignment::value)
+			alloc = rhs.alloc;
+		nArrays = rhs.nArrays;
+		allocate();
+		for (size_t i = 0; i < nArrays; i++) {
+			pData[i] = rhs.pData[i];
+		}
+		return *this;
+	}
+
+	/**
+	 * Hozzáfűz egy új, üres tömböt. A meglévő tömbök elemei nem mozdulnak el
+	 * (csak a tömbök fejlécei költöznek), így a vödrökre mutató pointerek érvényesek maradnak.
+	 */
+	void addArray() {
+		fixarr* p = traits::allocate(alloc, nArrays + 1);
+		std::allocator<fixarr> plain;
+		for (size_t i = 0; i < nArrays; i++) {
+			std::allocator_traits<std::allocator<fixarr>>::construct(plain, p + i, std::move(pData[i]));
+			traits::destroy(alloc, pData + i);
+		}
+		constructWithAllocator(p + nArrays, alloc);
+		if (pData != nullptr)
+			traits::deallocate(alloc, pData, nArrays);
+		pData = p;
+		++nArrays;
+	}
+
+	/**
+	 * @return az i. vödör
+	 */
+	List& operator[](size_t i) {
+		size_t idx_in_array = i % defSize;
+		size_t nArray = (i - idx_in_array) / defSize;
+
+		// Alulindexelés a size_t típus miatt nem lehetséges, elég a felső határt nézni.
+		if (nArray >= nArrays)
+			throw std::out_of_range("Out of range. Esetleg rossz a Hash fuggveny?");
+		return pData[nArray][idx_in_array];
+	}
+
+	/**
+	 * @return a használt allokátor másolata
+	 */
+	Alloc get_allocator() const {
+		return Alloc(alloc);
+	}
+
+	~SegmentedBuckets() {
+		deallocate();
+	}
+};
+
+/**
+ * Folytonos tárolás: az összes vödör egyetlen, cache line-hoz igazított tömbben van.
+ * Az indexelés közvetlen, nincs osztás. Az indexet csak debug buildben ellenőrzi (NDEBUG nélkül).
+ * @tparam List a vödrök típusa
+ * @tparam defSize egy tömb mérete, ennyi vödörrel nő a tömb
+ * @tparam Alloc allokátor, a tömb és a vödrök is ebből foglalnak
+ */
+template <typename List, size_t defSize, typename Alloc>
+class FlatBuckets {
+	/**
+	 * Egy cache line méretű, ahhoz igazított blokk. Ezekből foglal, így az allokátortól is igazított memóriát kap.
+	 */
+	struct alignas(64) CacheLine {
+		unsigned char bytes[64];
+	};
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<List> listAlloc;
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<CacheLine> lineAlloc;
+	typedef std::allocator_traits<listAlloc> listTraits;
+	typedef std::allocator_traits<lineAlloc> lineTraits;
+
+	lineAlloc alloc; //< A tömb allokátora
+	size_t nBuckets; //< A vödrök száma
+	size_t nLines; //< A lefoglalt cache line-ok száma
+	CacheLine* pLines; //< A lefoglalt memória
+	List* pData; //< A vödrök, a pLines-ban
+
+	/**
+	 * Lefoglal és létrehoz nBuckets darab vödröt.
+	 */
+	void allocate() {
+		nLines = (nBuckets * sizeof(List) + sizeof(CacheLine) - 1) / sizeof(CacheLine);
+		if (nLines == 0) {
+			pLines = nullptr;
+			pData = nullptr;
+			return;
+		}
+		pLines = lineTraits::allocate(alloc, nLines);
+		pData = reinterpret_cast<List*>(pLines);
+		listAlloc la(alloc);
+		for (size_t i = 0; i < nBuckets; i++) {
+			constructWithAllocator(pData + i, la);
+		}
+	}
+
+	/**
+	 * Megszünteti és felszabadítja a vödröket.
+	 */
+	void deallocate() {
+		if (pLines == nullptr) return;
+		listAlloc la(alloc);
+		for (size_t i = 0; i < nBuckets; i++) {
+			listTraits::destroy(la, pData + i);
+		}
+		lineTraits::deallocate(alloc, pLines, nLines);
+		pLines = nullptr;
+		pData = nullptr;
+	}
+	FlatBuckets(const FlatBuckets&); //< Másoló konstruktor tiltása
+public:
+	/**
+	 * Konstruktor.
+	 * @param nArrays ennyiszer defSize vödröt foglal
+	 * @param alloc a foglalásokhoz használt allokátor
+	 */
+	FlatBuckets(size_t nArrays, const Alloc& alloc) :alloc(alloc), nBuckets(nArrays * defSize), nLines(0), pLines(nullptr), pData(nullptr) {
+		allocate();
+	}
+
+	/**
+	 * Értékadás, az allokátor csak akkor kerül át, ha az allokátor ezt kéri.
+	 */
+	FlatBuckets& operator=(const FlatBuckets& rhs) {
+		if (this == &rhs) return *this;
+		deallocate();
+		if constexpr (lineTraits::propagate_on_container_copy_assignment::value)
+			alloc = rhs.alloc;
+		nBuckets = rhs.nBuckets;
+		allocate();
+		for (size_t i = 0; i < nBuckets; i++) {
+			pData[i] = rhs.pData[i];
+		}
+		return *this;
+	}
+
+	/**
+	 * @return az i. vödör
+	 */
+	List& operator[](size_t i) {
+#ifndef NDEBUG
+		if (i >= nBuckets)
+			throw std::out_of_range("Out of range. Esetleg rossz a Hash fuggveny?");
+#endif
+		return pData[i];
+	}
+
+	/**
+	 * @return a használt allokátor másolata
+	 */
+	Alloc get_allocator() const {
+		return Alloc(alloc);
+	}
+
+	~FlatBuckets() {
+		deallocate();
+	}
+};
+
+/**
+ * Szegmentált elrendezés (alapértelmezett): defSize méretű FixArray-ek tömbje.
+ */
+struct SegmentedLayout {
+	template <typename List, size_t defSize, typename Alloc>
+	using buckets = SegmentedBuckets<List, defSize, Alloc>;
+	static const bool stableGrowth = true; //< Tud tömböt hozzáfűzni a meglévők mozgatása nélkül (addArray)
+};
+
+/**
+ * Folytonos elrendezés: egyetlen cache line-hoz igazított vödörtömb, osztás nélküli indexeléssel.
+ */
+struct FlatLayout {
+	template <typename List, size_t defSize, typename Alloc>
+	using buckets = FlatBuckets<List, defSize, Alloc>;
+	static const bool stableGrowth = false; //< Növekedéskor az egész tömb újra foglalódik
+};
+
+#endif // !BUCKETS_H
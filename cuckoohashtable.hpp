@@ -0,0 +1,398 @@
+﻿/*****************************************************************
+ * @file   cuckoohashtable.hpp
+ * @brief  CuckooHashTable class: vödrös cuckoo hash tábla, legrosszabb esetben is O(1) kereséssel.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef CUCKOOHASHTABLE_H
+#define CUCKOOHASHTABLE_H
+#include <memory>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include "hashtable.hpp"
+
+#include "memtrace.h"
+
+/**
+ * Vödrös cuckoo hash tábla, a HashTable put / get / contains / remove felületével.
+ * Minden kulcsnak két lehetséges vödre van, egy vödörben 4 hely. A keresés legfeljebb a két vödröt
+ * és (ha nem üres) a pár elemes tartalékot (stash) nézi meg, a lánc hossza tehát nem nőhet.
+ * A két vödör mindig különböző, ehhez a tábla legalább 2 vödörrel indul.
+ * Egy vödör elején a 4 elem 1 byte-os ujjlenyomata (tag) áll, így a nem egyező helyeken a kulcsot
+ * sem kell összehasonlítani. Kis elemeknél (kulcs + érték legfeljebb 15 byte) egy vödör egy cache line,
+ * így egy keresés legfeljebb két cache line-t érint.
+ * A második vödör az elsőből és a tagből számolódik (partial-key cuckoo hashing), így egy elem
+ * áthelyezéséhez nem kell újra hashelni a kulcsát.
+ * Ha a beszúrás maxKicks áthelyezés után sem talál helyet, az utoljára kiszorított elem a tartalékba kerül,
+ * ha az is tele van, a tábla kétszeresére nő.
+ * @tparam T A tárolt adat típusa
+ * @tparam keyType A kulcs típusa.
+ * @tparam hashFunction Hash függvény, ha a kulcsra nincs std::hash, ezt hívja meg SIZE_MAX mérettel.
+ * @tparam Alloc Allokátor, a vödrök ebből foglalódnak. (default: std::allocator<T>)
+ */
+template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash, typename Alloc = std::allocator<T>>
+class CuckooHashTable {
+public:
+	static const size_t ways = 4; //< Helyek száma vödrönként
+	static const size_t maxKicks = 128; //< Az áthelyezési út maximális hossza
+	static const size_t stashSize = 4; //< A tartalék mérete
+private:
+	/**
+	 * Egy tárolt elem.
+	 */
+	struct Entry {
+		keyType key; //< Az elemhez tartozó kulcs
+		T value; //< A tárolt adat
+		Entry(const keyType& key, const T& value) :key(key), value(value) {};
+	};
+
+	/**
+	 * Egy vödör: elöl a tagek (0: üres hely), utánuk az elemek helye.
+	 */
+	struct alignas(64) Bucket {
+		uint8_t tags[ways]; //< Az elemek ujjlenyomata, 0: üres
+		alignas(Entry) unsigned char storage[ways * sizeof(Entry)]; //< Az elemek helye, csak a nem 0 tagűek élnek
+
+		Bucket() {
+			for (size_t i = 0; i < ways; ++i) tags[i] = 0;
+		}
+		Entry* entry(size_t i) {
+			return reinterpret_cast<Entry*>(storage) + i;
+		}
+	};
+
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Bucket> bucketAlloc;
+	typedef std::allocator_traits<bucketAlloc> bucketTraits;
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Entry> entryAlloc;
+	typedef std::allocator_traits<entryAlloc> entryTraits;
+
+	bucketAlloc alloc; //< A vödrök allokátora
+	entryAlloc eAlloc; //< Az elemek létrehozásához
+	Bucket* buckets; //< A vödrök
+	size_t nBuckets; //< A vödrök száma, kettőhatvány
+	size_t nElements; //< Az elemek száma (a tartalékkal együtt)
+	size_t nStashed; //< A tartalékban lévő elemek száma, 0 esetén a keresés nem nézi a tartalékot
+	Bucket stash; //< A tartalék, ugyanolyan szerkezetű, mint egy vödör
+	size_t nGrowths; //< Ennyiszer nőtt a tábla
+	double grownAt; //< A legutóbbi növekedés előtti telítettség
+	uint64_t rng; //< Az áthelyezendő hely választásához (xorshift)
+
+	static_assert(stashSize == ways, "A tartalek egy vodornyi.");
+
+	/**
+	 * @return a kulcs 64 bites, jól kevert hash-e
+	 */
+	static uint64_t hash64(const keyType& key) {
+		uint64_t h;
+		if constexpr (std::is_default_constructible<std::hash<keyType>>::value)
+			h = (uint64_t)std::hash<keyType>()(key);
+		else
+			h = (uint64_t)hashFunction(key, (size_t)-1);
+		// splitmix64, hogy a gyenge hash-ek (pl. std::hash<int>) alsó és felső bitjei is egyenletesek legyenek
+		h += 0x9e3779b97f4a7c15ULL;
+		h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+		return h ^ (h >> 31);
+	}
+
+	/**
+	 * @return a tag, 1..255
+	 */
+	static uint8_t tagOf(uint64_t h) {
+		uint8_t t = (uint8_t)(h >> 56);
+		return t == 0 ? 1 : t;
+	}
+
+	/**
+	 * @return a másik vödör. Önmaga inverze: alt(alt(b)) == b, és soha nem b: ha a tagből számolt eltolás
+	 *         a maszkolás után 0 lenne (pl. 128-as tag legfeljebb 128 vödörnél), 1 az eltolás.
+	 */
+	size_t alt(size_t b, uint8_t tag) const {
+		size_t offset = ((size_t)tag * 0x5bd1e995u) & (nBuckets - 1);
+		return b ^ (offset == 0 ? 1 : offset);
+	}
+
+	/**
+	 * Megkeresi a kulcsot a vödörben.
+	 * @return a hely indexe, vagy ways, ha nincs benne
+	 */
+	static size_t findIn(Bucket& b, uint8_t tag, const keyType& key) {
+		for (size_t i = 0; i < ways; ++i)
+			if (b.tags[i] == tag && b.entry(i)->key == key) return i;
+		return ways;
+	}
+
+	/**
+	 * @return a kulcs eleme, vagy nullptr
+	 */
+	Entry* find(const keyType& key);
+
+	/**
+	 * Berakja az elemet egy üres helyre, ha van.
+	 * @return sikerült-e
+	 */
+	bool placeIn(Bucket& b, uint8_t tag, Entry& e);
+
+	/**
+	 * Berakja az elemet (a kulcs biztosan nincs benne). Áthelyezéssel, tartalékkal, végül növekedéssel.
+	 */
+	void insertEntry(Entry& e);
+
+	/**
+	 * Megszünteti a vödör i. elemét.
+	 */
+	void destroy(Bucket& b, size_t i) {
+		entryTraits::destroy(eAlloc, b.entry(i));
+		b.tags[i] = 0;
+	}
+
+	/**
+	 * Lefoglal n vödröt.
+	 */
+	Bucket* allocate(size_t n);
+
+	/**
+	 * Megszünteti az elemeket, és felszabadítja a vödröket.
+	 */
+	void deallocate(Bucket* p, size_t n);
+
+	/**
+	 * Kétszeresére növeli a táblát, és mindent újra berak.
+	 */
+	void grow();
+
+	CuckooHashTable(const CuckooHashTable&); //< Másoló konstruktor tiltása
+	CuckooHashTable& operator=(const CuckooHashTable&); //< Értékadás tiltása
+public:
+	/**
+	 * Konstruktor.
+	 * @param expected ennyi elemre előre méretez (4 / 0.9 hely elemenként)
+	 * @param alloc a vödrök allokátora
+	 */
+	explicit CuckooHashTable(size_t expected = 16, const Alloc& alloc = Alloc());
+
+	/**
+	 * Berakja a megadott elemet, ha a kulcs még nincs benne.
+	 * @return true, ha új elem került be, false, ha a kulcs már benne volt
+	 */
+	bool put(keyType key, const T& value);
+
+	/**
+	 * @return a kulcshoz tartozó adatra mutató pointer, vagy nullptr
+	 */
+	T* get(keyType key) {
+		Entry* e = find(key);
+		return e == nullptr ? nullptr : &e->value;
+	}
+
+	/**
+	 * @return benne van-e a kulcs
+	 */
+	bool contains(keyType key) {
+		return find(key) != nullptr;
+	}
+
+	/**
+	 * Kitörli a kulcsot, ha benne van.
+	 */
+	void remove(keyType key);
+
+	/**
+	 * @return az elemek száma
+	 */
+	size_t size() const {
+		return nElements;
+	}
+
+	/**
+	 * @return a szabad helyek száma (a tartalékkal együtt)
+	 */
+	size_t capacity() const {
+		return nBuckets * ways + stashSize - nElements;
+	}
+
+	/**
+	 * @return a telítettség (elemszám / vödörhelyek)
+	 */
+	double loadFactor() const {
+		return (double)nElements / (double)(nBuckets * ways);
+	}
+
+	/**
+	 * @return a tartalékban lévő elemek száma
+	 */
+	size_t stashed() const {
+		return nStashed;
+	}
+
+	/**
+	 * @return ennyiszer nőtt a tábla
+	 */
+	size_t growths() const {
+		return nGrowths;
+	}
+
+	/**
+	 * @return a legutóbbi növekedést kiváltó beszúrás előtti telítettség, 0 ha még nem nőtt
+	 */
+	double loadFactorAtGrowth() const {
+		return grownAt;
+	}
+
+	~CuckooHashTable() {
+		deallocate(buckets, nBuckets);
+		for (size_t i = 0; i < stashSize; ++i)
+			if (stash.tags[i] != 0) destroy(stash, i);
+	}
+};
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), typename Alloc>
+inline CuckooHashTable<T, keyType, hashFunction, Alloc>::CuckooHashTable(size_t expected, const Alloc& alloc)
+	:alloc(alloc), eAlloc(alloc), buckets(nullptr), nBuckets(2), nElements(0), nStashed(0), nGrowths(0), grownAt(0), rng(0x2545f4914f6cdd1dULL)
+{
+	while ((double)(nBuckets * ways) * 0.9 < (double)expected)
+		nBuckets *= 2;
+	buckets = allocate(nBuckets);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), typename Alloc>
+inline typename CuckooHashTable<T, keyType, hashFunction, Alloc>::Bucket* CuckooHashTable<T, keyType, hashFunction, Alloc>::allocate(size_t n)
+{
+	Bucket* p = bucketTraits::allocate(alloc, n);
+	for (size_t i = 0; i < n; ++i)
+		bucketTraits::construct(alloc, p + i);
+	return p;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), typename Alloc>
+inline void CuckooHashTable<T, keyType, hashFunction, Alloc>::deallocate(Bucket* p, size_t n)
+{
+	for (size_t b = 0; b < n; ++b) {
+		for (size_t i = 0; i < ways; ++i)
+			if (p[b].tags[i] != 0) destroy(p[b], i);
+		bucketTraits::destroy(alloc, p + b);
+	}
+	bucketTraits::deallocate(alloc, p, n);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), typename Alloc>
+inline typename CuckooHashTable<T, keyType, hashFunction, Alloc>::Entry* CuckooHashTable<T, keyType, hashFunction, Alloc>::find(const keyType& key)
+{
+	uint64_t h = hash64(key);
+	uint8_t tag = tagOf(h);
+	size_t b1 = (size_t)h & (nBuckets - 1);
+	size_t i = findIn(buckets[b1], tag, key);
+	if (i != ways) return buckets[b1].entry(i);
+	size_t b2 = alt(b1, tag);
+	i = findIn(buckets[b2], tag, key);
+	if (i != ways) return buckets[b2].entry(i);
+	if (nStashed == 0) return nullptr;
+	i = findIn(stash, tag, key);
+	return i != ways ? stash.entry(i) : nullptr;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), typename Alloc>
+inline bool CuckooHashTable<T, keyType, hashFunction, Alloc>::placeIn(Bucket& b, uint8_t tag, Entry& e)
+{
+	for (size_t i = 0; i < ways; ++i) {
+		if (b.tags[i] == 0) {
+			entryTraits::construct(eAlloc, b.entry(i), std::move(e));
+			b.tags[i] = tag;
+			return true;
+		}
+	}
+	return false;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), typename Alloc>
+inline void CuckooHashTable<T, keyType, hashFunction, Alloc>::insertEntry(Entry& e)
+{
+	uint64_t h = hash64(e.key);
+	uint8_t tag = tagOf(h);
+	size_t b = (size_t)h & (nBuckets - 1);
+	if (placeIn(buckets[b], tag, e)) return;
+	b = alt(b, tag);
+	if (placeIn(buckets[b], tag, e)) return;
+
+	// Áthelyezés: egy véletlen elemet kiszorít, és a kiszorítottat a másik vödrébe próbálja
+	Entry homeless(std::move(e));
+	for (size_t kick = 0; kick < maxKicks; ++kick) {
+		rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+		size_t i = (size_t)(rng % ways);
+		Bucket& bucket = buckets[b];
+		std::swap(homeless, *bucket.entry(i));
+		std::swap(tag, bucket.tags[i]);
+		b = alt(b, tag);
+		if (placeIn(buckets[b], tag, homeless)) return;
+	}
+	if (placeIn(stash, tag, homeless)) {
+		++nStashed;
+		return;
+	}
+
+	// Nincs áthelyezési út, és a tartalék is tele van
+	grow();
+	insertEntry(homeless);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), typename Alloc>
+inline void CuckooHashTable<T, keyType, hashFunction, Alloc>::grow()
+{
+	grownAt = loadFactor();
+	++nGrowths;
+	Bucket* old = buckets;
+	size_t nOld = nBuckets;
+	nBuckets *= 2;
+	buckets = allocate(nBuckets);
+	for (size_t b = 0; b < nOld; ++b) {
+		for (size_t i = 0; i < ways; ++i) {
+			if (old[b].tags[i] != 0) {
+				insertEntry(*old[b].entry(i));
+			}
+		}
+	}
+	deallocate(old, nOld);
+	for (size_t i = 0; i < stashSize; ++i) {
+		if (stash.tags[i] != 0) {
+			Entry e(std::move(*stash.entry(i)));
+			destroy(stash, i);
+			--nStashed;
+			insertEntry(e);
+		}
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), typename Alloc>
+inline bool CuckooHashTable<T, keyType, hashFunction, Alloc>::put(keyType key, const T& value)
+{
+	if (find(key) != nullptr) return false;
+	Entry e(key, value);
+	insertEntry(e);
+	++nElements;
+	return true;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), typename Alloc>
+inline void CuckooHashTable<T, keyType, hashFunction, Alloc>::remove(keyType key)
+{
+	uint64_t h = hash64(key);
+	uint8_t tag = tagOf(h);
+	size_t b1 = (size_t)h & (nBuckets - 1);
+	Bucket* candidates[3] = { &buckets[b1], &buckets[alt(b1, tag)], &stash };
+	for (Bucket* b : candidates) {
+		size_t i = findIn(*b, tag, key);
+		if (i != ways) {
+			destroy(*b, i);
+			--nElements;
+			if (b == &stash) --nStashed;
+			return;
+		}
+	}
+}
+
+#endif // !CUCKOOHASHTABLE_H
@@ -0,0 +1,606 @@
+﻿/*****************************************************************
+ * @file   diskhashtable.hpp
+ * @brief  DiskHashTable class: lemezen tárolt, bővíthető (extendible) hash tábla a memóriánál nagyobb adathalmazokhoz.
+ *         POSIX fájlkezelést használ (pread, pwrite, fdatasync, rename).
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef DISKHASHTABLE_H
+#define DISKHASHTABLE_H
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "hashtable.hpp"
+#include "durabletable.hpp"
+
+#include "memtrace.h"
+
+/**
+ * Lemezen tárolt Hash tábla, bővíthető hasheléssel (extendible hashing, Fagin et al.).
+ * Az adatok egy fájlban, pageSize méretű lapokon vannak. A memóriában csak a 2^d bejegyzéses
+ * könyvtár (lapszámok) és egy korlátos lap cache van, így a tábla a memóriánál sokkal nagyobb is lehet.
+ * A kulcs hash-ének alsó d bitje választja ki a könyvtár bejegyzését, az pedig a lapot.
+ * Ha egy lap megtelik, csak az a lap válik ketté (a következő hash bit szerint), a könyvtár
+ * csak akkor duplázódik, ha a lap helyi mélysége elérte a globálisat. Egy get a cache
+ * hiányakor legfeljebb egy lapot olvas be (kivéve a túlcsordulási láncokat, lásd lent).
+ * A cache óra (clock) algoritmussal választ kidobandó lapot, a módosított lapot kidobáskor írja ki.
+ *
+ * A kulcsok és értékek a wal::encode / wal::decode függvényekkel kerülnek a lapra (std::string és
+ * triviálisan másolható típusok, másokhoz túlterhelés kell). Egy rekord: u64 hash, u32 hossz, kulcs, érték.
+ * Ha a teli lap minden elemének ugyanaz a teljes hash-e, vagy a könyvtár elérte a maxDepth mélységet,
+ * a kettéválasztás nem segítene: ilyenkor túlcsordulási lap kerül a lap után.
+ * A lapok törléskor nem olvadnak össze.
+ *
+ * A flush() (és a destruktor) kiírja a módosított lapokat és a könyvtárat (path.dir), így a tábla újra megnyitható.
+ * Összeomlás ellen nem véd: a két flush() közti módosítások elveszhetnek, a fájl akár inkonzisztens is lehet.
+ * Tartós táblához a DurableHashTable való.
+ * @tparam T A tárolt adat típusa
+ * @tparam keyType A kulcs típusa.
+ * @tparam hashFunction Hash függvény, H(kulcs) % maxSize alakú: a tábla maxSize = SIZE_MAX-szal hívja,
+ *         és a teljes értéket keveri tovább.
+ * @tparam pageSize A lapok mérete byte-ban.
+ */
+template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash, size_t pageSize = 4096>
+class DiskHashTable {
+	static const uint32_t noPage = 0xffffffffu;
+	static const size_t headerSize = 16; //< Lap fejléc: u32 helyi mélység, u32 rekordok száma, u32 foglalt byte, u32 túlcsordulási lap
+	static const size_t recordHeader = 12; //< Rekord fejléc: u64 hash, u32 hossz
+	static const uint32_t maxDepth = 24; //< A könyvtár legfeljebb 2^24 bejegyzés (64 MB)
+	static const uint32_t magic = 0x54485845; //< "EXHT"
+	static_assert(pageSize >= 128, "Tul kicsi lapmeret.");
+
+	/**
+	 * Egy lap helye a cache-ben.
+	 */
+	struct Frame {
+		uint32_t id; //< A benne lévő lap, vagy noPage
+		bool dirty; //< Módosult-e beolvasás óta
+		bool ref; //< Az óra algoritmus hivatkozás bitje
+		char* data; //< A lap tartalma
+	};
+
+	int fd; //< Az adatfájl
+	std::string path; //< Az adatfájl neve
+	std::vector<uint32_t> directory; //< 2^globalDepth lapszám
+	uint32_t globalDepth; //< A könyvtár mélysége
+	uint32_t nPages; //< A fájl lapjainak száma
+	std::vector<uint32_t> freePages; //< Felszabadult (újrahasználható) lapok
+	size_t count; //< Az elemek száma
+	std::vector<char> pool; //< A cache lapjai egy tömbben
+	std::vector<Frame> frames; //< A cache
+	HashTable<size_t, int, linHash, 1024> resident; //< Lapszám -> cache index
+	size_t hand; //< Az óra mutatója
+	uint64_t nReads; //< Beolvasott lapok
+	uint64_t nWrites; //< Kiírt lapok
+	uint64_t nHits; //< Cache találatok
+
+	static uint32_t getU32(const char* p) { return wal::getU32(p); }
+	static void setU32(char* p, uint32_t v) {
+		for (int i = 0; i < 4; ++i) p[i] = (char)((v >> (8 * i)) & 0xff);
+	}
+	static uint64_t getU64(const char* p) { return (uint64_t)getU32(p) | ((uint64_t)getU32(p + 4) << 32); }
+	static void setU64(char* p, uint64_t v) { setU32(p, (uint32_t)v); setU32(p + 4, (uint32_t)(v >> 32)); }
+
+	static uint32_t localDepth(const char* p) { return getU32(p); }
+	static uint32_t records(const char* p) { return getU32(p + 4); }
+	static uint32_t used(const char* p) { return getU32(p + 8); }
+	static uint32_t overflow(const char* p) { return getU32(p + 12); }
+
+	/**
+	 * A hash függvény teljes értéke, összekeverve, hogy az alsó bitek is egyenletesek legyenek.
+	 */
+	static uint64_t fullHash(const keyType& key) {
+		uint64_t h = (uint64_t)hashFunction(key, SIZE_MAX);
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	/**
+	 * @return a hash-hez tartozó lánc első lapja
+	 */
+	uint32_t headOf(uint64_t h) const {
+		return directory[(size_t)(h & (((uint64_t)1 << globalDepth) - 1))];
+	}
+
+	void readPage(uint32_t id, char* buf);
+	void writePage(uint32_t id, const char* buf);
+
+	/**
+	 * Cache-be hozza a lapot.
+	 * A visszaadott pointer csak a következő page() hívásig érvényes, mert az kidobhatja a lapot.
+	 * @param write módosítani fogja (kidobáskor ki kell írni)
+	 * @param fresh új lap: nem olvassa be, hanem kinullázza
+	 */
+	char* page(uint32_t id, bool write, bool fresh = false);
+
+	/**
+	 * @return egy szabad lap száma (a fájl végén, ha nincs felszabadult)
+	 */
+	uint32_t allocPage() {
+		if (!freePages.empty()) {
+			uint32_t id = freePages.back();
+			freePages.pop_back();
+			return id;
+		}
+		if (nPages == noPage) throw std::length_error("Betelt a lapszam tartomany.");
+		return nPages++;
+	}
+
+	/**
+	 * Új, üres lapot kezd.
+	 */
+	char* initPage(uint32_t id, uint32_t depth) {
+		char* p = page(id, true, true);
+		setU32(p, depth);
+		setU32(p + 12, noPage);
+		return p;
+	}
+
+	/**
+	 * @return a kulcs rekordjának kezdete a lapon, vagy 0
+	 */
+	static size_t find(const char* p, uint64_t h, const keyType& key);
+
+	/**
+	 * A lap végére írja a rekordot. A hívó ellenőrzi, hogy elfér-e.
+	 */
+	static void append(char* p, const std::string& rec) {
+		std::memcpy(p + headerSize + used(p), rec.data(), rec.size());
+		setU32(p + 4, records(p) + 1);
+		setU32(p + 8, used(p) + (uint32_t)rec.size());
+	}
+
+	/**
+	 * Lapok láncába írja a rekordokat, az első lap a first, a többi új lap.
+	 */
+	void writeChain(uint32_t first, uint32_t depth, const std::vector<std::string>& recs);
+
+	/**
+	 * Kettéválasztja a h-hoz tartozó láncot a következő hash bit szerint, ha kell, a könyvtárat is megduplázza.
+	 */
+	void split(uint64_t h);
+
+	void loadDirectory(const std::string& meta);
+
+	DiskHashTable(const DiskHashTable&); //< Másoló konstruktor tiltása
+	DiskHashTable& operator=(const DiskHashTable&); //< Értékadás tiltása
+public:
+	/**
+	 * Megnyitja vagy létrehozza a táblát.
+	 * @param path az adatfájl, a könyvtár a path.dir fájlba kerül
+	 * @param cachePages ennyi lap lehet egyszerre a memóriában
+	 * @throw std::invalid_argument ha a cachePages 0
+	 * @throw std::runtime_error ha a fájl nem nyitható meg, vagy nem ilyen lapmérettel készült
+	 */
+	explicit DiskHashTable(const std::string& path, size_t cachePages = 256);
+
+	/**
+	 * Kiírja a módosításokat, és bezárja a fájlt.
+	 */
+	~DiskHashTable();
+
+	/**
+	 * Berakja az elemet, ha a kulcs még nincs benne.
+	 * @return true, ha új elem került be
+	 * @throw std::length_error ha a rekord nem fér el egy üres lapon
+	 */
+	bool put(const keyType& key, const T& value);
+
+	/**
+	 * Berakja az elemet, a meglévő értéket felülírja.
+	 */
+	void assign(const keyType& key, const T& value) {
+		remove(key);
+		put(key, value);
+	}
+
+	/**
+	 * Kikeresi a kulcsot.
+	 * @param value ide másolja az értéket, ha megtalálta
+	 * @return benne van-e a kulcs
+	 */
+	bool get(const keyType& key, T& value);
+
+	/**
+	 * @return benne van-e a kulcs
+	 */
+	bool contains(const keyType& key);
+
+	/**
+	 * Kitörli a kulcsot, ha benne van.
+	 * @return true, ha törölt
+	 */
+	bool remove(const keyType& key);
+
+	/**
+	 * Kiírja a módosított lapokat és a könyvtárat, majd fdatasync-eli az adatfájlt.
+	 * @throw std::runtime_error írási hiba esetén
+	 */
+	void flush();
+
+	/**
+	 * @return az elemek száma
+	 */
+	size_t size() const { return count; }
+
+	/**
+	 * @return a fájl lapjainak száma
+	 */
+	size_t pages() const { return nPages; }
+
+	/**
+	 * @return a könyvtár mélysége (2^depth bejegyzés)
+	 */
+	size_t depth() const { return globalDepth; }
+
+	/**
+	 * @return a lemezről beolvasott lapok száma
+	 */
+	uint64_t pageReads() const { return nReads; }
+
+	/**
+	 * @return a lemezre kiírt lapok száma
+	 */
+	uint64_t pageWrites() const { return nWrites; }
+
+	/**
+	 * @return a cache-ben talált laphivatkozások száma
+	 */
+	uint64_t cacheHits() const { return nHits; }
+
+	/**
+	 * Nullázza a statisztikákat.
+	 */
+	void resetStats() { nReads = nWrites = nHits = 0; }
+};
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline DiskHashTable<T, keyType, hashFunction, pageSize>::DiskHashTable(const std::string& path, size_t cachePages)
+	:fd(-1), path(path), globalDepth(0), nPages(0), count(0), hand(0), nReads(0), nWrites(0), nHits(0)
+{
+	if (cachePages == 0) throw std::invalid_argument("Legalabb egy lapnyi cache kell.");
+	pool.resize(cachePages * pageSize);
+	frames.resize(cachePages);
+	for (size_t i = 0; i < cachePages; ++i) {
+		Frame f = { noPage, false, false, &pool[i * pageSize] };
+		frames[i] = f;
+	}
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd < 0) throw std::runtime_error("Nem nyithato meg: " + path);
+	struct stat st;
+	std::string meta;
+	if (wal::readFile(path + ".dir", meta)) {
+		loadDirectory(meta);
+	}
+	else if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+		::close(fd);
+		throw std::runtime_error("Hianyzik a konyvtar: " + path + ".dir");
+	}
+	else {
+		directory.push_back(allocPage());
+		initPage(directory[0], 0);
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline DiskHashTable<T, keyType, hashFunction, pageSize>::~DiskHashTable()
+{
+	try {
+		flush();
+	}
+	catch (std::exception&) {
+		// Destruktorból nem dobhatunk
+	}
+	::close(fd);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline void DiskHashTable<T, keyType, hashFunction, pageSize>::loadDirectory(const std::string& meta)
+{
+	const char* p = meta.data();
+	const char* end = p + meta.size();
+	if (meta.size() < 28 || getU32(p) != magic || getU32(p + 4) != pageSize) {
+		::close(fd);
+		throw std::runtime_error("Hibas vagy mas lapmeretu konyvtar: " + path + ".dir");
+	}
+	globalDepth = getU32(p + 8);
+	nPages = getU32(p + 12);
+	count = (size_t)getU64(p + 16);
+	uint32_t nFree = getU32(p + 24);
+	p += 28;
+	size_t entries = (size_t)1 << globalDepth;
+	if (globalDepth > maxDepth || (size_t)(end - p) != 4 * ((size_t)nFree + entries)) {
+		::close(fd);
+		throw std::runtime_error("Serult konyvtar: " + path + ".dir");
+	}
+	for (uint32_t i = 0; i < nFree; ++i, p += 4)
+		freePages.push_back(getU32(p));
+	directory.resize(entries);
+	for (size_t i = 0; i < entries; ++i, p += 4)
+		directory[i] = getU32(p);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline void DiskHashTable<T, keyType, hashFunction, pageSize>::readPage(uint32_t id, char* buf)
+{
+	size_t done = 0;
+	while (done < pageSize) {
+		ssize_t n = ::pread(fd, buf + done, pageSize - done, (off_t)id * pageSize + (off_t)done);
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0) throw std::runtime_error("Sikertelen olvasas: " + path);
+		if (n == 0) {
+			// A fájl végén túli (még ki nem írt) lap üres
+			std::memset(buf + done, 0, pageSize - done);
+			break;
+		}
+		done += (size_t)n;
+	}
+	++nReads;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline void DiskHashTable<T, keyType, hashFunction, pageSize>::writePage(uint32_t id, const char* buf)
+{
+	size_t done = 0;
+	while (done < pageSize) {
+		ssize_t n = ::pwrite(fd, buf + done, pageSize - done, (off_t)id * pageSize + (off_t)done);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) throw std::runtime_error("Sikertelen iras: " + path);
+		done += (size_t)n;
+	}
+	++nWrites;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline char* DiskHashTable<T, keyType, hashFunction, pageSize>::page(uint32_t id, bool write, bool fresh)
+{
+	size_t* cached = resident.get((int)id);
+	if (cached != nullptr) {
+		++nHits;
+		Frame& f = frames[*cached];
+		f.ref = true;
+		f.dirty = f.dirty || write;
+		if (fresh) std::memset(f.data, 0, pageSize);
+		return f.data;
+	}
+	// Óra algoritmus: a mutató körbejár, és a hivatkozott lapoknak még egy esélyt ad
+	size_t victim;
+	for (;;) {
+		victim = hand;
+		hand = (hand + 1) % frames.size();
+		Frame& f = frames[victim];
+		if (f.id == noPage || !f.ref) break;
+		f.ref = false;
+	}
+	Frame& f = frames[victim];
+	if (f.id != noPage) {
+		if (f.dirty) writePage(f.id, f.data);
+		resident.remove((int)f.id);
+		f.id = noPage;
+	}
+	if (fresh) std::memset(f.data, 0, pageSize);
+	else readPage(id, f.data);
+	f.id = id;
+	f.dirty = write;
+	f.ref = true;
+	resident.put((int)id, victim);
+	return f.data;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline size_t DiskHashTable<T, keyType, hashFunction, pageSize>::find(const char* p, uint64_t h, const keyType& key)
+{
+	size_t off = headerSize;
+	size_t end = headerSize + used(p);
+	while (off < end) {
+		uint32_t len = getU32(p + off + 8);
+		if (getU64(p + off) == h) {
+			const char* q = p + off + recordHeader;
+			keyType k;
+			if (wal::decode(q, p + off + recordHeader + len, k) && k == key) return off;
+		}
+		off += recordHeader + len;
+	}
+	return 0;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline bool DiskHashTable<T, keyType, hashFunction, pageSize>::get(const keyType& key, T& value)
+{
+	uint64_t h = fullHash(key);
+	for (uint32_t id = headOf(h); id != noPage;) {
+		const char* p = page(id, false);
+		size_t off = find(p, h, key);
+		if (off != 0) {
+			const char* q = p + off + recordHeader;
+			const char* end = q + getU32(p + off + 8);
+			keyType k;
+			return wal::decode(q, end, k) && wal::decode(q, end, value);
+		}
+		id = overflow(p);
+	}
+	return false;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline bool DiskHashTable<T, keyType, hashFunction, pageSize>::contains(const keyType& key)
+{
+	uint64_t h = fullHash(key);
+	for (uint32_t id = headOf(h); id != noPage;) {
+		const char* p = page(id, false);
+		if (find(p, h, key) != 0) return true;
+		id = overflow(p);
+	}
+	return false;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline bool DiskHashTable<T, keyType, hashFunction, pageSize>::put(const keyType& key, const T& value)
+{
+	uint64_t h = fullHash(key);
+	std::string rec(recordHeader, '\0');
+	wal::encode(rec, key);
+	wal::encode(rec, value);
+	setU64(&rec[0], h);
+	setU32(&rec[8], (uint32_t)(rec.size() - recordHeader));
+	if (headerSize + rec.size() > pageSize) throw std::length_error("A rekord nem fer el egy lapon.");
+
+	for (;;) {
+		uint32_t head = headOf(h);
+		uint32_t room = noPage;
+		uint32_t last = head;
+		uint32_t depth = 0;
+		bool sameHash = true; // A lánc minden eleme h hash-ű-e
+		for (uint32_t id = head; id != noPage;) {
+			const char* p = page(id, false);
+			if (id == head) depth = localDepth(p);
+			if (find(p, h, key) != 0) return false;
+			if (room == noPage && headerSize + used(p) + rec.size() <= pageSize) room = id;
+			for (size_t off = headerSize; sameHash && off < headerSize + used(p); off += recordHeader + getU32(p + off + 8))
+				sameHash = getU64(p + off) == h;
+			last = id;
+			id = overflow(p);
+		}
+		if (room != noPage) {
+			append(page(room, true), rec);
+			++count;
+			return true;
+		}
+		if (!sameHash && depth < maxDepth) {
+			split(h);
+			continue;
+		}
+		// A kettéválasztás nem segítene: túlcsordulási lap
+		uint32_t fresh = allocPage();
+		setU32(page(last, true) + 12, fresh);
+		append(initPage(fresh, depth), rec);
+		++count;
+		return true;
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline void DiskHashTable<T, keyType, hashFunction, pageSize>::writeChain(uint32_t first, uint32_t depth, const std::vector<std::string>& recs)
+{
+	uint32_t cur = first;
+	initPage(cur, depth);
+	for (const std::string& rec : recs) {
+		char* p = page(cur, true);
+		if (headerSize + used(p) + rec.size() > pageSize) {
+			uint32_t next = allocPage();
+			setU32(p + 12, next);
+			cur = next;
+			p = initPage(cur, depth);
+		}
+		append(p, rec);
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline void DiskHashTable<T, keyType, hashFunction, pageSize>::split(uint64_t h)
+{
+	uint32_t head = headOf(h);
+	uint32_t depth = localDepth(page(head, false));
+	if (depth == globalDepth) {
+		size_t n = directory.size();
+		directory.resize(2 * n);
+		for (size_t i = 0; i < n; ++i)
+			directory[n + i] = directory[i];
+		++globalDepth;
+	}
+
+	// A lánc rekordjai a következő bit szerint két részre
+	std::vector<std::string> low, high;
+	for (uint32_t id = head; id != noPage;) {
+		const char* p = page(id, false);
+		for (size_t off = headerSize; off < headerSize + used(p);) {
+			size_t len = recordHeader + getU32(p + off + 8);
+			((getU64(p + off) >> depth) & 1 ? high : low).push_back(std::string(p + off, len));
+			off += len;
+		}
+		if (id != head) freePages.push_back(id);
+		id = overflow(p);
+	}
+	uint32_t other = allocPage();
+	writeChain(head, depth + 1, low);
+	writeChain(other, depth + 1, high);
+
+	size_t step = (size_t)1 << depth;
+	for (size_t i = (size_t)(h & (step - 1)); i < directory.size(); i += step)
+		directory[i] = ((i >> depth) & 1) ? other : head;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline bool DiskHashTable<T, keyType, hashFunction, pageSize>::remove(const keyType& key)
+{
+	uint64_t h = fullHash(key);
+	for (uint32_t id = headOf(h); id != noPage;) {
+		const char* p = page(id, false);
+		size_t off = find(p, h, key);
+		if (off != 0) {
+			char* w = page(id, true);
+			size_t len = recordHeader + getU32(w + off + 8);
+			size_t end = headerSize + used(w);
+			std::memmove(w + off, w + off + len, end - off - len);
+			setU32(w + 4, records(w) - 1);
+			setU32(w + 8, used(w) - (uint32_t)len);
+			--count;
+			return true;
+		}
+		id = overflow(p);
+	}
+	return false;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t pageSize>
+inline void DiskHashTable<T, keyType, hashFunction, pageSize>::flush()
+{
+	for (Frame& f : frames) {
+		if (f.id != noPage && f.dirty) {
+			writePage(f.id, f.data);
+			f.dirty = false;
+		}
+	}
+	if (::fdatasync(fd) != 0) throw std::runtime_error("Sikertelen fdatasync: " + path);
+
+	std::string meta;
+	wal::putU32(meta, magic);
+	wal::putU32(meta, (uint32_t)pageSize);
+	wal::putU32(meta, globalDepth);
+	wal::putU32(meta, nPages);
+	wal::putU32(meta, (uint32_t)count);
+	wal::putU32(meta, (uint32_t)((uint64_t)count >> 32));
+	wal::putU32(meta, (uint32_t)freePages.size());
+	for (uint32_t id : freePages) wal::putU32(meta, id);
+	for (uint32_t id : directory) wal::putU32(meta, id);
+
+	// Új fájlba ír, majd átnevezi, hogy a régi könyvtár ne sérüljön félbeszakadt írással
+	std::string tmp = path + ".dir.tmp";
+	int mfd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (mfd < 0) throw std::runtime_error("Nem nyithato meg: " + tmp);
+	try {
+		wal::writeAll(mfd, meta.data(), meta.size());
+	}
+	catch (std::exception&) {
+		::close(mfd);
+		throw;
+	}
+	::fdatasync(mfd);
+	::close(mfd);
+	if (::rename(tmp.c_str(), (path + ".dir").c_str()) != 0) throw std::runtime_error("Sikertelen atnevezes: " + tmp);
+}
+
+#endif // !DISKHASHTABLE_H
@@ -0,0 +1,627 @@
+﻿/*****************************************************************
+ * @file   durabletable.hpp
+ * @brief  DurableHashTable class: HashTable write-ahead loggal és pillanatképekkel, újraindítás után visszaállítható.
+ *         POSIX fájlkezelést használ (open, fdatasync, rename).
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef DURABLETABLE_H
+#define DURABLETABLE_H
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "hashtable.hpp"
+
+#include "memtrace.h"
+
+/**
+ * A log és a pillanatkép rekordjainak formátuma.
+ * Rekord: u32 hossz, u32 CRC-32 (a rekord törzsére), törzs: u8 művelet, kulcs, (PUT esetén) érték.
+ * A kulcsot és az értéket az encode / decode függvények írják. A std::string hossz-prefixelt,
+ * a triviálisan másolható típusok byte-onként kerülnek a fájlba. Más típusokhoz
+ * a wal névtérben kell encode / decode túlterhelést írni.
+ */
+namespace wal {
+	enum Op : uint8_t { PUT = 1, REMOVE = 2 };
+
+	/**
+	 * CRC-32 (IEEE), a sérült vagy félig kiírt rekordok felismeréséhez.
+	 */
+	inline uint32_t crc32(const char* data, size_t len) {
+		static const struct Table {
+			uint32_t t[256];
+			Table() {
+				for (uint32_t i = 0; i < 256; ++i) {
+					uint32_t c = i;
+					for (int k = 0; k < 8; ++k)
+						c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+					t[i] = c;
+				}
+			}
+		} table; // Szálbiztosan inicializálódik
+		uint32_t crc = 0xffffffffu;
+		for (size_t i = 0; i < len; ++i)
+			crc = table.t[(crc ^ (unsigned char)data[i]) & 0xff] ^ (crc >> 8);
+		return crc ^ 0xffffffffu;
+	}
+
+	inline void putU32(std::string& out, uint32_t v) {
+		for (int i = 0; i < 4; ++i)
+			out.push_back((char)((v >> (8 * i)) & 0xff));
+	}
+	inline uint32_t getU32(const char* p) {
+		return (uint32_t)(unsigned char)p[0] | ((uint32_t)(unsigned char)p[1] << 8) | ((uint32_t)(unsigned char)p[2] << 16) | ((uint32_t)(unsigned char)p[3] << 24);
+	}
+
+	template<typename T>
+	void encode(std::string& out, const T& v) {
+		static_assert(std::is_trivially_copyable<T>::value, "Ehhez a tipushoz wal::encode es wal::decode kell.");
+		out.append((const char*)&v, sizeof(T));
+	}
+	inline void encode(std::string& out, const std::string& v) {
+		putU32(out, (uint32_t)v.size());
+		out += v;
+	}
+
+	/**
+	 * Beolvas egy értéket, és továbblépteti p-t.
+	 * @return false, ha nincs elég byte
+	 */
+	template<typename T>
+	bool decode(const char*& p, const char* end, T& v) {
+		static_assert(std::is_trivially_copyable<T>::value, "Ehhez a tipushoz wal::encode es wal::decode kell.");
+		if ((size_t)(end - p) < sizeof(T)) return false;
+		std::memcpy(&v, p, sizeof(T));
+		p += sizeof(T);
+		return true;
+	}
+	inline bool decode(const char*& p, const char* end, std::string& v) {
+		if (end - p < 4) return false;
+		size_t n = getU32(p);
+		if ((size_t)(end - p - 4) < n) return false;
+		v.assign(p + 4, n);
+		p += 4 + n;
+		return true;
+	}
+
+	/**
+	 * Elkezd egy rekordot, a hosszt és a CRC-t a finish() írja be.
+	 * @return a rekord kezdete az out-ban
+	 */
+	inline size_t begin(std::string& out) {
+		size_t start = out.size();
+		putU32(out, 0);
+		putU32(out, 0);
+		return start;
+	}
+	inline void finish(std::string& out, size_t start) {
+		size_t body = out.size() - start - 8;
+		uint32_t crc = crc32(out.data() + start + 8, body);
+		for (int i = 0; i < 4; ++i) {
+			out[start + i] = (char)((body >> (8 * i)) & 0xff);
+			out[start + 4 + i] = (char)((crc >> (8 * i)) & 0xff);
+		}
+	}
+
+	/**
+	 * Hozzáfűzi a teljes puffert a fájlhoz.
+	 * @throw std::runtime_error írási hiba esetén
+	 */
+	inline void writeAll(int fd, const char* data, size_t len) {
+		while (len > 0) {
+			ssize_t n = ::write(fd, data, len);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) throw std::runtime_error("Sikertelen iras a logba.");
+			data += n;
+			len -= (size_t)n;
+		}
+	}
+
+	/**
+	 * Beolvassa az egész fájlt.
+	 * @return false, ha a fájl nem létezik
+	 */
+	inline bool readFile(const std::string& path, std::string& out) {
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+		char buf[64 * 1024];
+		ssize_t n;
+		while ((n = ::read(fd, buf, sizeof(buf))) != 0) {
+			if (n < 0 && errno == EINTR) continue;
+			if (n < 0) {
+				::close(fd);
+				throw std::runtime_error("Sikertelen olvasas: " + path);
+			}
+			out.append(buf, (size_t)n);
+		}
+		::close(fd);
+		return true;
+	}
+
+	/**
+	 * fsync-eli a könyvtárat, hogy a fájlok létrehozása, átnevezése is tartós legyen.
+	 */
+	inline void syncDir(const std::string& dir) {
+		int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+		if (fd < 0) return;
+		::fsync(fd);
+		::close(fd);
+	}
+}
+
+/**
+ * Mikor kerüljön a log ténylegesen a lemezre.
+ */
+enum class SyncPolicy {
+	EveryOp, //< Minden módosítás után fdatasync. A legbiztonságosabb, a leglassabb.
+	Batch, //< Csoportos commit: batchOps módosításonként (és commit()-kor) egy write és egy fdatasync.
+	None //< Csak write, az fsync-et az operációs rendszerre bízza. Gépösszeomláskor adat veszhet el, processz összeomláskor nem. (A compact() ilyenkor is fsync-eli a régi logot.)
+};
+
+/**
+ * Tartós Hash tábla.
+ * Minden módosítás (put, assign, remove) egy CRC-vel védett rekordként a write-ahead logba kerül.
+ * A könyvtárban snapshot.N és wal.N fájlok vannak: a snapshot.N a tábla állapota a wal.N kezdetekor.
+ * Induláskor a legújabb pillanatképet tölti be, majd sorban lejátssza a wal.N, wal.N+1, ... logokat.
+ * A félig kiírt (összeomláskor megszakadt) rekordot a CRC alapján felismeri, és ott megáll: a log többi részét
+ * levágja, a későbbi logokat törli, így a visszaállított állapot mindig a módosítások egy kezdőszelete.
+ * A könyvtár más nevű fájljait (pl. wal.x, snapshot.bak) figyelmen kívül hagyja.
+ * A compact() új logot kezd, és egy háttérszálon kiírja a hozzá tartozó pillanatképet,
+ * majd törli a régi fájlokat. A pillanatkép átnevezéssel, atomikusan jelenik meg.
+ * @tparam T A tárolt adat típusa
+ * @tparam keyType A kulcs típusa.
+ * @tparam hashFunction Hash függvény, ami a megadott kulcstípusból előállít egy indexet a hashtábla mérettartományán belül.
+ * @tparam defSize A belső tábla tömbmérete.
+ */
+template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash, size_t defSize = 100>
+class DurableHashTable {
+	HashTable<T, keyType, hashFunction, defSize> table; //< Az adatok
+	std::string dir; //< A log és a pillanatképek könyvtára
+	SyncPolicy policy; //< fsync szabály
+	size_t batchOps; //< Batch esetén ennyi módosítás kerül egy commitba
+	int logFd; //< A jelenlegi log
+	uint64_t generation; //< A jelenlegi log sorszáma
+	std::string pending; //< Még ki nem írt rekordok
+	size_t pendingOps; //< A pending-ben lévő rekordok száma
+	size_t logSize; //< A jelenlegi log mérete byte-ban
+	size_t compactBytes; //< Ekkora log után automatikusan tömörít, 0: soha
+	std::thread compactor; //< A pillanatképet író szál
+	std::atomic<bool> compacting; //< Fut-e a compactor
+	std::exception_ptr compactError; //< A compactor hibája, a következő compact() / waitForCompaction() dobja tovább
+
+	std::string path(const char* prefix, uint64_t gen) const {
+		return dir + "/" + prefix + "." + std::to_string(gen);
+	}
+
+	/**
+	 * Kiolvassa a sorszámot egy prefix.N alakú fájlnévből.
+	 * @param name a fájl neve
+	 * @param prefix pl. "wal." vagy "snapshot."
+	 * @param gen ide kerül a sorszám
+	 * @return prefix.N alakú-e a név (N csak számjegyekből áll), a könyvtár más fájljait ki kell hagyni
+	 */
+	static bool generationOf(const std::string& name, const char* prefix, uint64_t& gen) {
+		size_t n = std::strlen(prefix);
+		if (name.size() <= n || name.size() > n + 19 || name.compare(0, n, prefix) != 0) return false;
+		gen = 0;
+		for (size_t i = n; i < name.size(); ++i) {
+			if (name[i] < '0' || name[i] > '9') return false;
+			gen = gen * 10 + (uint64_t)(name[i] - '0');
+		}
+		return true;
+	}
+
+	/**
+	 * Rekordot ír a pending végére.
+	 */
+	void record(wal::Op op, const keyType& key, const T* value);
+
+	/**
+	 * Alkalmaz egy rekordot a táblára (visszaállításkor).
+	 * @return false, ha a rekord hibás
+	 */
+	bool apply(const char* body, size_t len);
+
+	/**
+	 * Lejátssza a fájl rekordjait.
+	 * @return az utolsó ép rekord vége
+	 */
+	size_t replay(const std::string& data);
+
+	/**
+	 * Visszaállítja a táblát a könyvtár fájljaiból, és megnyitja a logot.
+	 */
+	void recover();
+
+	/**
+	 * Kiírja a pending rekordokat, és a szabály szerint fdatasync-el.
+	 */
+	void flush(bool sync);
+
+	/**
+	 * Módosítás után: commit, ha a szabály szerint kell, és tömörítés, ha a log túl nagy.
+	 */
+	void afterWrite();
+
+	/**
+	 * A háttérszál: kiírja a pillanatképet, és törli a régi fájlokat.
+	 */
+	static void writeSnapshot(std::string dir, uint64_t gen, std::string data, std::atomic<bool>* running, std::exception_ptr* error);
+
+	DurableHashTable(const DurableHashTable&); //< Másoló konstruktor tiltása
+	DurableHashTable& operator=(const DurableHashTable&); //< Értékadás tiltása
+public:
+	/**
+	 * Megnyitja (ha kell, létrehozza) a könyvtárat, és visszaállítja a táblát.
+	 * @param dir a log és a pillanatképek könyvtára
+	 * @param policy fsync szabály
+	 * @param batchOps Batch szabály esetén ennyi módosításonként commitol, legalább 1
+	 * @throw std::runtime_error ha a könyvtár vagy a fájlok nem nyithatók meg, vagy a pillanatkép sérült
+	 */
+	explicit DurableHashTable(const std::string& dir, SyncPolicy policy = SyncPolicy::Batch, size_t batchOps = 64);
+
+	/**
+	 * Berak egy elemet, ha a kulcs még nincs benne (mint a HashTable::put).
+	 * @return true, ha új elem volt
+	 */
+	bool put(keyType key, const T& value);
+
+	/**
+	 * Berak egy elemet, a meglévőt felülírja.
+	 */
+	void assign(keyType key, const T& value);
+
+	/**
+	 * Kitörli az elemet, ha benne van.
+	 */
+	void remove(keyType key);
+
+	/**
+	 * @return az elemre mutató pointer, vagy nullptr. A módosítás csak put / assign / remove útján tartós.
+	 */
+	const T* get(keyType key) {
+		return table.get(key);
+	}
+
+	/**
+	 * @return benne van-e a kulcs
+	 */
+	bool contains(keyType key) {
+		return table.contains(key);
+	}
+
+	/**
+	 * @return az elemek száma
+	 */
+	size_t size() const {
+		return table.size();
+	}
+
+	/**
+	 * A függő módosításokat kiírja és (a None szabályt kivéve) lemezre kényszeríti.
+	 */
+	void commit() {
+		flush(policy != SyncPolicy::None);
+	}
+
+	/**
+	 * Új logot kezd, és a háttérben pillanatképet ír a tábláról. Az előző tömörítést megvárja.
+	 * A régi logot a szabálytól függetlenül lemezre kényszeríti, mielőtt az új elkezdődik.
+	 * @throw std::runtime_error ha az előző háttérbeli tömörítés sikertelen volt
+	 */
+	void compact();
+
+	/**
+	 * Megvárja a futó tömörítést.
+	 * @throw std::runtime_error ha a tömörítés sikertelen volt
+	 */
+	void waitForCompaction();
+
+	/**
+	 * Beállítja, mekkora log után induljon automatikusan tömörítés.
+	 * @param bytes a log mérete byte-ban, 0: nincs automatikus tömörítés
+	 */
+	void setCompactionThreshold(size_t bytes) {
+		compactBytes = bytes;
+	}
+
+	/**
+	 * @return a jelenlegi log mérete byte-ban (a még ki nem írt rekordokkal együtt)
+	 */
+	size_t logBytes() const {
+		return logSize + pending.size();
+	}
+
+	/**
+	 * Commitol, és megvárja a tömörítést.
+	 */
+	~DurableHashTable();
+};
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline DurableHashTable<T, keyType, hashFunction, defSize>::DurableHashTable(const std::string& dir, SyncPolicy policy, size_t batchOps)
+	:dir(dir), policy(policy), batchOps(batchOps == 0 ? 1 : batchOps), logFd(-1), generation(0), pendingOps(0), logSize(0), compactBytes(0), compacting(false)
+{
+	if (::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+		throw std::runtime_error("A konyvtar nem hozhato letre: " + dir);
+	recover();
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline void DurableHashTable<T, keyType, hashFunction, defSize>::record(wal::Op op, const keyType& key, const T* value)
+{
+	size_t s = wal::begin(pending);
+	pending.push_back((char)op);
+	wal::encode(pending, key);
+	if (value != nullptr)
+		wal::encode(pending, *value);
+	wal::finish(pending, s);
+	++pendingOps;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline bool DurableHashTable<T, keyType, hashFunction, defSize>::apply(const char* body, size_t len)
+{
+	const char* p = body;
+	const char* end = body + len;
+	if (p == end) return false;
+	uint8_t op = (uint8_t)*p++;
+	keyType key;
+	if (!wal::decode(p, end, key)) return false;
+	if (op == wal::PUT) {
+		T value;
+		if (!wal::decode(p, end, value) || p != end) return false;
+		table.find_or_insert(key).first->value = value;
+		return true;
+	}
+	if (op == wal::REMOVE && p == end) {
+		table.remove(key);
+		return true;
+	}
+	return false;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline size_t DurableHashTable<T, keyType, hashFunction, defSize>::replay(const std::string& data)
+{
+	size_t pos = 0;
+	while (data.size() - pos >= 8) {
+		size_t body = wal::getU32(data.data() + pos);
+		uint32_t crc = wal::getU32(data.data() + pos + 4);
+		if (data.size() - pos - 8 < body) break; // Félig kiírt rekord
+		const char* b = data.data() + pos + 8;
+		if (wal::crc32(b, body) != crc || !apply(b, body)) break;
+		pos += 8 + body;
+	}
+	return pos;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline void DurableHashTable<T, keyType, hashFunction, defSize>::recover()
+{
+	// A legújabb pillanatkép, és a régebbi / félbemaradt fájlok összegyűjtése
+	std::vector<std::string> names;
+	DIR* d = ::opendir(dir.c_str());
+	if (d == nullptr) throw std::runtime_error("A konyvtar nem nyithato meg: " + dir);
+	while (dirent* e = ::readdir(d))
+		names.push_back(e->d_name);
+	::closedir(d);
+
+	bool haveSnapshot = false;
+	uint64_t snap = 0;
+	uint64_t g;
+	for (const std::string& n : names) {
+		if (generationOf(n, "snapshot.", g)) {
+			if (!haveSnapshot || g > snap) snap = g;
+			haveSnapshot = true;
+		}
+	}
+	if (!haveSnapshot) {
+		// Pillanatkép még nem készült: a legrégebbi log a kiindulás
+		bool haveLog = false;
+		for (const std::string& n : names) {
+			if (generationOf(n, "wal.", g)) {
+				if (!haveLog || g < snap) snap = g;
+				haveLog = true;
+			}
+		}
+	}
+	else {
+		std::string data;
+		wal::readFile(path("snapshot", snap), data);
+		if (replay(data) != data.size())
+			throw std::runtime_error("Serult pillanatkep: " + path("snapshot", snap));
+	}
+
+	// A logok lejátszása sorban. Az első hibás rekordnál megáll: ami utána van (a log többi része
+	// és a későbbi logok), az egy soha nem létezett állapotot adna, azt levágja, illetve törli.
+	generation = snap;
+	size_t validEnd = 0;
+	for (g = snap;; ++g) {
+		std::string data;
+		if (!wal::readFile(path("wal", g), data)) break;
+		generation = g;
+		validEnd = replay(data);
+		if (validEnd != data.size()) break;
+	}
+	for (const std::string& n : names) {
+		if (generationOf(n, "wal.", g) && g > generation)
+			::unlink((dir + "/" + n).c_str());
+	}
+
+	logFd = ::open(path("wal", generation).c_str(), O_WRONLY | O_CREAT, 0644);
+	if (logFd < 0) throw std::runtime_error("A log nem nyithato meg: " + path("wal", generation));
+	if (::ftruncate(logFd, (off_t)validEnd) != 0 || ::lseek(logFd, 0, SEEK_END) < 0)
+		throw std::runtime_error("A log nem vaghato le: " + path("wal", generation));
+	logSize = validEnd;
+	wal::syncDir(dir);
+
+	// Ami a pillanatképnél régebbi, vagy félbemaradt pillanatkép, az törölhető
+	for (const std::string& n : names) {
+		bool old = false;
+		if (generationOf(n, "snapshot.", g) || generationOf(n, "wal.", g))
+			old = g < snap;
+		else if (n.size() > 4 && n.compare(n.size() - 4, 4, ".tmp") == 0)
+			old = generationOf(n.substr(0, n.size() - 4), "snapshot.", g);
+		if (old) ::unlink((dir + "/" + n).c_str());
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline void DurableHashTable<T, keyType, hashFunction, defSize>::flush(bool sync)
+{
+	if (!pending.empty()) {
+		wal::writeAll(logFd, pending.data(), pending.size());
+		logSize += pending.size();
+		pending.clear();
+	}
+	pendingOps = 0;
+	if (sync && ::fdatasync(logFd) != 0)
+		throw std::runtime_error("Sikertelen fdatasync a logon.");
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline void DurableHashTable<T, keyType, hashFunction, defSize>::afterWrite()
+{
+	switch (policy) {
+	case SyncPolicy::EveryOp:
+		flush(true);
+		break;
+	case SyncPolicy::Batch:
+		if (pendingOps >= batchOps) flush(true);
+		break;
+	case SyncPolicy::None:
+		if (pending.size() >= 64 * 1024) flush(false);
+		break;
+	}
+	if (compactBytes != 0 && logBytes() >= compactBytes && !compacting)
+		compact();
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline bool DurableHashTable<T, keyType, hashFunction, defSize>::put(keyType key, const T& value)
+{
+	if (!table.put(key, value)) return false;
+	record(wal::PUT, key, &value);
+	afterWrite();
+	return true;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline void DurableHashTable<T, keyType, hashFunction, defSize>::assign(keyType key, const T& value)
+{
+	table.find_or_insert(key).first->value = value;
+	record(wal::PUT, key, &value);
+	afterWrite();
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline void DurableHashTable<T, keyType, hashFunction, defSize>::remove(keyType key)
+{
+	if (!table.remove(key)) return;
+	record(wal::REMOVE, key, nullptr);
+	afterWrite();
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline void DurableHashTable<T, keyType, hashFunction, defSize>::writeSnapshot(std::string dir, uint64_t gen, std::string data, std::atomic<bool>* running, std::exception_ptr* error)
+{
+	try {
+		std::string name = dir + "/snapshot." + std::to_string(gen);
+		int fd = ::open((name + ".tmp").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) throw std::runtime_error("A pillanatkep nem hozhato letre: " + name);
+		try {
+			wal::writeAll(fd, data.data(), data.size());
+			if (::fsync(fd) != 0) throw std::runtime_error("Sikertelen fsync: " + name);
+		}
+		catch (...) {
+			::close(fd);
+			throw;
+		}
+		::close(fd);
+		if (::rename((name + ".tmp").c_str(), name.c_str()) != 0)
+			throw std::runtime_error("A pillanatkep nem nevezheto at: " + name);
+		wal::syncDir(dir);
+		// Az új pillanatkép tartós, a régi fájlok már nem kellenek
+		for (uint64_t g = gen; g-- > 0;) {
+			bool any = ::unlink((dir + "/wal." + std::to_string(g)).c_str()) == 0;
+			any = ::unlink((dir + "/snapshot." + std::to_string(g)).c_str()) == 0 || any;
+			if (!any) break;
+		}
+	}
+	catch (...) {
+		*error = std::current_exception();
+	}
+	*running = false;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline void DurableHashTable<T, keyType, hashFunction, defSize>::compact()
+{
+	waitForCompaction();
+	// A régi logot a None szabálynál is lemezre kényszeríti, mielőtt az új elkezdődik:
+	// különben összeomláskor az új log megmaradhatna a régi vége nélkül
+	flush(true);
+
+	// A tábla sorosítása az előtérben történik (csak memória), a lassú írás és fsync a háttérben
+	std::string data;
+	for (auto iter = table.begin(); iter != table.end(); ++iter) {
+		size_t s = wal::begin(data);
+		data.push_back((char)wal::PUT);
+		wal::encode(data, iter->key);
+		wal::encode(data, iter->value);
+		wal::finish(data, s);
+	}
+
+	int fd = ::open(path("wal", generation + 1).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) throw std::runtime_error("Az uj log nem hozhato letre.");
+	::close(logFd);
+	logFd = fd;
+	++generation;
+	logSize = 0;
+	wal::syncDir(dir);
+
+	compacting = true;
+	compactor = std::thread(writeSnapshot, dir, generation, std::move(data), &compacting, &compactError);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline void DurableHashTable<T, keyType, hashFunction, defSize>::waitForCompaction()
+{
+	if (compactor.joinable())
+		compactor.join();
+	if (compactError) {
+		std::exception_ptr e = compactError;
+		compactError = nullptr;
+		std::rethrow_exception(e);
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
+inline DurableHashTable<T, keyType, hashFunction, defSize>::~DurableHashTable()
+{
+	try {
+		commit();
+	}
+	catch (...) {}
+	if (compactor.joinable())
+		compactor.join();
+	if (logFd >= 0)
+		::close(logFd);
+}
+
+#endif // !DURABLETABLE_H
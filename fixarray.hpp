@@ -10,35 +10,95 @@
 #ifndef FIXARRAY_H
 #define FIXARRAY_H
 #include <exception>
+#include <stdexcept>
+#include <memory>
+#include <type_traits>
 #include "memtrace.h"
 
+/**
+ * Létrehoz egy objektumot a megadott, már lefoglalt címen.
+ * Ha a típus allokátort használ (pl. LinkedList), megkapja az allokátort is, így a belső foglalásai is abból történnek.
+ * A placement new helyett a std::allocator construct-ját hívja, mert a memtrace átdefiniálja a new-t.
+ * @param p a lefoglalt, inicializálatlan terület
+ * @param alloc az allokátor
+ */
+template <typename T, typename Alloc>
+void constructWithAllocator(T* p, const Alloc& alloc) {
+	std::allocator<T> plain;
+	if constexpr (std::uses_allocator<T, Alloc>::value)
+		std::allocator_traits<std::allocator<T>>::construct(plain, p, alloc);
+	else
+		std::allocator_traits<std::allocator<T>>::construct(plain, p);
+}
+
 /**
  * Generikus fix méretú tömb.
  * @tparam T a tárolt típus.
  * @tparam N a tömb mérete
+ * @tparam Alloc az elemek foglalásához használt allokátor (default: std::allocator<T>)
  */
-template <typename T, size_t N>
+template <typename T, size_t N, typename Alloc = std::allocator<T>>
 class FixArray
 {
+	typedef std::allocator_traits<Alloc> traits;
+	Alloc alloc; //< Az elemek allokátora
 	T* data; //< A tárolt adatok tömbje
+
+	/**
+	 * Lefoglalja és létrehozza az N elemet.
+	 */
+	void allocate() {
+		data = traits::allocate(alloc, N);
+		for (size_t i = 0; i < N; i++) {
+			constructWithAllocator(data + i, alloc);
+		}
+	}
+	/**
+	 * Megszünteti és felszabadítja az N elemet.
+	 */
+	void deallocate() {
+		if (data == nullptr) return; // Áthelyezett tömb
+		for (size_t i = 0; i < N; i++) {
+			traits::destroy(alloc, data + i);
+		}
+		traits::deallocate(alloc, data, N);
+	}
 public:
+	typedef Alloc allocator_type;
+
 	/**
 	 * Default konstruktor.
+	 * @param alloc az elemek foglalásához használt allokátor
 	 */
-	FixArray() {
-		data = new T[N];
+	FixArray(const Alloc& alloc = Alloc()) :alloc(alloc) {
+		allocate();
 	};
 	/**
 	 * Másoló konstruktor
 	 */
-	FixArray(const FixArray& fa) {
-		data = new T[N];
+	FixArray(const FixArray& fa) :alloc(traits::select_on_container_copy_construction(fa.alloc)) {
+		allocate();
 		for (size_t i = 0; i < N; i++) {
 			data[i] = fa.data[i];
 		}
 	}
+	/**
+	 * Áthelyező konstruktor. Az elemek helyben maradnak, csak a tömb gazdája változik,
+	 * így az elemekre mutató pointerek érvényesek maradnak.
+	 */
+	FixArray(FixArray&& fa) :alloc(fa.alloc), data(fa.data) {
+		fa.data = nullptr;
+	}
 	FixArray& operator=(const FixArray& rhs) {
 		if (this == &rhs) return *this;
+		if constexpr (traits::propagate_on_container_copy_assignment::value) {
+			// Ha az allokátor is átkerül, akkor az új allokátorral kell újra foglalni
+			if (alloc != rhs.alloc) {
+				deallocate();
+				alloc = rhs.alloc;
+				allocate();
+			}
+		}
 		for (size_t i = 0; i < N; i++) {
 			data[i] = rhs.data[i]; 
 		}
@@ -61,8 +121,14 @@ public:
 	size_t size() const {
 		return N;
 	}
+	/**
+	 * @return a használt allokátor másolata
+	 */
+	Alloc get_allocator() const {
+		return alloc;
+	}
 	~FixArray() {
-		delete[] data;
+		deallocate();
 	}
 };
 
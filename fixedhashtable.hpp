@@ -0,0 +1,257 @@
+﻿/*****************************************************************
+ * @file   fixedhashtable.hpp
+ * @brief  FixedHashTable class: fix kapacitású, nyílt címzéses hash tábla, ami semmit nem foglal a heapen.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef FIXEDHASHTABLE_H
+#define FIXEDHASHTABLE_H
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include "hashtable.hpp"
+
+#include "memtrace.h"
+
+/**
+ * Fix kapacitású hash tábla, minden helye magában az objektumban van (mint egy FixArray, de a belső new nélkül),
+ * így lehet veremben vagy más objektum tagjaként, és egyetlen művelete sem foglal memóriát
+ * (feltéve, hogy a kulcs és az érték másolása sem foglal, pl. int, pointer, rövid std::string).
+ * Nyílt címzés lineáris próbálással: egy kulcs a hash-e szerinti helyen, vagy az utána következő első szabad helyen van.
+ * Törléskor a mögötte lévő elemek visszacsúsznak (backward shift), így nincs sírkő, és a keresés az első üres helynél megáll.
+ * Soha nem hashel újra: ha tele van, a put ezt a PutResult::Full eredménnyel jelzi (kivétel nélkül, mert annak a dobása is foglal).
+ * A próbálási láncok a telítettséggel gyorsan nőnek, ezért a kapacitás legyen kb. a várható elemszám 1,3-szorosa.
+ * @tparam T A tárolt adat típusa
+ * @tparam keyType A kulcs típusa.
+ * @tparam hashFunction Hash függvény, H(kulcs) % maxSize alakú: a tábla maxSize = SIZE_MAX-szal hívja,
+ *         és a teljes értéket keveri tovább, hogy a gyenge hash-ek se okozzanak hosszú próbálási láncokat.
+ * @tparam Capacity A tárolható elemek maximális száma
+ */
+template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash, size_t Capacity = 16>
+class FixedHashTable {
+	static_assert(Capacity > 0, "Legalabb egy hely kell.");
+
+	/**
+	 * Egy foglalt hely tartalma.
+	 */
+	struct Entry {
+		keyType key; //< Az elemhez tartozó kulcs
+		T value; //< A tárolt elem
+		Entry(const keyType& key, const T& value) :key(key), value(value) {};
+	};
+
+	/**
+	 * Egy hely: inicializálatlan tárterület, csak a foglalt helyeken él benne Entry.
+	 */
+	struct Slot {
+		alignas(Entry) unsigned char storage[sizeof(Entry)];
+		Entry& entry() { return *reinterpret_cast<Entry*>(storage); }
+		const Entry& entry() const { return *reinterpret_cast<const Entry*>(storage); }
+	};
+
+	Slot slots[Capacity]; //< A helyek
+	bool used[Capacity]; //< Foglalt-e a hely
+	size_t count; //< Az elemek száma
+
+	/**
+	 * @return a kulcs kezdő helye
+	 */
+	static size_t home(const keyType& key) {
+		uint64_t h = (uint64_t)hashFunction(key, SIZE_MAX);
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return (size_t)(h % Capacity);
+	}
+
+	static size_t next(size_t i) {
+		return i + 1 == Capacity ? 0 : i + 1;
+	}
+
+	/**
+	 * @return a kulcs helye, vagy Capacity, ha nincs benne
+	 */
+	size_t find(const keyType& key) const;
+
+	/**
+	 * Létrehoz egy elemet a megadott helyen.
+	 * A placement new helyett a std::allocator construct-ját hívja, mert a memtrace átdefiniálja a new-t.
+	 */
+	template<typename... Args>
+	void construct(size_t i, Args&&... args) {
+		std::allocator<Entry> plain;
+		std::allocator_traits<std::allocator<Entry>>::construct(plain, &slots[i].entry(), std::forward<Args>(args)...);
+		used[i] = true;
+	}
+
+	void destroy(size_t i) {
+		slots[i].entry().~Entry();
+		used[i] = false;
+	}
+
+	FixedHashTable(const FixedHashTable&); //< Másoló konstruktor tiltása
+	FixedHashTable& operator=(const FixedHashTable&); //< Értékadás tiltása
+public:
+	/**
+	 * A put eredménye.
+	 */
+	enum class PutResult {
+		Inserted, //< Új elem került be
+		Exists, //< A kulcs már benne volt, az értéke nem változott
+		Full //< A tábla tele van, az elem nem került be
+	};
+
+	/**
+	 * Default konstruktor: üres tábla.
+	 */
+	FixedHashTable() :count(0) {
+		for (size_t i = 0; i < Capacity; ++i) used[i] = false;
+	}
+
+	/**
+	 * Berakja a megadott elemet, ha a kulcs még nincs benne, és van hely.
+	 * @param key az elemhez tartozó kulcs
+	 * @param value Tárolandó elem
+	 * @return PutResult::Inserted, PutResult::Exists, vagy PutResult::Full
+	 */
+	PutResult put(keyType key, const T& value);
+
+	/**
+	 * @param key Az elemhez tartozó kulcs.
+	 * @return Visszaadja a kulcshoz tartozó adatra mutató pointert, ha nem találja nullptr-t.
+	 *         A pointer a következő remove-ig érvényes (a törlés elemeket mozgathat).
+	 */
+	T* get(keyType key);
+
+	/**
+	 * @param key Az elemhez tartozó kulcs.
+	 * @return benne van-e a kulcs a táblában
+	 */
+	bool contains(keyType key) const {
+		return find(key) != Capacity;
+	}
+
+	/**
+	 * Kitörli a kulcs által jelölt elemet, és visszacsúsztatja a mögötte lévőket.
+	 * @param key Az elemhez tartozó kulcs.
+	 * @return benne volt-e
+	 */
+	bool remove(keyType key);
+
+	/**
+	 * Kitöröl minden elemet.
+	 */
+	void clear();
+
+	/**
+	 * Meghívja az f(key, value) függvényt minden elemre, a helyek sorrendjében.
+	 * @param f f(const keyType&, T&)
+	 */
+	template<typename F>
+	void forEach(F f);
+
+	/**
+	 * @return Visszaadja a jelenlegi elemszámot
+	 */
+	size_t size() const {
+		return count;
+	}
+
+	/**
+	 * @return a tárolható elemek maximális száma
+	 */
+	static constexpr size_t capacity() {
+		return Capacity;
+	}
+
+	/**
+	 * @return tele van-e a tábla
+	 */
+	bool full() const {
+		return count == Capacity;
+	}
+
+	/**
+	 * Destruktor. Megszünteti a tárolt elemeket.
+	 */
+	~FixedHashTable() {
+		clear();
+	}
+};
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t Capacity>
+inline size_t FixedHashTable<T, keyType, hashFunction, Capacity>::find(const keyType& key) const
+{
+	size_t i = home(key);
+	for (size_t n = 0; n < Capacity && used[i]; ++n, i = next(i)) {
+		if (slots[i].entry().key == key)
+			return i;
+	}
+	return Capacity;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t Capacity>
+inline typename FixedHashTable<T, keyType, hashFunction, Capacity>::PutResult FixedHashTable<T, keyType, hashFunction, Capacity>::put(keyType key, const T& value)
+{
+	size_t i = home(key);
+	for (size_t n = 0; n < Capacity; ++n, i = next(i)) {
+		if (!used[i]) {
+			construct(i, key, value);
+			++count;
+			return PutResult::Inserted;
+		}
+		if (slots[i].entry().key == key)
+			return PutResult::Exists;
+	}
+	return PutResult::Full;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t Capacity>
+inline T* FixedHashTable<T, keyType, hashFunction, Capacity>::get(keyType key)
+{
+	size_t i = find(key);
+	return i == Capacity ? nullptr : &slots[i].entry().value;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t Capacity>
+inline bool FixedHashTable<T, keyType, hashFunction, Capacity>::remove(keyType key)
+{
+	size_t hole = find(key);
+	if (hole == Capacity) return false;
+	destroy(hole);
+	--count;
+	// Backward shift: a lánc további elemei közül azt, aminek a kezdő helye nem a (hole, j] tartományban van, a lyukba húzzuk
+	for (size_t j = next(hole); used[j]; j = next(j)) {
+		size_t h = home(slots[j].entry().key);
+		bool stays = hole < j ? (h > hole && h <= j) : (h > hole || h <= j);
+		if (!stays) {
+			construct(hole, std::move(slots[j].entry()));
+			destroy(j);
+			hole = j;
+		}
+	}
+	return true;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t Capacity>
+inline void FixedHashTable<T, keyType, hashFunction, Capacity>::clear()
+{
+	for (size_t i = 0; i < Capacity; ++i)
+		if (used[i]) destroy(i);
+	count = 0;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t Capacity>
+template<typename F>
+inline void FixedHashTable<T, keyType, hashFunction, Capacity>::forEach(F f)
+{
+	for (size_t i = 0; i < Capacity; ++i)
+		if (used[i]) f((const keyType&)slots[i].entry().key, slots[i].entry().value);
+}
+
+#endif // !FIXEDHASHTABLE_H
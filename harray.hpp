@@ -12,10 +12,39 @@
 #include <string>
 #include "fixarray.hpp"
 #include "linkedlist.hpp"
+#include "unrolledlist.hpp"
+#include "buckets.hpp"
 #include <exception>
+#include <stdexcept>
+#include <memory>
 
 #include "memtrace.h"
 
+/**
+ * Érték nélküli tárolás jele (pl. HashSet). Ilyenkor a HashItem csak a kulcsot tárolja.
+ */
+struct NoValue {};
+
+/**
+ * A HashItem értéke. Külön ősosztályban van, hogy NoValue esetén üres legyen, és ne foglaljon helyet.
+ * @tparam T a tárolt érték típusa
+ */
+template <typename T>
+struct HashValue {
+	T value; //< A tárolt elem
+	HashValue() :value(T()) {};
+	HashValue(const T& value) :value(value) {};
+};
+
+/**
+ * Érték nélküli HashItem ősosztálya: üres.
+ */
+template <>
+struct HashValue<NoValue> {
+	HashValue() {};
+	HashValue(const NoValue&) {};
+};
+
 
 /**
  * Gernerikus Hash Array 
@@ -23,33 +52,36 @@
  * @param T - Tárolt elemek típusa
  * @param keyType - Kulcs típusa. (default: std::string)
  * @param defSize - A tárolt tömbök alapártelmezett mérete. (default: 10)
+ * @param Alloc - Allokátor, ebből foglalódnak a tömbök és a listaelemek is. (default: std::allocator<T>)
+ * @param Layout - A láncolt listák elrendezése: SegmentedLayout vagy FlatLayout. (default: SegmentedLayout)
+ * @param Chain - A láncolt listák fajtája: LinkedChain vagy UnrolledChain. (default: LinkedChain)
  */
-template <typename T, typename keyType = std::string, size_t defSize = 10>
+template <typename T, typename keyType = std::string, size_t defSize = 10, typename Alloc = std::allocator<T>, typename Layout = SegmentedLayout, typename Chain = LinkedChain>
 class HArray {
 public:
+	typedef Alloc allocator_type;
 
 	/**
 	 * HashItem-ek vannak tárolva a Láncolt listákban.
 	 */
-	struct HashItem {
+	struct HashItem : public HashValue<T> { // A value az ősosztályban van
 		keyType key; //< Az elemhez tartozó kulcs
-		T value; //< A tárolt elem
 		/**
 		 * Default konstruktor.
 		 */
-		HashItem():key(keyType()),value(T()) {};
+		HashItem():HashValue<T>(),key(keyType()) {};
 		/**
 		 * Konstruktor egy kulcsból és értékből.
 		 * @param key a megadott kulcs
 		 * @param a kulcshoz tartozó elem
 		 */
-		HashItem(keyType key, T value) :key(key), value(value) {};
+		HashItem(keyType key, T value) :HashValue<T>(value), key(key) {};
 
 		/** 
 		 * Kulcs alapú keresésre használt konstruktor
 		 * @param key a kulcs.
 		 */
-		HashItem(keyType key) :key(key),value(T()) {};
+		HashItem(keyType key) :HashValue<T>(),key(key) {};
 
 		/**
 		 * Kulcsalapú egyenlőség 
@@ -82,16 +114,30 @@ public:
 
 	};
 
+private:
+	typedef typename Chain::template list<HashItem, typename std::allocator_traits<Alloc>::template rebind_alloc<HashItem>> llist; //= LinkedList<HashItem>
+public:
+	/**
+	 * Egy elem helye a láncában (ld. LinkedList::position), ezzel keresés nélkül törölhető.
+	 */
+	typedef typename llist::position position;
+
 	/**
 	 * Konstruktor, ami megadott számú tömbbel hozza létre a HArray-t
 	 * @param nArrays ennyi tömböt foglal
+	 * @param alloc a foglalásokhoz használt allokátor
 	 */
-	HArray(size_t nArrays);
+	HArray(size_t nArrays, const Alloc& alloc = Alloc());
 
 	/**
 	 * Default konstruktor.
 	 */
 	HArray();
+
+	/**
+	 * @return a használt allokátor másolata
+	 */
+	Alloc get_allocator() const;
 	/**
 	 * @return Visszaadja a jelenlegi elemszámot
 	 */
@@ -108,15 +154,35 @@ public:
 	 * @param i A láncolt lista indexe
 	 * @param key Az elemhez tartozó kulcs
 	 * @param value A tárolandó elem
+	 * @return true, ha új elem került be, false, ha már benne volt
 	 */
-	void add(size_t i, keyType key, const T& value); 
+	bool add(size_t i, keyType key, const T& value); 
+
+	/**
+	 * Hozzáadja az elemet a megadott indexű láncolt listához, ha még nincs benne.
+	 * @param i A láncolt lista indexe
+	 * @param item A tárolandó elem a kulcsával együtt
+	 * @return true, ha új elem került be, false, ha már benne volt
+	 */
+	bool add(size_t i, const HashItem& item);
 
 	/**
 	 * Kitörli a megadott indexű láncolt listából az adott kulcsú elemet.
 	 * @param i A láncolt lista indexe
 	 * @param key A törlendő elemhez tartozó kulcs.
+	 * @return benne volt-e
 	 */
-	void remove(size_t i, keyType key);		
+	bool remove(size_t i, keyType key);		
+
+	/**
+	 * Kitörli a megadott indexű láncolt listából az adott kulcsú elemet, és kiadja az értékét.
+	 * A láncot csak egyszer járja be: a megtalált elemet a helye alapján, újabb keresés nélkül törli.
+	 * @param i A láncolt lista indexe
+	 * @param key A törlendő elemhez tartozó kulcs.
+	 * @param removed ide kerül a törölt elem értéke, ha benne volt
+	 * @return benne volt-e
+	 */
+	bool remove(size_t i, keyType key, T& removed);
 
 	/**
 	 * @param i a láncolt lista indexe
@@ -125,16 +191,85 @@ public:
 	 */
 	T* get(size_t i, keyType key); 
 
+	/**
+	 * @param i a láncolt lista indexe
+	 * @param key a keresendő elemhez tartozó kulcs.
+	 * @return benne van-e az elem a láncolt listában
+	 */
+	bool contains(size_t i, keyType key);
+
+	/**
+	 * @param i a láncolt lista indexe
+	 * @return a láncolt lista hossza
+	 */
+	size_t chainLength(size_t i);
+
+	/**
+	 * Egy vödör szétválasztása: a from vödör azon elemeit, amikre a moves igaz, átrakja a to vödörbe.
+	 * Egyszer megy végig a from láncán, és LinkedChain esetén másolás és foglalás nélkül átláncolja az elemeket.
+	 * A többi elem helyben marad. Az elemszám nem változik.
+	 * @param moves a kulcsot kapja, és megmondja, hogy az elemnek át kell-e költöznie
+	 * @return az átrakott elemek száma
+	 */
+	template<typename F>
+	size_t splitBucket(size_t from, size_t to, F moves);
+
+	/**
+	 * @return a láncolt listák (vödrök) száma
+	 */
+	size_t buckets() const {
+		return nArrays * defSize;
+	}
+
+	/**
+	 * Végigmegy a [first, last) vödrök elemein. Az üres vödröket a lánc bejárása nélkül átugorja.
+	 * Különböző tartományokra több szálból is hívható, ha közben senki nem módosítja a tárolót.
+	 * @param f f(HashItem&) minden elemre
+	 */
+	template<typename F>
+	void forEachInRange(size_t first, size_t last, F f);
+
+	/**
+	 * @param i a láncolt lista indexe
+	 * @param key a keresendő elemhez tartozó kulcs.
+	 * @return a megadott elemre mutató pointer, ha nem találja, nullptr
+	 */
+	HashItem* find(size_t i, keyType key);
+
+	/**
+	 * @param i a láncolt lista indexe
+	 * @param key a keresendő elemhez tartozó kulcs.
+	 * @param pos ide kerül a megtalált elem helye a láncban
+	 * @return a megadott elemre mutató pointer, ha nem találja, nullptr
+	 */
+	HashItem* find(size_t i, keyType key, position& pos);
+
+	/**
+	 * Keresés nélkül hozzáadja az elemet a megadott indexű láncolt listához.
+	 * Csak akkor szabad hívni, ha a kulcs biztosan nincs benne (pl. find után).
+	 * @param i A láncolt lista indexe
+	 * @param item A tárolandó elem a kulcsával együtt
+	 * @return a tárolt elemre mutató pointer
+	 */
+	HashItem* push(size_t i, const HashItem& item);
+
+	/**
+	 * Mint a push(i, item), és megadja a tárolt elem helyét a láncban.
+	 */
+	HashItem* push(size_t i, const HashItem& item, position& pos);
+
 	/**
 	 * HArray iteratora. Csak a már feltöltött elemeken megy végig.
 	 * Ezt fogja örökli a HashTable.
 	 */
 	class iterator {
+		friend class HArray; // Az erase-nek kell az index és az elem
 	private:
-		HArray<T, keyType, defSize>* pArr; //< Mutató a Tárolóra
-		HashItem const * pItem; //< Mutató az éppen mutatott elemre
+		HArray* pArr; //< Mutató a Tárolóra
+		HashItem* pItem; //< Mutató az éppen mutatott elemre
 		size_t idx; //< A jelenlegi elem indexe
 		keyType key; //< A jelenlegi elem kulcsa
+		position pos; //< A jelenlegi elem helye a láncban, ezzel az erase és a léptetés nem keres
 	public:
 		/**
 		 * Konstruktor
@@ -142,24 +277,43 @@ public:
 		 * @param i Az elem indexe
 		 * @param key Az elemhez tartozó kulcs
 		 */
-		iterator(HArray<T, keyType, defSize>* arr, size_t i, keyType key):pArr(arr),pItem((*pArr)[i].find(key)), idx(i), key(key){
+		iterator(HArray* arr, size_t i, keyType key):pArr(arr),pItem((*pArr)[i].find(key)), idx(i), key(key){
+		};
+
+		/**
+		 * Konstruktor egy már megtalált elemből, újabb keresés nélkül.
+		 * @param arr Mutató a tárolóra
+		 * @param i Az elem indexe
+		 * @param item Az elemre mutató pointer
+		 */
+		iterator(HArray* arr, size_t i, HashItem* item) :pArr(arr), pItem(item), idx(i), key(item->key) {
+		};
+
+		/**
+		 * Konstruktor egy megtalált elemből, a láncbeli helyével együtt. Az így kapott iterátorral a törlés nem keres.
+		 * @param arr Mutató a tárolóra
+		 * @param i Az elem indexe
+		 * @param item Az elemre mutató pointer
+		 * @param pos Az elem helye a láncban
+		 */
+		iterator(HArray* arr, size_t i, HashItem* item, position pos) :pArr(arr), pItem(item), idx(i), key(item->key), pos(pos) {
 		};
 
 		/**
 		 * Üres iterator konstruktora. Az end() létrehozásához kell.
 		 * @param arr A tároló mutatója
 		 */
-		iterator(HArray<T, keyType, defSize>* arr, size_t i) :pArr(arr), pItem(nullptr), idx(i) {};
+		iterator(HArray* arr, size_t i) :pArr(arr), pItem(nullptr), idx(i) {};
 
 		/**
 		 * Default konstruktor-szerű. A megadott tároló első elemére mutat
 		 * @param arr A tároló mutatója
 		 */
-		iterator(HArray<T, keyType, defSize>* arr) :pArr(arr), pItem(nullptr), idx(0) {
+		iterator(HArray* arr) :pArr(arr), pItem(nullptr), idx(0) {
 			if ((*pArr)[idx].isEmpty())
 				++(*this);
 			else 
-				pItem = (*pArr)[idx].getFirst();
+				pItem = (*pArr)[idx].getFirst(pos);
 
 			if (pItem == nullptr) // Üres az egész HArray
 				*this = iterator(arr, idx); // = end()
@@ -168,12 +322,14 @@ public:
 			
 		};
 
-		// Lehet kulcs alapjan keresni, mert van HashItem operator==(keyType)
+		// A mutatott elem címe megvan, nem kell újra keresni. Az end() nem dereferálható.
 		HashItem& operator*() {
-			return *((*pArr)[idx].find(key)); 
+			if (pItem == nullptr) throw std::out_of_range("Az end() iterator nem dereferalhato.");
+			return *pItem;
 		};
 		HashItem* operator->() {
-			return (*pArr)[idx].find(key); 
+			if (pItem == nullptr) throw std::out_of_range("Az end() iterator nem dereferalhato.");
+			return pItem;
 		};
 
 		/** 
@@ -186,14 +342,14 @@ public:
 				return *this; // end()
 			}
 
-			HashItem const * next;
+			HashItem* next;
 			//Ha a pItem nullptr, akkor tömböt léptünk és a lista első elemét kell megnéznünk
 			if (pItem == nullptr) {
-				next = (*pArr)[idx].getFirst();
+				next = (*pArr)[idx].getFirst(pos);
 			}
 			else {
-				// Megnézzük, hogy a jelenlegi listában van-e még elem.
-				next = (*pArr)[idx].getNext(*pItem);
+				// Megnézzük, hogy a jelenlegi listában van-e még elem. A pos miatt nem kell keresni.
+				next = (*pArr)[idx].getNext(pItem, pos);
 			}
 
 			if (next != nullptr) { // Ha van, akkor boldogok vagyunk
@@ -241,6 +397,23 @@ public:
 		return iterator(this, nArrays * defSize);
 
 	};
+	/**
+	 * Kitörli az iterátor által mutatott elemet. Nem keres kulcs alapján. A bejárással kapott iterátor
+	 * tudja az elem helyét a láncban, így O(1), a find-dal kapottnál egyszer végigmegy a láncon.
+	 * A többi elem iterátora érvényes marad, kivéve a következő elemét, helyette a visszaadottat kell használni.
+	 * @param it egy létező elem iterátora
+	 * @return a következő elem iterátora, vagy end()
+	 */
+	iterator erase(iterator it);
+
+	/**
+	 * Egyetlen bejárással kitörli az összes elemet, amire a pred igaz.
+	 * @param pred pred(HashItem&) -> bool
+	 * @return a törölt elemek száma
+	 */
+	template<typename F>
+	size_t eraseIf(F pred);
+
 	/**
 	 * Értékadó operátor. 
 	 */
@@ -251,106 +424,224 @@ public:
 	~HArray();
 protected:
 	size_t nArrays; //< A jelenleg tárolt tömbök száma. A HashTable függvényeinek el kell érni.
+
+	/**
+	 * Hozzáfűz egy új tömböt a meglévők mozgatása nélkül. Csak SegmentedLayout-tal használható.
+	 */
+	void addArray() {
+		pData.addArray();
+		++nArrays;
+	}
 private:
+	typedef typename Layout::template buckets<llist, defSize, Alloc> bucketArray;
+
 	/**
 	 * @return visszaadja az index alapján meghatározott láncolt listát.
 	 */
-	LinkedList<HashItem>& operator[](size_t i); 
+	llist& operator[](size_t i); 
+
 	size_t nElements; //< A Jelenlegi elemszám, nyilván van tartva, hogy ne kelljen mindig kiszámolni
-	typedef FixArray<LinkedList<HashItem>, defSize> fixarr; //= FixArray<LinkedList<HashItem>, size>
-	fixarr* pData; //< Láncolt listákkal feltöltött fix tömbök tárolója.
+	bucketArray pData; //< Láncolt listák tárolója, a Layout szerint elrendezve.
 	HArray(const HArray& rhs); 	//< Másoló konstruktor tiltása
 };
 
 
-template<typename T, typename keyType, size_t defSize>
-inline HArray<T, keyType, defSize>::HArray(size_t nArrays): nArrays(nArrays), nElements(0), pData((nArrays > 0) ? new fixarr[nArrays] : nullptr)
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline HArray<T, keyType, defSize, Alloc, Layout, Chain>::HArray(size_t nArrays, const Alloc& alloc): nArrays(nArrays), nElements(0), pData(nArrays, alloc)
 {
 }
 
-template<typename T, typename keyType, size_t defSize>
-inline HArray<T, keyType, defSize>::HArray() : HArray(1) 
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline HArray<T, keyType, defSize, Alloc, Layout, Chain>::HArray() : HArray(1) 
 {
 }
 
-template<typename T, typename keyType, size_t defSize>
-inline size_t HArray<T, keyType, defSize>::size() const
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline Alloc HArray<T, keyType, defSize, Alloc, Layout, Chain>::get_allocator() const
+{
+	return pData.get_allocator();
+}
+
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline size_t HArray<T, keyType, defSize, Alloc, Layout, Chain>::size() const
 {
 	return nElements;
 }
 
-template<typename T, typename keyType, size_t defSize>
-inline size_t HArray<T, keyType, defSize>::capacity() const
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline size_t HArray<T, keyType, defSize, Alloc, Layout, Chain>::capacity() const
 {
 	return nArrays * defSize - nElements;
 }
 
 
 
-template<typename T, typename keyType, size_t defSize>
-inline LinkedList<typename HArray<T,keyType,defSize>::HashItem>& HArray<T, keyType, defSize>::operator[](size_t i)  
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline typename HArray<T, keyType, defSize, Alloc, Layout, Chain>::llist& HArray<T, keyType, defSize, Alloc, Layout, Chain>::operator[](size_t i)  
 {
-	size_t idx_in_array = i % defSize;
-	size_t nArray = (i-idx_in_array) / defSize;
-
-	// Alulindexelésre nem kellene tesztelni a size_t típus miatt, de fő a biztonság.
-	if (nArray >= nArrays || nArray < 0) 
-		throw std::out_of_range("Out of range. Esetleg rossz a Hash fuggveny?");
-	return pData[nArray][idx_in_array];
+	return pData[i];
 }
 
-template<typename T, typename keyType, size_t defSize>
-inline void HArray<T, keyType, defSize>::add(size_t i, keyType key, const T& value)
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline bool HArray<T, keyType, defSize, Alloc, Layout, Chain>::add(size_t i, keyType key, const T& value)
 {	
-	LinkedList<HashItem>& list = (*this)[i];
+	llist& list = (*this)[i];
 
-	if(list.find(key) != nullptr) return;
+	if(list.find(key) != nullptr) return false;
 
 	list.push(HashItem(key, value));
 	nElements++;
+	return true;
 }
 
-template<typename T, typename keyType, size_t defSize>
-inline void HArray<T, keyType, defSize>::remove(size_t i, keyType key)
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline bool HArray<T, keyType, defSize, Alloc, Layout, Chain>::add(size_t i, const HashItem& item)
 {
-	LinkedList<HashItem>& list = (*this)[i];
+	llist& list = (*this)[i];
 
-	if (list.find(key) == nullptr) return;
+	if (list.find(item) != nullptr) return false;
 
-	list.remove(key);
+	list.push(item);
+	nElements++;
+	return true;
+}
+
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline bool HArray<T, keyType, defSize, Alloc, Layout, Chain>::remove(size_t i, keyType key)
+{
+	if (!(*this)[i].remove(key))
+		return false;
 	nElements--;
+	return true;
 }
 
-template<typename T, typename keyType, size_t defSize>
-inline T* HArray<T, keyType, defSize>::get(size_t i, keyType key)
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline bool HArray<T, keyType, defSize, Alloc, Layout, Chain>::remove(size_t i, keyType key, T& removed)
 {
-	LinkedList<HashItem>& list = (*this)[i];
+	llist& list = (*this)[i];
+	position pos;
+	for (HashItem* iter = list.getFirst(pos); iter != nullptr; iter = list.getNext(iter, pos)) {
+		if (iter->key == key) {
+			removed = iter->value;
+			list.erase(iter, pos);
+			nElements--;
+			return true;
+		}
+	}
+	return false;
+}
+
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline T* HArray<T, keyType, defSize, Alloc, Layout, Chain>::get(size_t i, keyType key)
+{
+	llist& list = (*this)[i];
 	HashItem* res = list.find(key);
 	if (res == nullptr) return nullptr;
 	return &(res->value);
 }
 
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline bool HArray<T, keyType, defSize, Alloc, Layout, Chain>::contains(size_t i, keyType key)
+{
+	return (*this)[i].find(key) != nullptr;
+}
 
-template<typename T, typename keyType, size_t defSize>
-inline HArray<T, keyType, defSize>& HArray<T, keyType, defSize>::operator=(const HArray& rhs)
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline typename HArray<T, keyType, defSize, Alloc, Layout, Chain>::HashItem* HArray<T, keyType, defSize, Alloc, Layout, Chain>::find(size_t i, keyType key)
+{
+	return (*this)[i].find(key);
+}
+
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline typename HArray<T, keyType, defSize, Alloc, Layout, Chain>::HashItem* HArray<T, keyType, defSize, Alloc, Layout, Chain>::find(size_t i, keyType key, position& pos)
+{
+	return (*this)[i].find(key, pos);
+}
+
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline size_t HArray<T, keyType, defSize, Alloc, Layout, Chain>::chainLength(size_t i)
+{
+	return (*this)[i].length();
+}
+
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+template<typename F>
+inline size_t HArray<T, keyType, defSize, Alloc, Layout, Chain>::splitBucket(size_t from, size_t to, F moves)
+{
+	return (*this)[from].splice_if((*this)[to], [&moves](HashItem& item) { return moves(item.key); });
+}
+
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+template<typename F>
+inline void HArray<T, keyType, defSize, Alloc, Layout, Chain>::forEachInRange(size_t first, size_t last, F f)
+{
+	for (size_t i = first; i < last; ++i) {
+		llist& l = (*this)[i];
+		if (l.isEmpty()) continue;
+		position pos;
+		for (HashItem* iter = l.getFirst(pos); iter != nullptr; iter = l.getNext(iter, pos))
+			f(*iter);
+	}
+}
+
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline typename HArray<T, keyType, defSize, Alloc, Layout, Chain>::iterator HArray<T, keyType, defSize, Alloc, Layout, Chain>::erase(iterator it)
+{
+	HashItem* next = (*this)[it.idx].erase(it.pItem, it.pos);
+	nElements--;
+	if (next != nullptr)
+		return iterator(this, it.idx, next, it.pos);
+	// A lánc végére értünk: a következő vödörtől keres tovább
+	iterator res(this, it.idx + 1);
+	return ++res;
+}
+
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+template<typename F>
+inline size_t HArray<T, keyType, defSize, Alloc, Layout, Chain>::eraseIf(F pred)
+{
+	size_t n = 0;
+	for (size_t i = 0; i < nArrays * defSize; ++i) {
+		llist& l = (*this)[i];
+		if (!l.isEmpty())
+			n += l.erase_if(pred);
+	}
+	nElements -= n;
+	return n;
+}
+
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline typename HArray<T, keyType, defSize, Alloc, Layout, Chain>::HashItem* HArray<T, keyType, defSize, Alloc, Layout, Chain>::push(size_t i, const HashItem& item)
+{
+	HashItem* res = (*this)[i].push(item);
+	nElements++;
+	return res;
+}
+
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline typename HArray<T, keyType, defSize, Alloc, Layout, Chain>::HashItem* HArray<T, keyType, defSize, Alloc, Layout, Chain>::push(size_t i, const HashItem& item, position& pos)
+{
+	HashItem* res = (*this)[i].push(item, pos);
+	nElements++;
+	return res;
+}
+
+
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline HArray<T, keyType, defSize, Alloc, Layout, Chain>& HArray<T, keyType, defSize, Alloc, Layout, Chain>::operator=(const HArray& rhs)
 {
 	// Önértékadás
 	if (this == &rhs) return *this;
 	nArrays = rhs.nArrays;
 	nElements = rhs.nElements;
-	delete[] pData;
-	pData = new fixarr[nArrays];
-	for (size_t i = 0; i < nArrays; i++) {
-		pData[i] = rhs.pData[i];
-	}
+	pData = rhs.pData;
 	return *this;
 }
 
 
-template<typename T, typename keyType, size_t defSize>
-inline HArray<T, keyType, defSize>::~HArray()
+template<typename T, typename keyType, size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline HArray<T, keyType, defSize, Alloc, Layout, Chain>::~HArray()
 {
-	delete[] pData;
 }
 
 #endif // !HARRAY_H
\ No newline at end of file
@@ -0,0 +1,69 @@
+﻿/*****************************************************************
+ * @file   hashset.hpp
+ * @brief  HashSet class: csak kulcsokat tároló HashTable.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef HASHSET_H
+#define HASHSET_H
+#include <memory>
+#include "hashtable.hpp"
+
+#include "memtrace.h"
+
+/**
+ * Generikus Hash halmaz.
+ * Ugyanaz a HashTable tárolja, mint a többi táblát, de érték nélkül (NoValue), így egy elem csak a kulcsot tárolja.
+ * @tparam keyType A kulcs típusa.
+ * @tparam hashFunction Hash függvény, ami a megadott kulcstípusból előállít egy indexet a hashtábla mérettartományán belül.
+ * @tparam defSize A tábla alapértelmezett tömbmérete. Ekkora blokkokban növekszik a tábla.
+ * @tparam Alloc Allokátor, a halmaz minden foglalása ezen keresztül történik. (default: std::allocator<keyType>)
+ * @tparam Layout A vödrök elrendezése. (default: SegmentedLayout)
+ * @tparam Chain A vödrök láncai. (default: LinkedChain)
+ */
+template<typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash, size_t defSize = 100, typename Alloc = std::allocator<keyType>, typename Layout = SegmentedLayout, typename Chain = LinkedChain>
+class HashSet : private HashTable<NoValue, keyType, hashFunction, defSize, typename std::allocator_traits<Alloc>::template rebind_alloc<NoValue>, Layout, Chain> {
+
+	typedef HashTable<NoValue, keyType, hashFunction, defSize, typename std::allocator_traits<Alloc>::template rebind_alloc<NoValue>, Layout, Chain> table;
+public:
+	/**
+	 * Default konstruktor.
+	 */
+	HashSet() :table() {};
+
+	/**
+	 * Konstruktor megadott allokátorral.
+	 * @param alloc a halmaz foglalásaihoz használt allokátor
+	 */
+	explicit HashSet(const Alloc& alloc) :table(typename std::allocator_traits<Alloc>::template rebind_alloc<NoValue>(alloc)) {};
+
+	// Örökölt függvények
+	using table::size;
+	using table::capacity;
+	using table::contains;
+	using table::remove;
+	using table::erase;
+	using table::erase_if;
+	using table::shrink_to_fit;
+	using table::reserve;
+	using table::setMinLoadFactor;
+	using table::enableBloomFilter;
+	using table::bloomStats;
+	using table::iterator;
+	using table::begin;
+	using table::end;
+
+	/**
+	 * Berakja a kulcsot a halmazba, ha még nincs benne.
+	 * @param key a kulcs
+	 * @return true, ha új kulcs volt, false, ha már benne volt
+	 */
+	bool insert(keyType key) {
+		return this->put(key, NoValue());
+	}
+};
+
+#endif // !HASHSET_H
@@ -22,3 +22,173 @@ size_t charCodeHash(const std::string key, const size_t maxSize)
 size_t linHash(const int a, const size_t maxSize) {
     return a % maxSize;
 }
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HASH_BATCH_AVX2
+#include <immintrin.h>
+#include <cstring>
+
+/**
+ * Futs kzben dnti el, hogy a processzor tud-e AVX2-t.
+ */
+static bool cpuHasAvx2()
+{
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+
+/**
+ * Egy 256 bites vektor nyolc 32 bites elemnek sszege.
+ */
+__attribute__((target("avx2"))) static int32_t sum8(__m256i v)
+{
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+    return _mm_cvtsi128_si32(s);
+}
+
+/**
+ * A charCodeHash vge: l * (szumma(key[i] * i) + szumma(i * i)) mod 2^64, majd mod maxSize.
+ * @param dot szumma(key[i] * i), eljeles karakterekkel
+ */
+static size_t charCodeFinish(size_t l, int64_t dot, const size_t maxSize)
+{
+    size_t squares = l == 0 ? 0 : (size_t)((unsigned __int128)(l - 1) * l * (2 * l - 1) / 6);
+    size_t res = l * ((size_t)dot + squares);
+    return res % maxSize;
+}
+
+/**
+ * charCodeHash AVX2-vel: szumma((key[i] + i) * i * l) = l * (szumma(key[i] * i) + szumma(i * i)) mod 2^64.
+ * Egy 32 byte-os darabban a j. byte slya j, a darab eleje (b) miatt mg b * szumma(key[i]) addik hozz.
+ */
+__attribute__((target("avx2"))) static size_t charCodeHashAvx2(const std::string& key, const size_t maxSize)
+{
+    const __m256i weights = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+        16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+    const __m256i ones8 = _mm256_set1_epi8(1);
+    const __m256i ones16 = _mm256_set1_epi16(1);
+    size_t l = key.length();
+    const char* p = key.data();
+    int64_t dot = 0;
+    for (size_t b = 0; b < l; b += 32) {
+        __m256i c;
+        if (l - b >= 32) {
+            c = _mm256_loadu_si256((const __m256i*)(p + b));
+        }
+        else { // A kulcs vgn tlra nem szabad olvasni
+            char buf[32] = { 0 };
+            std::memcpy(buf, p + b, l - b);
+            c = _mm256_loadu_si256((const __m256i*)buf);
+        }
+        // maddubs: eljel nlkli sly * eljeles karakter, pronknt 16 bitre (2 * 31 * 128 < 2^15)
+        int32_t weighted = sum8(_mm256_madd_epi16(_mm256_maddubs_epi16(weights, c), ones16));
+        int32_t plain = sum8(_mm256_madd_epi16(_mm256_maddubs_epi16(ones8, c), ones16));
+        dot += (int64_t)weighted + (int64_t)b * plain;
+    }
+    return charCodeFinish(l, dot, maxSize);
+}
+
+/**
+ * charCodeHash nyolc, legfeljebb 32 byte-os kulcsra egyszerre, kulcsonknt egy 32 bites svban.
+ * Rvid kulcsoknl a kulcsonknti vltozat idejt a kt horizontlis sszegzs viszi el. Itt a nyolc kulcs
+ * szorzat-vektort hrom hadd szint s egy svcsere egyetlen vektorr fzi, aminek k. svja a k. kulcs
+ * szumma(key[i] * i)-je. A kulcsok vge nullkkal tltdik ki, gy a rvidebb kulcsok plusz byte-jai nem szmtanak.
+ */
+__attribute__((target("avx2"))) static void charCodeHash8Avx2(const std::string* keys, const size_t maxSize, size_t* out)
+{
+    const __m256i weights = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+        16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+    const __m256i ones16 = _mm256_set1_epi16(1);
+    __m256i v[8];
+    for (int k = 0; k < 8; ++k) {
+        alignas(32) char buf[32] = { 0 }; // A kulcs vgn tlra nem szabad olvasni
+        std::memcpy(buf, keys[k].data(), keys[k].length());
+        __m256i c = _mm256_load_si256((const __m256i*)buf);
+        v[k] = _mm256_madd_epi16(_mm256_maddubs_epi16(weights, c), ones16);
+    }
+    // hadd(a, b) 128 bites felenknt: a0+a1, a2+a3, b0+b1, b2+b3. Kt szint utn a t0 als fele
+    // a 0-3. kulcs als ngy rszsszegt tartalmazza, a fels fele a fels ngyet, a t1 ugyangy a 4-7. kulcst.
+    __m256i t0 = _mm256_hadd_epi32(_mm256_hadd_epi32(v[0], v[1]), _mm256_hadd_epi32(v[2], v[3]));
+    __m256i t1 = _mm256_hadd_epi32(_mm256_hadd_epi32(v[4], v[5]), _mm256_hadd_epi32(v[6], v[7]));
+    __m256i dots = _mm256_add_epi32(_mm256_permute2x128_si256(t0, t1, 0x20), _mm256_permute2x128_si256(t0, t1, 0x31));
+    alignas(32) int32_t d[8];
+    _mm256_store_si256((__m256i*)d, dots);
+    for (int k = 0; k < 8; ++k)
+        out[k] = charCodeFinish(keys[k].length(), d[k], maxSize);
+}
+
+/**
+ * linHash ngyesvel AVX2-vel. Nem negatv kulcsokra s 1 <= maxSize < 2^31 esetn pontos:
+ * a double hnyados als egszrsze legfeljebb eggyel tbb a valdinl, ezt a negatv maradk jelzi.
+ */
+__attribute__((target("avx2"))) static void linHashAvx2(const int* keys, size_t n, const size_t maxSize, size_t* out)
+{
+    const __m256d m = _mm256_set1_pd((double)maxSize);
+    const __m256d zero = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i k = _mm_loadu_si128((const __m128i*)(keys + i));
+        if (_mm_movemask_ps(_mm_castsi128_ps(k)) != 0) { // Van negatv kulcs
+            for (size_t j = i; j < i + 4; ++j)
+                out[j] = linHash(keys[j], maxSize);
+            continue;
+        }
+        __m256d a = _mm256_cvtepi32_pd(k);
+        __m256d q = _mm256_floor_pd(_mm256_div_pd(a, m));
+        __m256d r = _mm256_sub_pd(a, _mm256_mul_pd(q, m));
+        r = _mm256_add_pd(r, _mm256_and_pd(_mm256_cmp_pd(r, zero, _CMP_LT_OQ), m));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(r)));
+    }
+    for (; i < n; ++i)
+        out[i] = linHash(keys[i], maxSize);
+}
+#endif
+
+bool batchHashSimd()
+{
+#ifdef HASH_BATCH_AVX2
+    return cpuHasAvx2();
+#else
+    return false;
+#endif
+}
+
+void charCodeHashBatch(const std::string* keys, size_t n, const size_t maxSize, size_t* out, bool simd)
+{
+#ifdef HASH_BATCH_AVX2
+    if (simd && cpuHasAvx2()) {
+        size_t i = 0;
+        while (i < n) {
+            // Nyolc rvid kulcs egy-egy svban; ha a nyolc kztt hossz is van, az az els kulcsonknt megy
+            size_t k = 0;
+            while (k < 8 && i + k < n && keys[i + k].length() <= 32)
+                ++k;
+            if (k == 8) {
+                charCodeHash8Avx2(keys + i, maxSize, out + i);
+                i += 8;
+            }
+            else {
+                out[i] = charCodeHashAvx2(keys[i], maxSize);
+                ++i;
+            }
+        }
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; ++i)
+        out[i] = charCodeHash(keys[i], maxSize);
+}
+
+void linHashBatch(const int* keys, size_t n, const size_t maxSize, size_t* out, bool simd)
+{
+#ifdef HASH_BATCH_AVX2
+    if (simd && cpuHasAvx2() && maxSize >= 1 && maxSize < ((size_t)1 << 31)) {
+        linHashAvx2(keys, n, maxSize, out);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < n; ++i)
+        out[i] = linHash(keys[i], maxSize);
+}
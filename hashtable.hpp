@@ -10,8 +10,19 @@
 #ifndef HASHTABLE_H
 #define HASHTABLE_H
 
+#include <memory_resource>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
 #include "harray.hpp"
+#include "bloomfilter.hpp"
+#include "instrumentation.hpp"
+#include "threadpool.hpp"
 #include <string>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
 
 /**
  * Karakterkod sorrend alapján hashel.
@@ -30,17 +41,67 @@ size_t charCodeHash(const std::string key, const size_t maxSize);
  */
 size_t linHash(const int key, const size_t maxSize);
 
+/**
+ * Egyszerre sok kulcsot hashel a charCodeHash-sel, bitre ugyanazt az eredményt adva.
+ * AVX2-vel szumma(key[i] * i) byte-onkénti szorzás-összeadással készül, a szumma(i * i) zárt alakból.
+ * Nyolc egymást követő, legfeljebb 32 byte-os kulcs egyszerre megy, kulcsonként egy 32 bites sávban;
+ * a hosszabb kulcsok (és a sor végi maradék) kulcsonként, 32 byte-os darabokban. A rövidebb darab nullákkal töltődik ki.
+ * Ha a processzor nem tud AVX2-t (futás közben derül ki), vagy simd hamis, kulcsonként a charCodeHash-t hívja.
+ * @param keys n kulcs
+ * @param out ide kerül az n hash érték
+ */
+void charCodeHashBatch(const std::string* keys, size_t n, const size_t maxSize, size_t* out, bool simd = true);
+
+/**
+ * Egyszerre sok kulcsot hashel a linHash-sel, bitre ugyanazt az eredményt adva.
+ * AVX2-vel négyesével, double osztással és egy javító lépéssel számolja a maradékot, ha a négy kulcs
+ * nem negatív és maxSize < 2^31 (ilyenkor az eredmény pontos). Különben kulcsonként a linHash-t hívja.
+ * @param keys n kulcs
+ * @param out ide kerül az n hash érték
+ */
+void linHashBatch(const int* keys, size_t n, const size_t maxSize, size_t* out, bool simd = true);
+
+/**
+ * @return van-e futás közben elérhető SIMD (AVX2) út a kötegelt hasheléshez
+ */
+bool batchHashSimd();
+
+/**
+ * Kötegelt hashelés tetszőleges hash függvénnyel: kulcsonként hívja a függvényt.
+ * A charCodeHash és a linHash specializációja a SIMD-es változatot használja.
+ */
+template<typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline void hashBatch(const keyType* keys, size_t n, const size_t maxSize, size_t* out) {
+	for (size_t i = 0; i < n; ++i)
+		out[i] = hashFunction(keys[i], maxSize);
+}
+
+template<>
+inline void hashBatch<std::string, charCodeHash>(const std::string* keys, size_t n, const size_t maxSize, size_t* out) {
+	charCodeHashBatch(keys, n, maxSize, out);
+}
+
+template<>
+inline void hashBatch<int, linHash>(const int* keys, size_t n, const size_t maxSize, size_t* out) {
+	linHashBatch(keys, n, maxSize, out);
+}
+
 /**
  * Generikus Hash tábla.
  * @tparam T A tárolt adat típusa
  * @tparam keyType A kulcs típusa.  
  * @tparam hashFunction Hash függvény, ami a megadott kulcstípusból előállít egy indexet a hashtábla mérettartományán belül.
  * @tparam defSize A tábla alapértelmezett tömbmérete. Ekkora blokkokban növekszik a tábla, ha a kapacitás 90% fölé érne.
+ * @tparam Alloc Allokátor, a tábla minden foglalása ezen keresztül történik. (default: std::allocator<T>)
+ * @tparam Layout A vödrök elrendezése. SegmentedLayout: defSize méretű tömbök, FlatLayout: egyetlen folytonos tömb. (default: SegmentedLayout)
+ * @tparam Chain A vödrök láncai. LinkedChain: elemenként egy listaelem, UnrolledChain: több elem egy listaelemben. (default: LinkedChain)
+ *         UnrolledChain esetén a törlés elemeket mozgat, ezért a get által visszaadott pointerek bármely törléskor érvénytelenné válhatnak.
+ * @tparam Instrument Mérési policy. NoInstrumentation: nem mér, semmibe nem kerül, LatencyInstrumentation: késleltetés hisztogramok. (default: NoInstrumentation)
  */
-template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash, size_t defSize = 100>
-class HashTable : private HArray<T, keyType, defSize> {
+template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash, size_t defSize = 100, typename Alloc = std::allocator<T>, typename Layout = SegmentedLayout, typename Chain = LinkedChain, typename Instrument = NoInstrumentation>
+class HashTable : private HArray<T, keyType, defSize, Alloc, Layout, Chain>, private Instrument {
 	
-	typedef HArray<T, keyType, defSize> harray;
+	typedef HArray<T, keyType, defSize, Alloc, Layout, Chain> harray;
 	
 	/**
 	 * Újra hashel minden elemet. Akkor hívódik, ha a kapacitás elérte a 90%-ot.
@@ -48,52 +109,387 @@ class HashTable : private HArray<T, keyType, defSize> {
 	 */
 	void rehash(); 
 
+	/**
+	 * Újra hashel minden elemet egy megadott számú tömbből álló táblába.
+	 * A növelés és a zsugorítás is ezt használja, a felesleges tömbök felszabadulnak.
+	 * @param nArrays az új tábla tömbjeinek száma
+	 * @param cause a kiváltó művelet, a mérési policy kapja meg
+	 */
+	void rehash(size_t nArrays, HashOp cause = HashOp::Rehash);
+
+	/**
+	 * A jelenlegi szint vödörszáma (N * 2^L). Hagyományos növekedésnél mindig az összes vödör száma.
+	 */
+	size_t linearBase;
+
+	/**
+	 * A következő kettéválasztandó vödör. Az ez alatti vödrök már ketté vannak választva,
+	 * bennük a kulcsok 2 * linearBase szerint hashelnek. Hagyományos növekedésnél 0.
+	 */
+	size_t splitPtr;
+
+	/**
+	 * Lineáris hashelés (Litwin): növekedéskor a teljes újrahashelés helyett
+	 * egyszerre csak a splitPtr által mutatott vödör válik ketté.
+	 */
+	bool linearGrowth;
+
+	/**
+	 * Kettéválasztja a splitPtr vödröt a splitPtr + linearBase vödörbe, ha kell, új tömböt fűz hozzá.
+	 * Egy vödörnyi munka, a többi elem nem mozdul.
+	 */
+	void splitBucket();
+
+	/**
+	 * Efölötti telítettségnél növekszik a tábla.
+	 */
+	static constexpr double maxLoadFactor = 0.9;
+
+	/**
+	 * Ez alatti telítettségnél zsugorodik a tábla. 0 esetén nincs automatikus zsugorítás.
+	 */
+	double minLoadFactor;
+
+	/**
+	 * @return a telítettség (elemszám / használt vödrök száma)
+	 */
+	double loadFactor() const;
+
 
 	/**
 	 * Meghívja a hash függvényt a jelenlegi mérettel.
 	 */
 	size_t hash(keyType key) const; 
 
+	/**
+	 * Egyszerre hashel n kulcsot a jelenlegi mérettel (hashBatch), ugyanazt adja, mint a hash().
+	 * @param out ide kerül az n index
+	 */
+	void hashMany(const keyType* keys, size_t n, size_t* out) const;
+
+	/**
+	 * Ennyi kulcsot hashel egyszerre a put_many és a get_many.
+	 */
+	static const size_t batchSize = 256;
+
 	/**
 	 * Privát konstruktor megadott számú tömbbel.
 	 * Csak a rehash() használja
 	 */
-	HashTable(size_t nArrays) :harray(nArrays) {};
+	HashTable(size_t nArrays, const Alloc& alloc) :harray(nArrays, alloc), linearBase(nArrays * defSize), splitPtr(0), linearGrowth(false), minLoadFactor(0.25), filter(alloc), bloomBitsPerKey(0) {};
 
 	/**
 	 * Privát értékadás.
 	 * Csak a rehash() használja.
 	 */
 	HashTable& operator=(const HashTable& rhs); 
+
+	typedef typename harray::HashItem HashItem;
+
+	/**
+	 * Egyetlen hasheléssel és kereséssel megkeresi a kulcsot, ha nincs benne, berakja.
+	 * Csak akkor növeli a táblát, ha ténylegesen új elem kerül be.
+	 * @param key a kulcs
+	 * @param makeValue ezt hívja meg az új elem értékéért, csak ha a kulcs még nincs benne
+	 * @param i ide kerül az elem láncolt listájának indexe. Ha hashed igaz, ez a már kiszámolt index
+	 * @param pos ide kerül az elem helye a láncban, hogy az iterátorával keresés nélkül lehessen törölni
+	 * @param inserted ide kerül, hogy új elem került-e be
+	 * @param hashed i már a kulcs indexe (pl. a hashMany-ből)
+	 * @return a megtalált vagy berakott elem
+	 */
+	template<typename F>
+	HashItem* findOrPush(keyType key, F makeValue, size_t& i, typename harray::position& pos, bool& inserted, bool hashed = false);
+
+	/**
+	 * Megkeresi a kulcshoz tartozó elemet. Ha be van kapcsolva a Bloom szűrő, először azt kérdezi meg.
+	 * @return az elemre mutató pointer, vagy nullptr
+	 */
+	HashItem* lookup(keyType key);
+
+	/**
+	 * Mint a lookup(key), de a kulcs indexe már ki van számolva.
+	 */
+	HashItem* lookup(keyType key, size_t i);
+
+	/**
+	 * Bloom szűrő a sikertelen keresések gyorsítására. Alapból ki van kapcsolva.
+	 */
+	BloomFilter<typename std::allocator_traits<Alloc>::template rebind_alloc<char>> filter;
+
+	/**
+	 * A Bloom szűrő kulcsonkénti bitszáma. 0: nincs szűrő
+	 */
+	size_t bloomBitsPerKey;
+
+	/**
+	 * @return a kulcs 64 bites hash-e a Bloom szűrőhöz. std::hash-t használ, ha van, különben a tábla hash függvényét.
+	 */
+	static uint64_t bloomHash(const keyType& key);
+
+	/**
+	 * Újraépíti a Bloom szűrőt a jelenlegi elemekre. A törölt kulcsok itt tűnnek el a szűrőből.
+	 * @param expectedKeys ennyi kulcsra méretezi, 0: a vödrök számára
+	 */
+	void rebuildBloomFilter(size_t expectedKeys = 0);
+
+	/**
+	 * Törlés után a két küszöb közé zsugorít, ha a telítettség a minimum alá esett.
+	 */
+	void shrinkIfSparse();
 public:
 	/**
 	 * Default konstruktor.
 	 */
 	HashTable();
 
+	/**
+	 * Konstruktor megadott allokátorral.
+	 * @param alloc a tábla foglalásaihoz használt allokátor
+	 */
+	explicit HashTable(const Alloc& alloc);
+
+	typedef Alloc allocator_type;
+
 	// Örökölt függvények
 	using harray::size;
 	using harray::capacity;
+	using harray::get_allocator;
 
 
 	/**
-	* Berakja a megadott elemet a HashTable-be.
+	* Berakja a megadott elemet a HashTable-be, ha a kulcs még nincs benne.
 	 * @param key az elemhez tartozó kulcs
 	 * @param value Tárolandó elem
+	 * @return true, ha új elem került be, false, ha a kulcs már benne volt
 	 */
-	void put(keyType key, const T& value); 
+	bool put(keyType key, const T& value); 
+
+	/**
+	 * Örökölt iterator
+	 */
+	class iterator : public harray::iterator {
+	public:
+		/**
+		 * Megörökli az összes konstruktort.
+		 */
+		using harray::iterator::iterator; 
+
+		/**
+		 * Konverzió a HArray iterátorából (pl. a HArray::erase eredményéből).
+		 */
+		iterator(const typename harray::iterator& it) :harray::iterator(it) {};
+	};
+
+	/**
+	 * Berakja a megadott elemet a HashTable-be, ha a kulcs még nincs benne. Egyszer hashel és egyszer keres.
+	 * @param key az elemhez tartozó kulcs
+	 * @param value Tárolandó elem
+	 * @return (a kulcshoz tartozó elem iterátora, true ha új elem került be).
+	 *         Az iterátor tudja az elem címét és helyét, így sem az elérése, sem az erase nem keres újra.
+	 */
+	std::pair<iterator, bool> insert(keyType key, const T& value);
+
+	/**
+	 * Megkeresi a kulcsot, ha nincs benne, alapértelmezett értékkel berakja. Egyszer hashel és egyszer keres.
+	 * @param key az elemhez tartozó kulcs
+	 * @return (a kulcshoz tartozó elem iterátora, true ha új elem került be).
+	 *         Az iterátor tudja az elem címét és helyét, így sem az elérése, sem az erase nem keres újra.
+	 */
+	std::pair<iterator, bool> find_or_insert(keyType key);
+
+	/**
+	 * Megkeresi a kulcsot, ha nincs benne, a factory által előállított értékkel berakja.
+	 * A factory csak akkor hívódik meg, ha a kulcs még nincs benne. Egyszer hashel és egyszer keres.
+	 * @param key az elemhez tartozó kulcs
+	 * @param factory paraméter nélküli függvény, ami T-t ad vissza
+	 * @return a kulcshoz tartozó érték
+	 */
+	template<typename F>
+	T& get_or_insert_with(keyType key, F factory);
+
 
 	/**
 	 * @param key Az elemhez tartozó kulcs. 
-	 * @return Visszaadja a kulcshoz tartozó adatra mutató pointert, ha nem találja nullptr-t
+	 * @return Visszaadja a kulcshoz tartozó adatra mutató pointert, ha nem találja nullptr-t.
+	 *         LinkedChain esetén a pointer a kulcs törléséig (vagy a következő újrahashelésig) érvényes.
+	 *         UnrolledChain esetén egy másik kulcs törlése is érvénytelenítheti, mert a lánc helyben tömörödik.
 	 */
 	T* get(keyType key);
 
+	/**
+	 * @param key Az elemhez tartozó kulcs.
+	 * @return benne van-e a kulcs a táblában
+	 */
+	bool contains(keyType key);
+
+	/**
+	 * Kötegelt berakás: batchSize-onként egyszerre hasheli a kulcsokat (charCodeHash és linHash esetén SIMD-del).
+	 * Hagyományos növekedésnél előre akkorára növeli a táblát, hogy egyik put se váltson ki újrahashelést.
+	 * Az eredmény ugyanaz, mintha sorban put-olná az elemeket.
+	 * @param keys n kulcs
+	 * @param values a kulcsokhoz tartozó n érték
+	 * @return a ténylegesen berakott (új) elemek száma
+	 */
+	size_t put_many(const keyType* keys, const T* values, size_t n);
+
+	/**
+	 * Kötegelt keresés: batchSize-onként egyszerre hasheli a kulcsokat, majd sorban megkeresi őket.
+	 * @param keys n kulcs
+	 * @param out ide kerül az n találat (mint a get(): pointer az értékre, vagy nullptr)
+	 * @return a megtalált kulcsok száma
+	 */
+	size_t get_many(const keyType* keys, size_t n, T** out);
+
+	/**
+	 * @param key Az elemhez tartozó kulcs.
+	 * @return a kulcs vödrében lévő lánc hossza (a hash függvény minőségének, vagy ütköztetett kulcsok felismerésére)
+	 */
+	size_t chainLength(keyType key);
+
+	/**
+	 * Bekapcsolja (vagy átméretezi) a Bloom szűrőt. A get és a contains először a szűrőt kérdezi meg,
+	 * és a biztosan hiányzó kulcsokra a vödrök érintése nélkül válaszol.
+	 * A szűrő minden rehash-kor (növekedés, zsugorítás) újraépül, és akkor is, ha a betett kulcsok száma
+	 * elérte azt, amire méretezve van (lineáris hashelésnél csak így).
+	 * @param bitsPerKey kulcsonként ennyi bit (10 bit kb. 1% téves pozitív arányt ad). 0: kikapcsolja a szűrőt
+	 */
+	void enableBloomFilter(size_t bitsPerKey = 10);
+
+	/**
+	 * @return a Bloom szűrő memóriahasználata, becsült és mért téves pozitív aránya
+	 */
+	BloomStats bloomStats() const;
+
+	/**
+	 * @return a mérési policy, pl. LatencyInstrumentation esetén a hisztogramok és a dump()
+	 */
+	const Instrument& instrumentation() const {
+		return *this;
+	}
+
+	/**
+	 * @return a mérési policy, pl. a dumpEvery() beállításához vagy a mérések kiürítéséhez
+	 */
+	Instrument& instrumentation() {
+		return *this;
+	}
+
 	/**
 	 * Kitörli a kulcs által jelölt elemet a HashtTable-ből. Ha nincs benne, nem csinál semmit.
 	 * @param key Az elemhez tartozó kulcs.
+	 * @return benne volt-e
+	 */
+	bool remove(keyType key);
+
+	/**
+	 * Kitörli a kulcs által jelölt elemet, és kiadja az értékét. Egyszer hashel és egyszer keres,
+	 * így nem kell előtte get-tel kiolvasni az értéket.
+	 * @param key Az elemhez tartozó kulcs.
+	 * @param removed ide kerül a törölt érték, ha benne volt
+	 * @return benne volt-e
+	 */
+	bool remove(keyType key, T& removed);
+
+	/**
+	 * Kitörli az iterátor által mutatott elemet hashelés és kulcs szerinti keresés nélkül, így bejárás közben is lehet törölni.
+	 * A bejárással kapott iterátor tudja az elem helyét a láncban, ezért a törlés O(1).
+	 * Nem zsugorít (az érvénytelenítené az iterátorokat), a bejárás után a shrink_to_fit() megteheti.
+	 * @param it egy létező elem iterátora
+	 * @return a következő elem iterátora, vagy end()
+	 */
+	iterator erase(iterator it);
+
+	/**
+	 * Egyetlen bejárással kitörli az összes elemet, amire a pred igaz. A láncokból kiláncolt listaelemek
+	 * lánconként együtt szabadulnak fel, kulcsonkénti hashelés és keresés nélkül.
+	 * A végén, ha kell, a remove-hoz hasonlóan zsugorít.
+	 * @param pred pred(const keyType&, T&) -> bool, HashSet esetén pred(const keyType&) -> bool
+	 * @return a törölt elemek száma
+	 */
+	template<typename F>
+	size_t erase_if(F pred);
+
+	/**
+	 * Összezsugorítja a táblát a legkisebb olyan méretre, amiben az elemek még nem váltanak ki növekedést.
+	 * A felesleges tömbök felszabadulnak.
+	 */
+	void shrink_to_fit();
+
+	/**
+	 * Előre megnöveli a táblát, hogy n elem növekedés nélkül elférjen benne. Kisebbre nem zsugorít.
+	 * Egyetlen újrahashelés, a sok put közbeni sorozatos növelés helyett.
+	 * @param n a várható elemszám
+	 */
+	void reserve(size_t n);
+
+	/**
+	 * Beállítja az automatikus zsugorítás küszöbét.
+	 * Ha egy törlés után a telítettség ez alá esik, a tábla a két küszöb közötti telítettségre zsugorodik,
+	 * így a növelés és a zsugorítás nem váltogatja egymást.
+	 * @param f az új küszöb, [0, 0.45) közé kell esnie. 0 kikapcsolja a zsugorítást.
+	 */
+	void setMinLoadFactor(double f);
+
+	/**
+	 * Be- vagy kikapcsolja a lineáris hashelést (Litwin).
+	 * Bekapcsolva a put a teljes újrahashelés helyett egyetlen vödröt választ ketté a következő szint hash-ével,
+	 * és ha kell, egy új defSize méretű tömböt fűz hozzá. Így egy put munkája korlátos, a meglévő tömbök
+	 * nem foglalódnak újra, és a ketté nem választott vödrök elemeire mutató pointerek érvényesek maradnak.
+	 * Feltétel: a hash függvény H(kulcs) % maxSize alakú (mint a charCodeHash, linHash), különben
+	 * a kettéválasztott vödör elemei nem a két lehetséges helyre kerülnének.
+	 * A zsugorítás (remove, shrink_to_fit) továbbra is teljes újrahashelés. A Bloom szűrő a kulcsok száma szerint épül újra.
+	 * @param on true: lineáris, false: hagyományos (teljes újrahashelés) növekedés
+	 * @throw std::invalid_argument ha a Layout nem tud tömböt hozzáfűzni (FlatLayout)
+	 */
+	void enableLinearHashing(bool on = true);
+
+	/**
+	 * Átveszi egy másik tábla beállításait: a zsugorítási küszöböt, a lineáris hashelést és a Bloom szűrőt.
+	 * Az elemeket nem másolja. Pl. egy tábla új hash-sel való újraépítéséhez.
+	 * @param other a minta tábla
 	 */
-	void remove(keyType key);
+	void copySettings(const HashTable& other);
+
+	/**
+	 * Párhuzamosan meghívja az fn(key, value) függvényt minden elemre.
+	 * A vödrök tartománya darabokra oszlik, a darabokat a pool szálai munkalopással dolgozzák fel,
+	 * így a hosszú láncok sem hagynak tétlen szálat. A sorrend nem meghatározott.
+	 * Közben a tábla nem módosítható, és az fn-nek szálbiztosnak kell lennie.
+	 * @param fn fn(const keyType&, T&)
+	 * @param pool ezen a poolon fut, ismétlődő bejárásokhoz
+	 */
+	template<typename F>
+	void for_each_parallel(F fn, ThreadPool& pool);
+
+	/**
+	 * Mint a pool-os változat, de a hívás idejére saját poolt indít.
+	 * @param threads a szálak száma, 0: a hardveres szálak száma
+	 */
+	template<typename F>
+	void for_each_parallel(F fn, size_t threads = 0) {
+		ThreadPool pool(threads);
+		for_each_parallel(fn, pool);
+	}
+
+	/**
+	 * Párhuzamos map-reduce az elemeken: szálanként részeredményt gyűjt, a végén ezeket vonja össze.
+	 * @param identity a combine egységeleme (pl. 0 az összeadáshoz), minden részeredmény innen indul
+	 * @param map map(const keyType&, const T&) -> R
+	 * @param combine combine(R, R) -> R, asszociatív és kommutatív
+	 * @param pool ezen a poolon fut
+	 */
+	template<typename R, typename M, typename C>
+	R reduce(R identity, M map, C combine, ThreadPool& pool);
+
+	/**
+	 * Mint a pool-os változat, de a hívás idejére saját poolt indít.
+	 * @param threads a szálak száma, 0: a hardveres szálak száma
+	 */
+	template<typename R, typename M, typename C>
+	R reduce(R identity, M map, C combine, size_t threads = 0) {
+		ThreadPool pool(threads);
+		return reduce(identity, map, combine, pool);
+	}
 
 	/** 
 	 * @return Visszaadja a kulcshoz tartozó elemre mutató ptrt, ha nincs a táblában nullptr-t ad. 
@@ -105,17 +501,6 @@ public:
 	 */
 	T* const operator[](keyType key) const;
 	
-	/**
-	 * Örökölt iterator
-	 */
-	class iterator : public harray::iterator {
-	public:
-		/**
-		 * Megörökli az összes konstruktort.
-		 */
-		using harray::iterator::iterator; 
-	};
-
 	/**
 	 * @return A hashtable elejére mutató iterator
 	 */
@@ -130,69 +515,457 @@ public:
 	};
 };
 
-template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
-inline size_t HashTable<T, keyType, hashFunction, defSize>::hash(keyType key) const
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline size_t HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::hash(keyType key) const
+{
+	size_t i = hashFunction(key, linearBase);
+	if (i < splitPtr) // Már kettéválasztott vödör
+		i = hashFunction(key, 2 * linearBase);
+	return i;
+}
+
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::hashMany(const keyType* keys, size_t n, size_t* out) const
 {
-	return hashFunction(key, this->nArrays * defSize);
+	hashBatch<keyType, hashFunction>(keys, n, linearBase, out);
+	if (splitPtr != 0) {
+		for (size_t j = 0; j < n; ++j)
+			if (out[j] < splitPtr) // Már kettéválasztott vödör
+				out[j] = hashFunction(keys[j], 2 * linearBase);
+	}
 }
 
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::rehash()
+{
+	rehash(this->nArrays + 1, HashOp::Put);
+}
 
-template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
-inline void HashTable<T, keyType, hashFunction, defSize>::rehash()
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::rehash(size_t nArrays, HashOp cause)
 {
-	HashTable nTable(this->nArrays + 1);
+	uint64_t t = instrumentation().start();
+	size_t fromBuckets = this->nArrays * defSize;
+	HashTable nTable(nArrays, get_allocator());
 	for (HashTable::iterator iter = begin(); iter != end(); ++iter) {
-		nTable.put(iter->key, iter->value);
+		nTable.add(nTable.hash(iter->key), *iter);
 	}
 
 	*this = nTable;
+	linearBase = this->nArrays * defSize;
+	splitPtr = 0;
+	if (bloomBitsPerKey != 0)
+		rebuildBloomFilter();
+	instrumentation().rehashed(cause, size(), fromBuckets, this->nArrays * defSize, t);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::splitBucket()
+{
+	if constexpr (Layout::stableGrowth) {
+		uint64_t t = instrumentation().start();
+		size_t target = splitPtr + linearBase;
+		if (target >= this->nArrays * defSize)
+			harray::addArray();
+		size_t next = 2 * linearBase;
+		size_t from = splitPtr;
+		size_t moved = harray::splitBucket(from, target, [next, from](const keyType& key) { return hashFunction(key, next) != from; });
+		++splitPtr;
+		if (splitPtr == linearBase) { // A szint végére ért: minden vödör ketté van választva
+			linearBase *= 2;
+			splitPtr = 0;
+		}
+		instrumentation().rehashed(HashOp::Put, moved, target, target + 1, t);
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::enableLinearHashing(bool on)
+{
+	if constexpr (!Layout::stableGrowth) {
+		if (on) throw std::invalid_argument("A linearis hasheleshez SegmentedLayout kell.");
+	}
+	linearGrowth = on;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::copySettings(const HashTable& other)
+{
+	minLoadFactor = other.minLoadFactor;
+	linearGrowth = other.linearGrowth;
+	enableBloomFilter(other.bloomBitsPerKey);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline double HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::loadFactor() const
+{
+	return (double)size() / (double)(linearBase + splitPtr);
 }
 
-template<typename T, typename keyType, size_t hashFunction(keyType, size_t), size_t defSize>
-inline HashTable<T, keyType, hashFunction, defSize>::HashTable() :harray()
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::HashTable() :harray(), linearBase(this->nArrays * defSize), splitPtr(0), linearGrowth(false), minLoadFactor(0.25), bloomBitsPerKey(0)
 {
 }
 
-template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
-inline HashTable<T, keyType, hashFunction, defSize>& HashTable<T, keyType, hashFunction, defSize>::operator=(const HashTable& rhs)
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::HashTable(const Alloc& alloc) :harray(1, alloc), linearBase(defSize), splitPtr(0), linearGrowth(false), minLoadFactor(0.25), filter(alloc), bloomBitsPerKey(0)
+{
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>& HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::operator=(const HashTable& rhs)
 {
 	harray::operator=(rhs);
 	return *this;
 }
 
 
-template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
-inline void HashTable<T, keyType, hashFunction, defSize>::put(keyType key, const T& value)
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline bool HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::put(keyType key, const T& value)
 {
-	if ((double)size() / (double)(this->nArrays * defSize) >= 0.9) {
-		rehash();
+	return insert(key, value).second;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+template<typename F>
+inline typename HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::HashItem* HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::findOrPush(keyType key, F makeValue, size_t& i, typename harray::position& pos, bool& inserted, bool hashed)
+{
+	uint64_t t = instrumentation().start();
+	if (!hashed)
+		i = hash(key);
+	uint64_t h = 0;
+	bool mayContain = true;
+	if (bloomBitsPerKey != 0) {
+		h = bloomHash(key);
+		mayContain = filter.mayContain(h);
+	}
+	HashItem* found = mayContain ? harray::find(i, key, pos) : nullptr;
+	if (found != nullptr) {
+		inserted = false;
+		instrumentation().record(HashOp::Put, t);
+		return found;
+	}
+	if (mayContain && bloomBitsPerKey != 0)
+		filter.falsePositive();
+	if (loadFactor() >= maxLoadFactor) {
+		if (linearGrowth)
+			splitBucket();
+		else
+			rehash();
+		i = hash(key); // Csak növekedéskor kell újra hashelni
+	}
+	inserted = true;
+	if (bloomBitsPerKey != 0) {
+		// Lineáris hashelésnél nincs teljes rehash, ezért a szűrő a kulcsok száma szerint épül újra,
+		// a kétszeresére méretezve, hogy az újraépítés költsége elosztódjon
+		if (filter.full())
+			rebuildBloomFilter(2 * (size() + 1));
+		filter.add(h);
 	}
-	this->add(hash(key), key, value);
+	HashItem* res = harray::push(i, HashItem(key, makeValue()), pos);
+	instrumentation().record(HashOp::Put, t);
+	return res;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline std::pair<typename HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::iterator, bool> HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::insert(keyType key, const T& value)
+{
+	size_t i;
+	typename harray::position pos;
+	bool inserted;
+	HashItem* item = findOrPush(key, [&value]() -> const T& { return value; }, i, pos, inserted);
+	return std::pair<iterator, bool>(iterator(this, i, item, pos), inserted);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline std::pair<typename HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::iterator, bool> HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::find_or_insert(keyType key)
+{
+	size_t i;
+	typename harray::position pos;
+	bool inserted;
+	HashItem* item = findOrPush(key, []() { return T(); }, i, pos, inserted);
+	return std::pair<iterator, bool>(iterator(this, i, item, pos), inserted);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+template<typename F>
+inline T& HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::get_or_insert_with(keyType key, F factory)
+{
+	size_t i;
+	typename harray::position pos;
+	bool inserted;
+	return findOrPush(key, factory, i, pos, inserted)->value;
 }
 
-template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
-inline T* HashTable<T, keyType, hashFunction, defSize>::get(keyType key) 
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline T* HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::get(keyType key) 
 {
-	return harray::get(hash(key), key);
+	HashItem* res = lookup(key);
+	if (res == nullptr) return nullptr;
+	return &(res->value);
 }
 
-template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
-inline void HashTable<T, keyType, hashFunction, defSize>::remove(keyType key)
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline bool HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::contains(keyType key) 
 {
-	harray::remove(hash(key), key);
+	return lookup(key) != nullptr;
 }
 
-template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
-inline T* HashTable<T, keyType, hashFunction, defSize>::operator[](keyType key)
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline typename HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::HashItem* HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::lookup(keyType key)
+{
+	return lookup(key, hash(key));
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline typename HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::HashItem* HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::lookup(keyType key, size_t i)
+{
+	uint64_t t = instrumentation().start();
+	HashItem* res = nullptr;
+	if (bloomBitsPerKey == 0) {
+		res = harray::find(i, key);
+	}
+	else if (filter.mayContain(bloomHash(key))) {
+		res = harray::find(i, key);
+		if (res == nullptr)
+			filter.falsePositive();
+	}
+	instrumentation().record(HashOp::Get, t);
+	return res;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline size_t HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::put_many(const keyType* keys, const T* values, size_t n)
+{
+	if (!linearGrowth)
+		reserve(size() + n); // Előre növel, hogy a köteg közben ne kelljen újrahashelni
+	size_t idx[batchSize];
+	size_t inserted = 0;
+	for (size_t first = 0; first < n; first += batchSize) {
+		size_t m = n - first < batchSize ? n - first : batchSize;
+		hashMany(keys + first, m, idx);
+		for (size_t j = 0; j < m; ++j) {
+			size_t buckets = linearBase + splitPtr;
+			bool ins;
+			typename harray::position pos;
+			const T& value = values[first + j];
+			findOrPush(keys[first + j], [&value]() -> const T& { return value; }, idx[j], pos, ins, true);
+			inserted += ins;
+			if (linearBase + splitPtr != buckets && j + 1 < m) // Lineáris növekedés: a köteg maradékát újra kell hashelni
+				hashMany(keys + first + j + 1, m - j - 1, idx + j + 1);
+		}
+	}
+	return inserted;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline size_t HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::get_many(const keyType* keys, size_t n, T** out)
+{
+	size_t idx[batchSize];
+	size_t found = 0;
+	for (size_t first = 0; first < n; first += batchSize) {
+		size_t m = n - first < batchSize ? n - first : batchSize;
+		hashMany(keys + first, m, idx);
+		for (size_t j = 0; j < m; ++j) {
+			HashItem* res = lookup(keys[first + j], idx[j]);
+			out[first + j] = res == nullptr ? nullptr : &res->value;
+			found += res != nullptr;
+		}
+	}
+	return found;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline uint64_t HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::bloomHash(const keyType& key)
+{
+	if constexpr (std::is_default_constructible<std::hash<keyType>>::value)
+		return (uint64_t)std::hash<keyType>()(key);
+	else
+		return (uint64_t)hashFunction(key, (size_t)-1);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::rebuildBloomFilter(size_t expectedKeys)
+{
+	filter.reset(expectedKeys != 0 ? expectedKeys : this->nArrays * defSize, bloomBitsPerKey);
+	for (iterator iter = begin(); iter != end(); ++iter) {
+		filter.add(bloomHash(iter->key));
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline size_t HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::chainLength(keyType key)
+{
+	return harray::chainLength(hash(key));
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::enableBloomFilter(size_t bitsPerKey)
+{
+	bloomBitsPerKey = bitsPerKey;
+	if (bitsPerKey == 0)
+		filter.reset(0, 0);
+	else
+		rebuildBloomFilter();
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline BloomStats HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::bloomStats() const
+{
+	return filter.stats();
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline bool HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::remove(keyType key)
+{
+	uint64_t t = instrumentation().start();
+	bool removed = harray::remove(hash(key), key);
+	if (removed)
+		shrinkIfSparse();
+	instrumentation().record(HashOp::Remove, t);
+	return removed;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline bool HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::remove(keyType key, T& removed)
+{
+	uint64_t t = instrumentation().start();
+	bool found = harray::remove(hash(key), key, removed);
+	if (found)
+		shrinkIfSparse();
+	instrumentation().record(HashOp::Remove, t);
+	return found;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::shrinkIfSparse()
+{
+	if (this->nArrays > 1 && loadFactor() < minLoadFactor) {
+		// A két küszöb közé zsugorít, hogy a következő put ne növelje rögtön vissza.
+		double target = (minLoadFactor + maxLoadFactor) / 2;
+		size_t nArrays = (size_t)std::ceil(size() / (target * defSize));
+		rehash(nArrays > 0 ? nArrays : 1, HashOp::Remove);
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline typename HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::iterator HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::erase(iterator it)
+{
+	uint64_t t = instrumentation().start();
+	iterator next = harray::erase(it);
+	instrumentation().record(HashOp::Remove, t);
+	return next;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+template<typename F>
+inline size_t HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::erase_if(F pred)
+{
+	uint64_t t = instrumentation().start();
+	size_t n = harray::eraseIf([&](HashItem& item) {
+		if constexpr (std::is_same<T, NoValue>::value)
+			return (bool)pred((const keyType&)item.key);
+		else
+			return (bool)pred((const keyType&)item.key, item.value);
+	});
+	if (n > 0)
+		shrinkIfSparse();
+	instrumentation().record(HashOp::Remove, t);
+	return n;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::shrink_to_fit()
+{
+	// A legkisebb tömbszám, aminél még a maxLoadFactor alatt maradunk
+	size_t nArrays = size() / defSize + 1;
+	while ((double)size() / (double)(nArrays * defSize) >= maxLoadFactor)
+		++nArrays;
+	if (nArrays < this->nArrays)
+		rehash(nArrays);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::reserve(size_t n)
+{
+	size_t nArrays = (size_t)(n / (maxLoadFactor * defSize)) + 1;
+	if (nArrays > this->nArrays)
+		rehash(nArrays, HashOp::Put);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::setMinLoadFactor(double f)
+{
+	if (f < 0 || f >= maxLoadFactor / 2)
+		throw std::invalid_argument("A zsugoritasi kuszobnek [0, maxLoadFactor/2) koze kell esnie.");
+	minLoadFactor = f;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline T* HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::operator[](keyType key)
 {
 	return get(key);
 }
 
-template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize>
-inline T* const HashTable<T, keyType, hashFunction, defSize>::operator[](const keyType key) const
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+inline T* const HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::operator[](const keyType key) const
 {
 	return get(key);
 }
 
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+template<typename F>
+inline void HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::for_each_parallel(F fn, ThreadPool& pool)
+{
+	// Szálanként kb. 16 darab, hogy legyen mit lopni, de legalább 256 vödör, hogy a szervezés ne domináljon
+	size_t n = harray::buckets();
+	size_t chunk = n / (pool.size() * 16);
+	if (chunk < 256) chunk = 256;
+	pool.parallelFor(n, chunk, [&](size_t first, size_t last, size_t) {
+		harray::forEachInRange(first, last, [&](typename harray::HashItem& item) { fn((const keyType&)item.key, item.value); });
+	});
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain, typename Instrument>
+template<typename R, typename M, typename C>
+inline R HashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain, Instrument>::reduce(R identity, M map, C combine, ThreadPool& pool)
+{
+	/**
+	 * Szálankénti részeredmény, külön cache sorban.
+	 */
+	struct alignas(64) Partial {
+		R value;
+	};
+	std::vector<Partial> partials(pool.size(), Partial{ identity });
+	size_t n = harray::buckets();
+	size_t chunk = n / (pool.size() * 16);
+	if (chunk < 256) chunk = 256;
+	pool.parallelFor(n, chunk, [&](size_t first, size_t last, size_t worker) {
+		R& acc = partials[worker].value;
+		harray::forEachInRange(first, last, [&](typename harray::HashItem& item) { acc = combine(acc, map((const keyType&)item.key, (const T&)item.value)); });
+	});
+	R result = identity;
+	for (const Partial& p : partials)
+		result = combine(result, p.value);
+	return result;
+}
+
+
+namespace pmr {
+	/**
+	 * std::pmr::memory_resource-ból foglaló HashTable.
+	 * pl. egy kérésen belül élő tábla: std::pmr::monotonic_buffer_resource,
+	 * hosszú életű tábla: std::pmr::synchronized_pool_resource
+	 */
+	template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash, size_t defSize = 100>
+	using HashTable = ::HashTable<T, keyType, hashFunction, defSize, std::pmr::polymorphic_allocator<T>>;
+
+	/**
+	 * std::pmr::memory_resource-ból foglaló HArray.
+	 */
+	template <typename T, typename keyType = std::string, size_t defSize = 10>
+	using HArray = ::HArray<T, keyType, defSize, std::pmr::polymorphic_allocator<T>>;
+}
 
 #endif // HASHTABLE_H
\ No newline at end of file
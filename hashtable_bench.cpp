@@ -0,0 +1,654 @@
+﻿/*****************************************************************
+ * @file   hashtable_bench.cpp
+ * @brief  Teljesítménymérések. Optimalizálva, NDEBUG-gal érdemes fordítani:
+ *         g++ -std=c++17 -O2 -DNDEBUG hashtable_bench.cpp hashtable.cpp
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <string>
+
+#include "hashtable.hpp"
+#include "durabletable.hpp"
+#include "seededhashtable.hpp"
+#include "hashset.hpp"
+#include "cuckoohashtable.hpp"
+#include "diskhashtable.hpp"
+#include "radixtree.hpp"
+#include "splithashtable.hpp"
+#include "hugepageresource.hpp"
+#include "fixedhashtable.hpp"
+#include <fstream>
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+// BENCHCASE
+// 1: Vodrok elrendezese (SegmentedLayout / FlatLayout) kereses
+// 2: Lancok (LinkedChain / UnrolledChain) kereses 4 hosszu lancokban
+// 3: Sikertelen keresesek Bloom szuroval es anelkul
+// 4: DurableHashTable irasok a harom fsync szaballyal
+// 5: Kulcsolt hash (SeededHashTable) normal es tamado altal valasztott kulcsokkal
+// 6: CuckooHashTable es lancolt HashTable: telitettseg, beszuras, kereses p99
+// 7: Beszurasok kesleltetese teljes rehash-sel es linearis hasheles mellett
+// 8: DiskHashTable a cache-nel sokszor nagyobb adathalmazzal
+// 9: Teljes bejaras: iterator es reduce 1, 2, 4, 8 szallal
+// 10: RadixTree es HashTable: pontszeru kereses, prefix lekerdezes
+// 11: Nagy ertekek: HashTable es SplitHashTable (hot/cold)
+// 12: Nagy tabla huge page-eken: kereses es dTLB hianyok
+// 13: Kotegelt hasheles (SIMD), put_many, get_many
+// 14: Kis, rovid eletu tabla: FixedHashTable es HashTable
+
+#define BENCHCASE 14
+
+/**
+ * Megméri egy függvény futási idejét.
+ * @return az eltelt idő nanoszekundumban
+ */
+template <typename F>
+double measureNs(F f) {
+	auto start = std::chrono::steady_clock::now();
+	f();
+	auto stop = std::chrono::steady_clock::now();
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+}
+
+/**
+ * Kiír egy eredménysort.
+ */
+void report(const std::string& name, double nsPerOp) {
+	std::cout << std::left << std::setw(48) << name << std::right << std::setw(10) << std::fixed << std::setprecision(1) << nsPerOp << " ns/op" << std::endl;
+}
+
+/**
+ * @return 0..n-1 véletlen sorrendben
+ */
+std::vector<int> shuffledKeys(int n, unsigned seed = 42) {
+	std::vector<int> keys(n);
+	for (int i = 0; i < n; ++i) keys[i] = i;
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(seed));
+	return keys;
+}
+
+/**
+ * Négyesével ugyanabba a vödörbe hashel, így 4 hosszú láncok jönnek létre.
+ */
+size_t quadHash(const int a, const size_t maxSize) {
+	return (a / 4) % maxSize;
+}
+
+/**
+ * std::hash alapú string hash, hogy a tábla ne a hash függvény minőségét mérje.
+ */
+size_t stdStringHash(const std::string key, const size_t maxSize) {
+	return std::hash<std::string>()(key) % maxSize;
+}
+
+volatile size_t sink; //< Hogy a fordító ne optimalizálja ki a kereséseket
+
+/**
+ * Egy hardveres számláló a saját folyamatra (perf_event_open). Ha nem elérhető (pl. virtuális gépen), ok() hamis.
+ */
+class PerfCounter {
+	int fd; //< A számláló, vagy -1
+public:
+	PerfCounter(uint32_t type, uint64_t config) {
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+	bool ok() const { return fd >= 0; }
+	void start() {
+		if (fd < 0) return;
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+	uint64_t stop() {
+		uint64_t v = 0;
+		if (fd < 0) return 0;
+		ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(fd, &v, sizeof(v)) != sizeof(v)) v = 0;
+		return v;
+	}
+	~PerfCounter() { if (fd >= 0) close(fd); }
+};
+
+/**
+ * @return a folyamat transzparens huge page-eken lévő memóriája kB-ban (/proc/self/smaps_rollup), vagy 0
+ */
+size_t anonHugePagesKb() {
+	std::ifstream in("/proc/self/smaps_rollup");
+	std::string field;
+	size_t kb;
+	while (in >> field) {
+		if (field == "AnonHugePages:" && in >> kb) return kb;
+	}
+	return 0;
+}
+
+/**
+ * Véletlen sorrendben megkeresi a kulcsokat, és kiírja a keresés idejét és a dTLB hiányokat.
+ */
+template <typename Table>
+void reportTlb(const std::string& name, Table& t, const std::vector<int>& keys) {
+	const uint64_t dtlb = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8);
+	PerfCounter misses(PERF_TYPE_HW_CACHE, dtlb | ((uint64_t)PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+	PerfCounter accesses(PERF_TYPE_HW_CACHE, dtlb | ((uint64_t)PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16));
+	size_t found = 0;
+	misses.start();
+	accesses.start();
+	double ns = measureNs([&] {
+		for (int k : keys) found += t.get(k) != nullptr;
+	});
+	uint64_t m = misses.stop(), a = accesses.stop();
+	sink = found;
+	report(name + " get", ns / keys.size());
+	if (misses.ok() && accesses.ok() && a > 0)
+		std::cout << std::setprecision(3) << "    dTLB hiany / get: " << (double)m / keys.size() << ", hiany arany: " << (double)m / a << std::endl;
+	else
+		std::cout << "    dTLB szamlalo nem elerheto (perf_event_open)" << std::endl;
+}
+
+/**
+ * 256 byte-os érték a hot/cold méréshez.
+ */
+struct Payload {
+	int id; //< Azonosító
+	char data[252]; //< Hideg adat
+	Payload(int id = 0) :id(id), data() {};
+};
+
+/**
+ * Berakja a kulcsokat, majd kiírja a put, a sikeres és a sikertelen get átlagos idejét.
+ * @param missing nem berakott kulcsok, ugyanazokba a láncokba hashelnek, mint a berakottak
+ */
+template <typename Table>
+void reportFatValues(const std::string& name, Table& t, const std::vector<int>& keys, const std::vector<int>& missing) {
+	int n = (int)keys.size();
+	double ns = measureNs([&] {
+		for (int k : keys) t.put(k, Payload(k));
+	});
+	report(name + " put", ns / n);
+	size_t found = 0;
+	ns = measureNs([&] {
+		for (int k : keys) found += t.get(k)->id == k;
+	});
+	report(name + " get (talalat)", ns / n);
+	ns = measureNs([&] {
+		for (int k : missing) found += t.get(k) != nullptr;
+	});
+	report(name + " get (nincs benne)", ns / missing.size());
+	sink = found;
+}
+
+/**
+ * @return n különböző, 8 betűs kulcs, amik a charCodeHash-nél mind ütköznek
+ * (az a. és b. betű a-val, ill. b-vel eltolva nem változtatja a sum(key[i] * i)-t).
+ */
+std::vector<std::string> collidingKeys(size_t n) {
+	std::vector<std::string> keys;
+	HashSet<std::string, stdStringHash, 1000> seen;
+	std::string k = "mmmmmmmm";
+	std::mt19937 rng(7);
+	while (keys.size() < n) {
+		size_t a = 1 + rng() % 7, b = 1 + rng() % 7;
+		if (a == b || k[a] + b > 'z' || k[b] - a < 'a') continue;
+		k[a] += (char)b;
+		k[b] -= (char)a;
+		if (seen.insert(k)) keys.push_back(k);
+	}
+	return keys;
+}
+
+/**
+ * Berakja, majd megkeresi az összes kulcsot, és kiírja a put és a get átlagos idejét.
+ */
+template <typename Table>
+void reportPutGet(const std::string& name, Table& t, const std::vector<std::string>& keys) {
+	double putNs = measureNs([&] {
+		for (size_t i = 0; i < keys.size(); ++i)
+			t.put(keys[i], (int)i);
+	});
+	size_t found = 0;
+	double getNs = measureNs([&] {
+		for (int r = 0; r < 10; ++r)
+			for (const std::string& k : keys)
+				found += (t.get(k) != nullptr);
+	});
+	sink = found;
+	report(name + " put", putNs / keys.size());
+	report(name + " get", getNs / (10.0 * keys.size()));
+}
+
+/**
+ * Egyenként megméri a keresések idejét, és kiírja a medián, p99 és p99.9 értékeket.
+ * Az értékek az óra lekérdezésének idejét (kb. 20 ns) is tartalmazzák.
+ */
+template <typename Table, typename Key>
+void reportLookupPercentiles(const std::string& name, Table& t, const std::vector<Key>& keys) {
+	std::vector<double> ns;
+	ns.reserve(keys.size());
+	size_t found = 0;
+	for (const Key& k : keys) {
+		auto start = std::chrono::steady_clock::now();
+		found += (t.get(k) != nullptr);
+		auto stop = std::chrono::steady_clock::now();
+		ns.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+	}
+	sink = found;
+	std::sort(ns.begin(), ns.end());
+	std::cout << std::left << std::setw(48) << name << std::right << std::setprecision(0)
+		<< "p50=" << ns[ns.size() / 2] << " p99=" << ns[ns.size() * 99 / 100] << " p99.9=" << ns[ns.size() * 999 / 1000]
+		<< " max=" << ns.back() << " ns" << std::endl;
+}
+
+/**
+ * Egyenként megméri a beszúrások idejét, és kiírja a medián, p99, p99.9 és legnagyobb értéket.
+ */
+template <typename Table, typename Key>
+void reportPutPercentiles(const std::string& name, Table& t, const std::vector<Key>& keys) {
+	std::vector<double> ns;
+	ns.reserve(keys.size());
+	for (const Key& k : keys) {
+		auto start = std::chrono::steady_clock::now();
+		t.put(k, k);
+		auto stop = std::chrono::steady_clock::now();
+		ns.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+	}
+	double total = 0;
+	for (double d : ns) total += d;
+	std::sort(ns.begin(), ns.end());
+	std::cout << std::left << std::setw(48) << name << std::right << std::setprecision(0)
+		<< "avg=" << total / ns.size() << " p50=" << ns[ns.size() / 2] << " p99=" << ns[ns.size() * 99 / 100]
+		<< " p99.9=" << ns[ns.size() * 999 / 1000] << " max=" << ns.back() << " ns" << std::endl;
+}
+
+/**
+ * Feltölti a táblát, majd véletlen sorrendben megkeresi az összes kulcsot.
+ * @return egy keresés átlagos ideje
+ */
+template <typename Table>
+double lookupNs(const std::vector<int>& keys, int rounds) {
+	Table t;
+	for (int k : keys) t.put(k, k);
+	size_t found = 0;
+	double ns = measureNs([&] {
+		for (int r = 0; r < rounds; ++r)
+			for (int k : keys)
+				found += (t.get(k) != nullptr);
+	});
+	sink = found;
+	return ns / ((double)keys.size() * rounds);
+}
+
+int main() {
+#if BENCHCASE > 0
+	{
+		std::cout << "-- 1: vodrok elrendezese, kereses --" << std::endl;
+		std::vector<int> small = shuffledKeys(5000);
+		std::vector<int> large = shuffledKeys(100000);
+		report("defSize=10   SegmentedLayout", lookupNs<HashTable<int, int, linHash, 10>>(small, 200));
+		report("defSize=10   FlatLayout", lookupNs<HashTable<int, int, linHash, 10, std::allocator<int>, FlatLayout>>(small, 200));
+		report("defSize=1000 SegmentedLayout", lookupNs<HashTable<int, int, linHash, 1000>>(large, 10));
+		report("defSize=1000 FlatLayout", lookupNs<HashTable<int, int, linHash, 1000, std::allocator<int>, FlatLayout>>(large, 10));
+	}
+#endif
+#if BENCHCASE > 1
+	{
+		std::cout << "-- 2: lancok, kereses 4 hosszu lancokban --" << std::endl;
+		std::vector<int> keys = shuffledKeys(100000);
+		report("LinkedChain", lookupNs<HashTable<int, int, quadHash, 1000>>(keys, 10));
+		report("UnrolledChain", lookupNs<HashTable<int, int, quadHash, 1000, std::allocator<int>, SegmentedLayout, UnrolledChain>>(keys, 10));
+	}
+#endif
+#if BENCHCASE > 2
+	{
+		std::cout << "-- 3: sikertelen keresesek (string kulcsok) --" << std::endl;
+		const int n = 20000;
+		std::vector<std::string> present, missing;
+		for (int i = 0; i < n; ++i) {
+			present.push_back("felhasznalo" + std::to_string(i));
+			missing.push_back("ismeretlen" + std::to_string(i));
+		}
+		for (size_t bits : {0, 10}) {
+			HashTable<int, std::string, charCodeHash, 5000> t;
+			t.enableBloomFilter(bits);
+			for (int i = 0; i < n; ++i) t.put(present[i], i);
+			size_t found = 0;
+			double ns = measureNs([&] {
+				for (int r = 0; r < 20; ++r)
+					for (const std::string& k : missing)
+						found += (t.get(k) != nullptr);
+			});
+			sink = found;
+			BloomStats st = t.bloomStats();
+			report(bits == 0 ? "Bloom szuro nelkul" : "Bloom szuroval (10 bit/kulcs)", ns / (20.0 * n));
+			if (bits != 0)
+				std::cout << std::setprecision(4) << "    memoria: " << st.memoryBytes << " byte, mert teves pozitiv: " << st.falsePositiveRate()
+					<< ", becsult: " << st.estimatedFalsePositiveRate << std::endl;
+		}
+	}
+#endif
+#if BENCHCASE > 3
+	{
+		std::cout << "-- 4: tartos irasok (write-ahead log) --" << std::endl;
+		const std::string dir = "wal_bench";
+		struct Case { const char* name; SyncPolicy policy; size_t batch; int n; };
+		for (const Case& c : { Case{ "fsync minden muvelet utan", SyncPolicy::EveryOp, 1, 2000 },
+				Case{ "fsync 64-es csoportonkent", SyncPolicy::Batch, 64, 50000 },
+				Case{ "fsync nelkul", SyncPolicy::None, 1, 50000 } }) {
+			for (int g = 0; g < 4; ++g) {
+				unlink((dir + "/wal." + std::to_string(g)).c_str());
+				unlink((dir + "/snapshot." + std::to_string(g)).c_str());
+			}
+			DurableHashTable<int, std::string, stdStringHash, 5000> t(dir, c.policy, c.batch);
+			double ns = measureNs([&] {
+				for (int i = 0; i < c.n; ++i)
+					t.assign("kulcs" + std::to_string(i), i);
+				t.commit();
+			});
+			report(c.name, ns / c.n);
+			std::cout << "    " << std::setprecision(0) << 1e9 * c.n / ns << " iras/s" << std::endl;
+		}
+		for (int g = 0; g < 4; ++g)
+			unlink((dir + "/wal." + std::to_string(g)).c_str());
+		rmdir(dir.c_str());
+	}
+#endif
+#if BENCHCASE > 4
+	{
+		std::cout << "-- 5: kulcsolt hash --" << std::endl;
+		std::vector<std::string> normal;
+		for (int i = 0; i < 20000; ++i)
+			normal.push_back("felhasznalo" + std::to_string(i));
+		{ HashTable<int, std::string, stdStringHash, 5000> t; reportPutGet("normal kulcsok, std::hash", t, normal); }
+		{ SeededHashTable<int, 5000, SipHash13> t; reportPutGet("normal kulcsok, SipHash-1-3", t, normal); }
+		{ SeededHashTable<int, 5000, SipHash24> t; reportPutGet("normal kulcsok, SipHash-2-4", t, normal); }
+
+		std::vector<std::string> evil = collidingKeys(5000);
+		{ HashTable<int, std::string, charCodeHash, 5000> t; reportPutGet("utkozo kulcsok, charCodeHash", t, evil); }
+		{ SeededHashTable<int, 5000, SipHash13> t; reportPutGet("utkozo kulcsok, SipHash-1-3", t, evil); }
+	}
+#endif
+#if BENCHCASE > 5
+	{
+		std::cout << "-- 6: cuckoo es lancolt tabla, veletlen int kulcsok --" << std::endl;
+		const int n = 200000;
+		std::vector<int> keys(n);
+		std::mt19937 rng(3);
+		for (int& k : keys) k = (int)(rng() >> 1);
+		std::vector<int> order = keys;
+		std::shuffle(order.begin(), order.end(), rng);
+		{
+			HashTable<int, int, linHash, 10000> t;
+			double ns = measureNs([&] { for (int k : keys) t.put(k, k); });
+			report("HashTable (LinkedChain) put", ns / n);
+			std::cout << std::setprecision(3) << "    telitettseg: " << (double)t.size() / (double)(t.size() + t.capacity()) << std::endl;
+			reportLookupPercentiles("HashTable (LinkedChain) get", t, order);
+		}
+		{
+			CuckooHashTable<int, int, linHash> t;
+			double ns = measureNs([&] { for (int k : keys) t.put(k, k); });
+			report("CuckooHashTable put", ns / n);
+			std::cout << std::setprecision(3) << "    telitettseg: " << t.loadFactor() << ", novekedes elott: " << t.loadFactorAtGrowth()
+				<< ", novekedesek: " << t.growths() << std::endl;
+			reportLookupPercentiles("CuckooHashTable get", t, order);
+		}
+	}
+#endif
+#if BENCHCASE > 6
+	{
+		std::cout << "-- 7: beszurasok kesleltetese, 200000 int kulcs --" << std::endl;
+		const int n = 200000;
+		std::vector<int> keys(n);
+		for (int i = 0; i < n; ++i) keys[i] = i * 7;
+		{
+			HashTable<int, int, linHash, 1000> t;
+			reportPutPercentiles("teljes rehash", t, keys);
+		}
+		{
+			HashTable<int, int, linHash, 1000> t;
+			t.enableLinearHashing();
+			reportPutPercentiles("linearis hasheles", t, keys);
+		}
+	}
+#endif
+#if BENCHCASE > 7
+	{
+		std::cout << "-- 8: lemezen tarolt tabla, 1000000 elem, 256 lapos (1 MB) cache --" << std::endl;
+		const std::string path = "disk_bench.dat";
+		unlink(path.c_str());
+		unlink((path + ".dir").c_str());
+		const int n = 1000000;
+		std::vector<int> keys(n);
+		for (int i = 0; i < n; ++i) keys[i] = i;
+		std::mt19937 rng(4);
+		std::shuffle(keys.begin(), keys.end(), rng);
+		{
+			DiskHashTable<int64_t, int, linHash, 4096> t(path, 256);
+			double ns = measureNs([&] { for (int k : keys) t.put(k, (int64_t)k * 3); });
+			report("put", ns / n);
+			t.flush();
+			std::cout << "    lapok: " << t.pages() << " (" << t.pages() * 4096 / (1024 * 1024) << " MB), konyvtar melysege: " << t.depth()
+				<< ", a cache " << std::setprecision(1) << (double)t.pages() / 256.0 << "-szorosa" << std::endl;
+
+			std::shuffle(keys.begin(), keys.end(), rng);
+			t.resetStats();
+			int64_t v = 0;
+			size_t found = 0;
+			ns = measureNs([&] { for (int k : keys) found += t.get(k, v); });
+			sink = found;
+			report("get (veletlen sorrend)", ns / n);
+			std::cout << std::setprecision(3) << "    lapolvasas / get: " << (double)t.pageReads() / n
+				<< ", cache talalat: " << (double)t.cacheHits() / (t.cacheHits() + t.pageReads()) << std::endl;
+		}
+		unlink(path.c_str());
+		unlink((path + ".dir").c_str());
+	}
+#endif
+#if BENCHCASE > 8
+	{
+		std::cout << "-- 9: teljes bejaras, 2000000 elem --" << std::endl;
+		const int n = 2000000;
+		HashTable<int, int, linHash, 100000> t;
+		for (int i = 0; i < n; ++i) t.put(i * 7, i);
+		long long sum = 0;
+		double ns = measureNs([&] {
+			for (auto iter = t.begin(); iter != t.end(); ++iter)
+				sum += iter->value;
+		});
+		sink = (size_t)sum;
+		report("iterator, 1 szal", ns / n);
+		for (size_t threads : { 1, 2, 4, 8 }) {
+			ThreadPool pool(threads);
+			ns = measureNs([&] {
+				sum = t.reduce(0LL, [](const int&, const int& v) { return (long long)v; }, [](long long a, long long b) { return a + b; }, pool);
+			});
+			sink = (size_t)sum;
+			report("reduce, " + std::to_string(threads) + " szal", ns / n);
+		}
+	}
+#endif
+#if BENCHCASE > 9
+	{
+		std::cout << "-- 10: RadixTree es HashTable, 500000 szo --" << std::endl;
+		const size_t n = 500000;
+		std::mt19937 rng(3);
+		std::vector<std::string> keys;
+		HashSet<std::string, stdStringHash, 100000> seen;
+		while (keys.size() < n) {
+			std::string k;
+			size_t len = 4 + rng() % 9;
+			for (size_t i = 0; i < len; ++i) k += (char)('a' + rng() % 26);
+			if (seen.insert(k)) keys.push_back(k);
+		}
+		RadixTree<int> rt;
+		HashTable<int, std::string, stdStringHash, 100000> ht;
+		for (size_t i = 0; i < n; ++i) {
+			rt.put(keys[i], (int)i);
+			ht.put(keys[i], (int)i);
+		}
+		std::shuffle(keys.begin(), keys.end(), std::mt19937(9));
+		size_t found = 0;
+		double ns = measureNs([&] {
+			for (const std::string& k : keys) found += (rt.get(k) != nullptr);
+		});
+		report("RadixTree get", ns / n);
+		ns = measureNs([&] {
+			for (const std::string& k : keys) found += (ht.get(k) != nullptr);
+		});
+		report("HashTable get", ns / n);
+
+		// 100 ketbetus prefix; a HashTable-nek minden alkalommal vegig kell mennie az egeszen
+		const int queries = 100;
+		size_t hits = 0;
+		ns = measureNs([&] {
+			for (int q = 0; q < queries; ++q) {
+				std::string p = keys[q].substr(0, 2);
+				rt.prefix(p, [&](const std::string&, int&) { ++hits; });
+			}
+		});
+		report("RadixTree prefix (2 betu)", ns / queries);
+		ns = measureNs([&] {
+			for (int q = 0; q < queries; ++q) {
+				std::string p = keys[q].substr(0, 2);
+				for (auto iter = ht.begin(); iter != ht.end(); ++iter)
+					if (iter->key.compare(0, 2, p) == 0) ++hits;
+			}
+		});
+		report("HashTable teljes bejaras + szures", ns / queries);
+		sink = found + hits;
+	}
+#endif
+#if BENCHCASE > 10
+	{
+		std::cout << "-- 11: 256 byte-os ertekek, 300000 elem, 3 hosszu lancok --" << std::endl;
+		// Negyesevel egy lancba hashelnek: 3 berakott kulcs, a negyedik a sikertelen kereseshez
+		std::vector<int> keys, missing;
+		for (int k : shuffledKeys(400000))
+			(k % 4 == 3 ? missing : keys).push_back(k);
+		{
+			HashTable<Payload, int, quadHash, 30000> t;
+			reportFatValues("HashTable", t, keys, missing);
+		}
+		{
+			SplitHashTable<Payload, int, quadHash, 30000> t;
+			reportFatValues("SplitHashTable", t, keys, missing);
+		}
+	}
+#endif
+#if BENCHCASE > 11
+	{
+		std::cout << "-- 12: huge page-ek, 8000000 elem, veletlen kereses --" << std::endl;
+		const int n = 8000000;
+		std::vector<int> keys = shuffledKeys(n);
+		{
+			HashTable<int, int, linHash, 1 << 20> t;
+			for (int k : keys) t.put(k, k);
+			std::shuffle(keys.begin(), keys.end(), std::mt19937(5));
+			reportTlb("std::allocator (4 KiB lapok)", t, keys);
+		}
+		{
+			HugePageResource res;
+			HugePageHashTable<int, int, linHash, 1 << 20> t(&res);
+			for (int k : keys) t.put(k, k);
+			std::shuffle(keys.begin(), keys.end(), std::mt19937(6));
+			reportTlb("HugePageResource", t, keys);
+			std::cout << "    mappelve: " << res.bytesMapped() / (1 << 20) << " MiB, madvise: " << (res.hugePagesAdvised() ? "ok" : "nem sikerult")
+				<< ", AnonHugePages: " << anonHugePagesKb() / 1024 << " MiB" << std::endl;
+		}
+	}
+#endif
+#if BENCHCASE > 12
+	{
+		std::cout << "-- 13: kotegelt hasheles, 1000000 kulcs (AVX2: " << (batchHashSimd() ? "van" : "nincs") << ") --" << std::endl;
+		const size_t n = 1000000;
+		std::mt19937 rng(13);
+		std::vector<std::string> skeys(n);
+		for (std::string& k : skeys) {
+			size_t len = 8 + rng() % 17;
+			for (size_t i = 0; i < len; ++i) k += (char)('a' + rng() % 26);
+		}
+		std::vector<int> ikeys = shuffledKeys((int)n);
+		std::vector<size_t> out(n);
+		const size_t maxSize = 1000003;
+		double ns = measureNs([&] {
+			for (size_t i = 0; i < n; ++i) out[i] = charCodeHash(skeys[i], maxSize);
+		});
+		report("charCodeHash kulcsonkent", ns / n);
+		ns = measureNs([&] { charCodeHashBatch(skeys.data(), n, maxSize, out.data()); });
+		report("charCodeHashBatch", ns / n);
+		ns = measureNs([&] {
+			for (size_t i = 0; i < n; ++i) out[i] = linHash(ikeys[i], maxSize);
+		});
+		report("linHash kulcsonkent", ns / n);
+		ns = measureNs([&] { linHashBatch(ikeys.data(), n, maxSize, out.data()); });
+		report("linHashBatch", ns / n);
+		sink = out[n / 2];
+
+		// A charCodeHash sok kulcsnal hosszu lancokat ad, ezert a tablat int kulcsokkal merjuk
+		{
+			HashTable<int, int, linHash, 10000> t;
+			ns = measureNs([&] {
+				for (size_t i = 0; i < n; ++i) t.put(ikeys[i], ikeys[i]);
+			});
+			report("put kulcsonkent", ns / n);
+		}
+		HashTable<int, int, linHash, 10000> t;
+		ns = measureNs([&] { t.put_many(ikeys.data(), ikeys.data(), n); });
+		report("put_many", ns / n);
+		std::shuffle(ikeys.begin(), ikeys.end(), std::mt19937(14));
+		size_t found = 0;
+		ns = measureNs([&] {
+			for (size_t i = 0; i < n; ++i) found += t.get(ikeys[i]) != nullptr;
+		});
+		report("get kulcsonkent", ns / n);
+		std::vector<int*> res(n);
+		ns = measureNs([&] { found += t.get_many(ikeys.data(), n, res.data()); });
+		report("get_many", ns / n);
+		sink = found;
+	}
+#endif
+#if BENCHCASE > 13
+	{
+		std::cout << "-- 14: kis tabla veremben: letrehozas, 40 put, 40 get, megszuntetes --" << std::endl;
+		const int rounds = 200000;
+		std::vector<int> keys = shuffledKeys(40);
+		size_t found = 0;
+		double ns = measureNs([&] {
+			for (int r = 0; r < rounds; ++r) {
+				HashTable<int, int, linHash, 64> t;
+				for (int k : keys) t.put(k + r, k);
+				for (int k : keys) found += t.get(k + r) != nullptr;
+			}
+		});
+		report("HashTable<..., 64>", ns / rounds);
+		ns = measureNs([&] {
+			for (int r = 0; r < rounds; ++r) {
+				FixedHashTable<int, int, linHash, 64> t;
+				for (int k : keys) t.put(k + r, k);
+				for (int k : keys) found += t.get(k + r) != nullptr;
+			}
+		});
+		report("FixedHashTable<..., 64>", ns / rounds);
+		sink = found;
+	}
+#endif
+	return 0;
+}
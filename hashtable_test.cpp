@@ -8,12 +8,30 @@
  *********************************************************************/
 
 #include <iostream>
+#include <map>
+#include <random>
 #include "memtrace.h"
 
 #include "fixarray.hpp"
 #include "linkedlist.hpp"
+#include "unrolledlist.hpp"
 #include "harray.hpp"
 #include "hashtable.hpp"
+#include "lruhashtable.hpp"
+#include "ttlhashtable.hpp"
+#include "hashset.hpp"
+#include "kvstore.hpp"
+#include "durabletable.hpp"
+#include "seededhashtable.hpp"
+#include "cuckoohashtable.hpp"
+#include "diskhashtable.hpp"
+#include "persistenthashmap.hpp"
+#include "radixtree.hpp"
+#include "splithashtable.hpp"
+#include "sharedhashtable.hpp"
+#include "hugepageresource.hpp"
+#include "fixedhashtable.hpp"
+#include <sys/wait.h>
 #include "gtest_lite.h"
 
 
@@ -30,8 +48,33 @@
 // 10: TESZT1: felhasznalok.
 // 11: TESZT2: programozasi nyelvek
 // 12: TESZT3: az uj neptun
+// 13: HashTable zsugoritas
+// 14: HashTable allokatorral (std::pmr)
+// 15: HashTable folytonos vodortombbel (FlatLayout)
+// 16: UnrolledList, HashTable kigongyolitett lancokkal (UnrolledChain)
+// 17: LruHashTable
+// 18: TtlHashTable
+// 19: HashSet
+// 20: HashTable insert, find_or_insert, get_or_insert_with
+// 21: HashTable Bloom szurovel
+// 22: KvStore (a kvserver protokollja)
+// 23: DurableHashTable (write-ahead log, visszaallitas)
+// 24: HashTable meresekkel (LatencyInstrumentation)
+// 25: SipHash, SeededHashTable
+// 26: CuckooHashTable
+// 27: HashTable linearis hashelessel
+// 28: DiskHashTable
+// 29: PersistentHashMap
+// 30: Parhuzamos bejaras (for_each_parallel, reduce)
+// 31: erase(iterator), erase_if
+// 32: RadixTree (prefix es tartomany lekerdezesek)
+// 33: SplitHashTable (kulcsok es ertekek kulon)
+// 34: SharedHashTable (tobb folyamat kozos tablaja)
+// 35: HugePageResource (2 MiB-os regiok)
+// 36: Kotegelt (SIMD) hasheles, put_many, get_many
+// 37: FixedHashTable (fix kapacitas, nyilt cimzes)
 
-#define TESTCASE 12
+#define TESTCASE 37
 
 #if TESTCASE > 9 
 #include "felhasznalo_teszt.h"
@@ -61,6 +104,49 @@ public:
 		return *this;
 	}
 };
+/**
+ * Segédclass teszteléshez: megszámolja a rajta keresztül foglalt byte-okat, és kérésre bad_alloc-ot dob.
+ */
+class CountingResource : public std::pmr::memory_resource {
+public:
+	size_t allocated = 0;
+	size_t deallocated = 0;
+	bool fail = false; //< Ha igaz, minden foglalás bad_alloc-ot dob
+	int allowed = -1; //< Ha nem negatív, ennyi foglalás sikerül még, utána bad_alloc
+private:
+	void* do_allocate(size_t bytes, size_t align) override {
+		if (fail || allowed == 0) throw std::bad_alloc();
+		if (allowed > 0) --allowed;
+		allocated += bytes;
+		return std::pmr::new_delete_resource()->allocate(bytes, align);
+	}
+	void do_deallocate(void* p, size_t bytes, size_t align) override {
+		deallocated += bytes;
+		std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+	}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+};
+/**
+ * Segédfüggvény teszteléshez: minden kulcsnak ugyanaz a hash-e.
+ */
+size_t constHash(const int, const size_t) {
+	return 7;
+}
+/**
+ * Segédclass teszteléshez: nagy érték, ami számolja az élő példányait.
+ */
+struct BigValue {
+	static int live; //< Az élő példányok száma
+	char payload[200]; //< Hogy ne férjen egy cache sorba
+	int id; //< Azonosító
+	BigValue(int id = 0) :payload(), id(id) { ++live; }
+	BigValue(const BigValue& rhs) :id(rhs.id) { ++live; }
+	~BigValue() { --live; }
+};
+int BigValue::live = 0;
+
 int main() { 
 #if TESTCASE > 0 
 TEST(FixArray, fixarray_tests) {
@@ -271,6 +357,1555 @@ TEST(TEST3, AzUjNeptun) {
 	 EXPECT_NO_THROW(neptun_teszt());
  } END
 #endif
+#if TESTCASE > 12
+TEST(HashTable, shrink) {
+	 HashTable<int, int, linHash, 3> ht;
+	 for (int i = 0; i < 30; ++i)
+		 ht.put(i, i);
+	 size_t full = ht.size() + ht.capacity(); // a tabla teljes merete
+	 EXPECT_TRUE(full > 30);
+
+	 // A 0.25-os kuszob alatt automatikusan zsugorodnia kell
+	 for (int i = 0; i < 26; ++i)
+		 ht.remove(i);
+	 EXPECT_EQ(4, ht.size());
+	 EXPECT_TRUE(ht.size() + ht.capacity() < full);
+	 for (int i = 26; i < 30; ++i)
+		 EXPECT_FALSE(ht.get(i) == nullptr);
+
+	 // Kikapcsolt automatikus zsugoritas mellett a shrink_to_fit zsugorit
+	 ht.setMinLoadFactor(0);
+	 for (int i = 0; i < 30; ++i)
+		 ht.put(i, i);
+	 for (int i = 1; i < 30; ++i)
+		 ht.remove(i);
+	 EXPECT_TRUE(ht.capacity() > 3);
+	 ht.shrink_to_fit();
+	 EXPECT_EQ(3, ht.size() + ht.capacity());
+	 EXPECT_FALSE(ht.get(0) == nullptr);
+
+	 EXPECT_THROW(ht.setMinLoadFactor(0.5), std::invalid_argument);
+ } END
+#endif
+#if TESTCASE > 13
+TEST(HashTable, pmr) {
+	 CountingResource res;
+	 {
+		 pmr::HashTable<int, int, linHash, 3> ht(&res);
+		 EXPECT_TRUE(res.allocated > 0) << "a tombok nem a resource-bol foglalodtak" << std::endl;
+		 size_t before = res.allocated;
+		 ht.put(1, 1);
+		 EXPECT_TRUE(res.allocated > before) << "a listaelem nem a resource-bol foglalodott" << std::endl;
+		 for (int i = 2; i < 20; ++i)
+			 ht.put(i, i);
+		 // Az ujrahashelt tablanak is ugyanazt a resource-t kell hasznalnia
+		 EXPECT_TRUE(ht.get_allocator().resource() == &res);
+		 for (int i = 1; i < 20; ++i)
+			 EXPECT_FALSE(ht.get(i) == nullptr);
+	 }
+	 EXPECT_EQ(res.allocated, res.deallocated);
+
+	 // Monoton bufferbol, a globalis heap erintese nelkul
+	 char buf[1 << 14];
+	 std::pmr::monotonic_buffer_resource mono(buf, sizeof(buf), std::pmr::null_memory_resource());
+	 pmr::HashTable<int, std::string, charCodeHash, 10> req(&mono);
+	 EXPECT_NO_THROW(req.put("alma", 1));
+	 EXPECT_NO_THROW(req.put("korte", 2));
+	 EXPECT_EQ(2, *req.get("korte"));
+ } END
+#endif
+#if TESTCASE > 14
+TEST(HashTable, flatlayout) {
+	 HashTable<int, int, linHash, 3, std::allocator<int>, FlatLayout> ht;
+	 ht.put(0, 0);
+	 ht.put(1, 1);
+	 ht.put(2, 2);
+	 ht.put(3, 3); // itt kell ujrahashelodnie
+	 std::stringstream ss;
+	 for (auto it = ht.begin(); it != ht.end(); ++it) {
+		 ss << it->value;
+	 }
+	 EXPECT_STREQ("0123", ss.str().c_str());
+	 ht.remove(2);
+	 EXPECT_TRUE(ht.get(2) == nullptr);
+	 EXPECT_EQ(3, ht.size());
+
+	 HArray<int, char, 4, std::allocator<int>, FlatLayout> ha;
+	 EXPECT_EQ(ha.capacity(), 4);
+#ifndef NDEBUG
+	 EXPECT_THROW(ha.add(5, 'a', 1), std::out_of_range);
+#endif
+ } END
+#endif
+#if TESTCASE > 15
+TEST(UnrolledList, remove) {
+	 UnrolledList<int, std::allocator<int>, 3> ll; // 3 elem fer egy listaelembe
+	 EXPECT_TRUE(ll.isEmpty());
+	 for (int i = 1; i <= 7; ++i)
+		 ll.push(i);
+	 ll.remove(2);
+	 ll.remove(2); // Nem kene bajt okoznia
+	 ll.remove(7);
+	 for (int i = 1; i <= 7; ++i) {
+		 if (i == 2 || i == 7)
+			 EXPECT_TRUE(ll.find(i) == nullptr);
+		 else
+			 EXPECT_EQ(i, *ll.find(i));
+	 }
+	 // A getNext-tel vegig kell tudni menni az osszes elemen
+	 int c = 0;
+	 for (int* it = ll.getFirst(); it != nullptr; it = ll.getNext(*it))
+		 ++c;
+	 EXPECT_EQ(5, c);
+	 for (int i = 1; i <= 7; ++i)
+		 ll.remove(i);
+	 EXPECT_TRUE(ll.isEmpty());
+ } END
+TEST(HashTable, unrolledchain) {
+	 HArray<int, std::string, 10, std::allocator<int>, SegmentedLayout, UnrolledChain> ha;
+	 ha.add(0, "a", 1);
+	 ha.add(0, "b", 2);
+	 ha.add(0, "c", 3);
+	 ha.add(0, "d", 4);
+	 ha.add(0, "d", 5); // mar benne van
+	 EXPECT_EQ(4, ha.size());
+	 int sum = 0;
+	 for (auto it = ha.begin(); it != ha.end(); ++it)
+		 sum += it->value;
+	 EXPECT_EQ(10, sum);
+
+	 HashTable<int, int, linHash, 3, std::allocator<int>, SegmentedLayout, UnrolledChain> ht;
+	 for (int i = 0; i < 20; ++i)
+		 ht.put(i, i);
+	 for (int i = 0; i < 20; i += 2)
+		 ht.remove(i);
+	 EXPECT_EQ(10, ht.size());
+	 for (int i = 0; i < 20; ++i)
+		 EXPECT_EQ(i % 2 == 1, ht.get(i) != nullptr);
+ } END
+#endif
+#if TESTCASE > 16
+TEST(LruHashTable, eviction) {
+	 LruHashTable<int, int, linHash, 3> lru(3); // kis tomb, hogy legyenek lancok is
+	 lru.put(1, 1);
+	 lru.put(2, 2);
+	 lru.put(3, 3);
+	 EXPECT_FALSE(lru.get(1) == nullptr); // 1 lesz a legutobb hasznalt
+	 lru.put(4, 4); // ki kell dobnia a 2-t
+	 EXPECT_EQ(3, lru.size());
+	 EXPECT_TRUE(lru.get(2) == nullptr);
+	 EXPECT_EQ(1, *lru.get(1));
+	 EXPECT_EQ(4, *lru.get(4));
+	 lru.put(3, 33); // felulirja, nem dob ki semmit
+	 EXPECT_EQ(1, lru.evictions());
+	 lru.put(5, 5); // az 1 a legregebben hasznalt
+	 EXPECT_TRUE(lru.get(1) == nullptr);
+	 EXPECT_EQ(33, *lru.get(3));
+	 EXPECT_EQ(2, lru.evictions());
+	 EXPECT_EQ(4, lru.hits());
+	 EXPECT_EQ(2, lru.misses());
+
+	 lru.remove(3);
+	 EXPECT_EQ(2, lru.size());
+	 for (int i = 100; i < 200; ++i)
+		 lru.put(i, i);
+	 EXPECT_EQ(3, lru.size());
+	 EXPECT_FALSE(lru.get(199) == nullptr);
+	 EXPECT_TRUE(lru.get(196) == nullptr);
+	 EXPECT_THROW(LruHashTable<int> nulla(0), std::invalid_argument);
+
+	 // Ha az elem foglalasa dob, a cache nem valtozik: nincs kidobas, es a kulcs sem marad bent
+	 CountingResource res;
+	 LruHashTable<int, int, linHash, 10, std::pmr::polymorphic_allocator<int>> guarded(4, &res);
+	 for (int i = 1; i <= 4; ++i)
+		 guarded.put(i, i);
+	 res.allowed = 1; // A tabla lancelemenek foglalasa sikerul, az LRU elemee nem
+	 EXPECT_THROW(guarded.put(5, 5), std::bad_alloc);
+	 res.allowed = -1;
+	 EXPECT_EQ(4, guarded.size());
+	 EXPECT_EQ(0, guarded.evictions());
+	 EXPECT_TRUE(guarded.get(5) == nullptr);
+	 for (int i = 1; i <= 4; ++i)
+		 EXPECT_EQ(i, *guarded.get(i));
+	 guarded.put(5, 5); // az 1 a legregebben hasznalt
+	 EXPECT_TRUE(guarded.get(1) == nullptr);
+	 EXPECT_EQ(5, *guarded.get(5));
+	 EXPECT_EQ(1, guarded.evictions());
+ } END
+TEST(HashTable, reserve) {
+	 HashTable<int, int, linHash, 10> ht;
+	 ht.reserve(100);
+	 size_t full = ht.size() + ht.capacity();
+	 EXPECT_TRUE(full >= 112);
+	 for (int i = 0; i < 100; ++i)
+		 ht.put(i, i);
+	 EXPECT_EQ(full, ht.size() + ht.capacity()); // Nem nott kozben
+	 ht.reserve(10); // Nem zsugorit
+	 EXPECT_EQ(full, ht.size() + ht.capacity());
+ } END
+#endif
+#if TESTCASE > 17
+TEST(TtlHashTable, expiry) {
+	 TtlHashTable<int, int, linHash, 10> ttl;
+	 ttl.put(1, 1, 1);
+	 ttl.put(2, 2, 70); // 1. szintre kerul
+	 ttl.put(3, 3, 5000); // 2. szintre kerul
+	 ttl.put(4, 4); // soha nem jar le
+	 ttl.put(5, 5, 3);
+	 ttl.put(5, 55, 10); // uj lejarat
+	 EXPECT_EQ(5, ttl.size());
+
+	 EXPECT_EQ(1, ttl.expire_tick());
+	 EXPECT_TRUE(ttl.get(1) == nullptr);
+	 size_t expired = 0;
+	 for (int i = 1; i < 10; ++i)
+		 expired += ttl.expire_tick();
+	 EXPECT_EQ(1, expired);
+	 EXPECT_TRUE(ttl.get(5) == nullptr);
+	 EXPECT_EQ(2, *ttl.get(2));
+
+	 // Pontosan a lejarat tickjeben kell felszabadulnia
+	 while (ttl.now() < 69)
+		 EXPECT_EQ(0, ttl.expire_tick());
+	 EXPECT_EQ(1, ttl.expire_tick());
+	 EXPECT_TRUE(ttl.get(2) == nullptr);
+	 while (ttl.now() < 4999)
+		 EXPECT_EQ(0, ttl.expire_tick());
+	 EXPECT_EQ(3, *ttl.get(3));
+	 EXPECT_EQ(1, ttl.expire_tick());
+	 EXPECT_EQ(1, ttl.size());
+	 EXPECT_EQ(4, *ttl.get(4));
+
+	 // Lusta lejarat: a get mar nem adja vissza
+	 TtlHashTable<std::string> lazy;
+	 lazy.put("session", "adat", 1);
+	 lazy.expire_tick();
+	 lazy.put("masik", "adat", 2);
+	 lazy.remove("masik");
+	 EXPECT_TRUE(lazy.get("session") == nullptr);
+	 EXPECT_EQ(0, lazy.size());
+ } END
+#endif
+#if TESTCASE > 18
+TEST(HashSet, insert) {
+	 // Az elem csak a kulcsot tarolja
+	 EXPECT_EQ(sizeof(std::string), sizeof(HArray<NoValue, std::string>::HashItem));
+
+	 HashSet<std::string> hs;
+	 EXPECT_TRUE(hs.insert("Java"));
+	 EXPECT_TRUE(hs.insert("JavaScript"));
+	 EXPECT_FALSE(hs.insert("Java"));
+	 EXPECT_EQ(2, hs.size());
+	 EXPECT_TRUE(hs.contains("JavaScript"));
+	 EXPECT_FALSE(hs.contains("C"));
+	 hs.remove("Java");
+	 EXPECT_FALSE(hs.contains("Java"));
+
+	 HashSet<int, linHash, 3> szamok;
+	 for (int i = 0; i < 10; ++i)
+		 szamok.insert(i % 5);
+	 EXPECT_EQ(5, szamok.size());
+	 int sum = 0;
+	 for (auto it = szamok.begin(); it != szamok.end(); ++it)
+		 sum += it->key;
+	 EXPECT_EQ(10, sum);
+ } END
+#endif
+#if TESTCASE > 19
+TEST(HashTable, insert) {
+	 HashTable<int, int, linHash, 3> ht;
+	 auto res = ht.insert(1, 10);
+	 EXPECT_TRUE(res.second);
+	 EXPECT_EQ(1, res.first->key);
+	 EXPECT_EQ(10, res.first->value);
+	 res = ht.insert(1, 20); // mar benne van, nem irja felul
+	 EXPECT_FALSE(res.second);
+	 EXPECT_EQ(10, res.first->value);
+	 EXPECT_TRUE(ht.put(2, 2));
+	 EXPECT_FALSE(ht.put(2, 3));
+
+	 // Tele tablaban a mar meglevo kulcs nem noveli a tablat
+	 ht.put(0, 0);
+	 size_t full = ht.size() + ht.capacity();
+	 EXPECT_FALSE(ht.insert(0, 1).second);
+	 EXPECT_FALSE(ht.find_or_insert(1).second);
+	 EXPECT_EQ(full, ht.size() + ht.capacity());
+	 // Uj kulcsnal novekszik, es az iterator az uj elemre mutat
+	 res = ht.find_or_insert(5);
+	 EXPECT_TRUE(res.second);
+	 EXPECT_EQ(5, res.first->key);
+	 EXPECT_EQ(0, res.first->value);
+	 EXPECT_TRUE(ht.size() + ht.capacity() > full);
+
+	 // Az iterator tudja az elem cimet es helyet: az elerese es a torlese sem keres ujra
+	 HashTable<int, int, constHash, 1000> chain; // Minden kulcs ugyanoda: egy hosszu lanc
+	 for (int i = 0; i < 100; ++i)
+		 chain.put(i, i);
+	 auto found = chain.find_or_insert(50);
+	 found.first->value = 500;
+	 EXPECT_EQ(500, *chain.get(50));
+	 chain.erase(found.first);
+	 found = chain.insert(200, 2);
+	 chain.erase(found.first);
+	 EXPECT_EQ((size_t)99, chain.size());
+	 EXPECT_FALSE(chain.contains(50) || chain.contains(200));
+	 for (int i = 0; i < 100; ++i)
+		 EXPECT_EQ(i != 50, chain.contains(i));
+
+	 HashTable<std::string, std::string> nyelvek;
+	 int hivasok = 0;
+	 auto factory = [&hivasok]() { ++hivasok; return std::string("https://"); };
+	 nyelvek.get_or_insert_with("C", factory) += "c";
+	 EXPECT_STREQ("https://c", nyelvek.get_or_insert_with("C", factory).c_str());
+	 EXPECT_EQ(1, hivasok) << "a factory-t csak uj kulcsnal kell meghivni" << std::endl;
+ } END
+#endif
+#if TESTCASE > 20
+TEST(HashTable, bloomfilter) {
+	 HashTable<int, std::string, charCodeHash, 100> ht;
+	 ht.put("mar bent", 0);
+	 ht.enableBloomFilter(10);
+	 EXPECT_FALSE(ht.get("mar bent") == nullptr) << "a bekapcsolaskor mar bent levo kulcs elveszett" << std::endl;
+	 for (int i = 0; i < 500; ++i)
+		 ht.put("kulcs" + std::to_string(i), i); // tobbszor is novekszik, a szuronek ujra kell epulnie
+	 for (int i = 0; i < 500; ++i)
+		 EXPECT_EQ(i, *ht.get("kulcs" + std::to_string(i)));
+
+	 for (int i = 0; i < 1000; ++i)
+		 EXPECT_TRUE(ht.get("nincs" + std::to_string(i)) == nullptr);
+	 BloomStats st = ht.bloomStats();
+	 EXPECT_TRUE(st.memoryBytes > 0);
+	 EXPECT_TRUE(st.filtered > 900) << "a szuro alig szurt: " << st.filtered << std::endl;
+	 EXPECT_TRUE(st.falsePositiveRate() < 0.1);
+	 EXPECT_TRUE(st.estimatedFalsePositiveRate < 0.1);
+
+	 // A torolt kulcsok a zsugoritaskor kikerulnek a szurobol is
+	 for (int i = 0; i < 500; ++i)
+		 ht.remove("kulcs" + std::to_string(i));
+	 EXPECT_TRUE(ht.bloomStats().keys < 100);
+	 EXPECT_FALSE(ht.contains("kulcs1"));
+	 EXPECT_TRUE(ht.contains("mar bent"));
+
+	 ht.enableBloomFilter(0);
+	 EXPECT_EQ(0, ht.bloomStats().memoryBytes);
+	 EXPECT_TRUE(ht.contains("mar bent"));
+ } END
+#endif
+
+#if TESTCASE > 21
+TEST(KvStore, protocol) {
+	 KvStore store(2);
+	 std::string req, resp;
+	 kv::encodePut(req, 0, "alma", "piros");
+	 kv::encodePut(req, 1, "alma", "zold");
+	 kv::encodeGet(req, 0, "alma");
+	 kv::encodeGet(req, 0, "korte");
+	 kv::encodePut(req, 0, "alma", "sarga"); // felulirja
+	 kv::encodeMget(req, 0, { "alma", "korte" });
+	 kv::encodeDel(req, 1, "alma");
+	 kv::encodeDel(req, 1, "alma");
+	 kv::encodeGet(req, 5, "alma"); // nincs ilyen tabla
+
+	 // Az utolso kerest csak felig kuldjuk el
+	 size_t done = store.process(req.data(), req.size() - 3, resp);
+	 EXPECT_TRUE(done < req.size() - 3);
+	 done += store.process(req.data() + done, req.size() - done, resp);
+	 EXPECT_EQ(req.size(), done);
+	 EXPECT_EQ((size_t)1, store.size(0));
+	 EXPECT_EQ((size_t)0, store.size(1));
+
+	 // A 16 bites hosszmezokbe nem fero kulcs vagy darabszam nem csonkolodhat: kivetel, es nem ir semmit
+	 std::string tooLong;
+	 EXPECT_THROW(kv::encodeGet(tooLong, 0, std::string(70000, 'k')), std::length_error);
+	 EXPECT_THROW(kv::encodePut(tooLong, 0, std::string(70000, 'k'), "v"), std::length_error);
+	 EXPECT_THROW(kv::encodeDel(tooLong, 0, std::string(70000, 'k')), std::length_error);
+	 EXPECT_THROW(kv::encodeMget(tooLong, 0, std::vector<std::string>(70000, "k")), std::length_error);
+	 EXPECT_THROW(kv::encodeMget(tooLong, 0, { "k", std::string(70000, 'k') }), std::length_error);
+	 EXPECT_TRUE(tooLong.empty());
+
+	 // Valaszok sorban
+	 const char* p = resp.data();
+	 const char* end = p + resp.size();
+	 std::vector<std::string> frames;
+	 size_t frame;
+	 while ((frame = kv::frameLength(p, end - p)) != 0) {
+		 frames.push_back(std::string(p + 4, frame - 4));
+		 p += frame;
+	 }
+	 EXPECT_TRUE(p == end);
+	 EXPECT_EQ((size_t)9, frames.size());
+	 EXPECT_EQ(std::string(1, (char)kv::OK), frames[0]);
+	 EXPECT_EQ(std::string(1, (char)kv::OK), frames[1]);
+	 EXPECT_EQ((int)kv::OK, (int)frames[2][0]);
+	 EXPECT_EQ((uint32_t)5, kv::getU32(frames[2].data() + 1));
+	 EXPECT_EQ(std::string("piros"), frames[2].substr(5));
+	 EXPECT_EQ(std::string(1, (char)kv::NOT_FOUND), frames[3]);
+	 // MGET: OK, 2 darab, (1, 5, "sarga"), (0)
+	 EXPECT_EQ((int)kv::OK, (int)frames[5][0]);
+	 EXPECT_EQ((uint16_t)2, kv::getU16(frames[5].data() + 1));
+	 EXPECT_EQ(1, (int)frames[5][3]);
+	 EXPECT_EQ(std::string("sarga"), frames[5].substr(8, 5));
+	 EXPECT_EQ(0, (int)frames[5][13]);
+	 EXPECT_EQ(std::string(1, (char)kv::OK), frames[6]);
+	 EXPECT_EQ(std::string(1, (char)kv::NOT_FOUND), frames[7]);
+	 EXPECT_EQ(std::string(1, (char)kv::ERROR), frames[8]);
+
+	 // Csonka keret belseje: hibas valasz, a kapcsolat mehet tovabb
+	 std::string bad, badResp;
+	 size_t s = kv::begin(bad);
+	 kv::putU8(bad, kv::PUT); kv::putU8(bad, 0); kv::putU16(bad, 100);
+	 kv::finish(bad, s);
+	 EXPECT_EQ(bad.size(), store.process(bad.data(), bad.size(), badResp));
+	 EXPECT_EQ(std::string("\x01\0\0\0\x02", 5), badResp);
+
+	 // Tul hosszu keret
+	 std::string huge;
+	 kv::putU32(huge, (uint32_t)kv::maxFrame + 1);
+	 EXPECT_THROW(store.process(huge.data(), huge.size(), badResp), std::length_error);
+ } END
+#endif
+
+#if TESTCASE > 22
+TEST(DurableHashTable, recovery) {
+	 const std::string dir = "wal_teszt";
+	 auto clean = [&dir]() {
+		 if (DIR* d = opendir(dir.c_str())) {
+			 while (dirent* e = readdir(d))
+				 if (e->d_name[0] != '.') unlink((dir + "/" + e->d_name).c_str());
+			 closedir(d);
+		 }
+		 rmdir(dir.c_str());
+	 };
+	 clean();
+	 {
+		 DurableHashTable<int> t(dir, SyncPolicy::Batch, 16);
+		 for (int i = 0; i < 100; ++i)
+			 EXPECT_TRUE(t.put("kulcs" + std::to_string(i), i));
+		 EXPECT_FALSE(t.put("kulcs1", 1000)); // mar bent van, nem irja felul
+		 t.assign("kulcs2", 2000);
+		 t.remove("kulcs3");
+		 t.remove("nincs");
+	 } // a destruktor commitol
+	 {
+		 DurableHashTable<int> t(dir, SyncPolicy::EveryOp);
+		 EXPECT_EQ((size_t)99, t.size());
+		 EXPECT_EQ(1, *t.get("kulcs1"));
+		 EXPECT_EQ(2000, *t.get("kulcs2"));
+		 EXPECT_FALSE(t.contains("kulcs3"));
+		 t.put("utolso", 7);
+	 }
+	 // Osszeomlas irasa kozben: felig kiirt rekord a log vegen
+	 {
+		 int fd = open((dir + "/wal.0").c_str(), O_WRONLY | O_APPEND);
+		 EXPECT_TRUE(fd >= 0);
+		 const char torn[] = "\x20\0\0\0\x12\x34";
+		 EXPECT_EQ((ssize_t)6, write(fd, torn, 6));
+		 close(fd);
+	 }
+	 {
+		 DurableHashTable<int> t(dir, SyncPolicy::None);
+		 EXPECT_EQ((size_t)100, t.size());
+		 EXPECT_EQ(7, *t.get("utolso"));
+		 t.put("a levagott rekord utan", 8);
+		 t.setCompactionThreshold(1); // minden iras utan tomorit
+		 t.put("tomorites utan", 9);
+		 t.waitForCompaction();
+		 EXPECT_EQ((size_t)0, t.logBytes());
+		 t.remove("kulcs0");
+		 t.compact();
+	 }
+	 {
+		 std::string dummy;
+		 EXPECT_FALSE(wal::readFile(dir + "/wal.0", dummy)) << "a regi log nem torlodott" << std::endl;
+		 DurableHashTable<int> t(dir);
+		 EXPECT_EQ((size_t)101, t.size());
+		 EXPECT_EQ(8, *t.get("a levagott rekord utan"));
+		 EXPECT_EQ(9, *t.get("tomorites utan"));
+		 EXPECT_FALSE(t.contains("kulcs0"));
+		 EXPECT_EQ(2000, *t.get("kulcs2"));
+	 }
+
+	 // Serult rekord egy korabbi logban: ott megall, a kesobbi logot nem jatssza le ra.
+	 // Az idegen fajlokat (wal.x, snapshot.bak) kihagyja.
+	 clean();
+	 mkdir(dir.c_str(), 0755);
+	 auto writeLog = [&dir](const std::string& name, const std::vector<std::pair<std::string, int>>& puts, size_t corrupt) {
+		 std::string data;
+		 for (size_t i = 0; i < puts.size(); ++i) {
+			 size_t s = wal::begin(data);
+			 data.push_back((char)wal::PUT);
+			 wal::encode(data, puts[i].first);
+			 wal::encode(data, puts[i].second);
+			 wal::finish(data, s);
+			 if (i == corrupt) data[s + 4] ^= 1; // rossz CRC
+		 }
+		 int fd = open((dir + "/" + name).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		 EXPECT_EQ((ssize_t)data.size(), write(fd, data.data(), data.size()));
+		 close(fd);
+	 };
+	 writeLog("wal.0", { { "a", 1 }, { "b", 2 }, { "c", 3 } }, 1);
+	 writeLog("wal.1", { { "d", 4 } }, 99);
+	 writeLog("wal.x", { { "e", 5 } }, 99);
+	 writeLog("snapshot.bak", { { "f", 6 } }, 99);
+	 {
+		 DurableHashTable<int> t(dir);
+		 EXPECT_EQ((size_t)1, t.size());
+		 EXPECT_EQ(1, *t.get("a"));
+		 EXPECT_FALSE(t.contains("c"));
+		 EXPECT_FALSE(t.contains("d"));
+		 t.put("g", 7);
+	 }
+	 {
+		 std::string dummy;
+		 EXPECT_FALSE(wal::readFile(dir + "/wal.1", dummy)) << "a serult log utani log megmaradt" << std::endl;
+		 EXPECT_TRUE(wal::readFile(dir + "/wal.x", dummy));
+		 DurableHashTable<int> t(dir);
+		 EXPECT_EQ((size_t)2, t.size());
+		 EXPECT_EQ(7, *t.get("g"));
+	 }
+	 clean();
+ } END
+#endif
+
+#if TESTCASE > 23
+TEST(LatencyHistogram, percentile) {
+	 LatencyHistogram h;
+	 EXPECT_EQ((uint64_t)0, h.percentile(99));
+	 for (uint64_t v = 1; v <= 1000; ++v)
+		 h.add(v);
+	 h.add(1000000);
+	 EXPECT_EQ((uint64_t)1001, h.count());
+	 EXPECT_EQ((uint64_t)1, h.min());
+	 EXPECT_EQ((uint64_t)1000000, h.max());
+	 // A vodrok legfeljebb 1/16 relativ hibaval adjak vissza az erteket
+	 EXPECT_TRUE(h.percentile(50) >= 500 && h.percentile(50) <= 500 + 500 / 16) << h.percentile(50) << std::endl;
+	 EXPECT_TRUE(h.percentile(99) >= 990 && h.percentile(99) <= 990 + 990 / 16) << h.percentile(99) << std::endl;
+	 EXPECT_EQ((uint64_t)1000000, h.percentile(100));
+ } END
+
+TEST(HashTable, instrumentation) {
+	 // Alapbol nem mer, es nem is foglal helyet
+	 struct OneByte : NoInstrumentation { char c; };
+	 typedef HashTable<int, int, linHash, 10, std::allocator<int>, SegmentedLayout, LinkedChain, OneByte> oneByteTable;
+	 EXPECT_TRUE(sizeof(HashTable<int, int, linHash, 10>) < sizeof(oneByteTable));
+
+	 HashTable<int, int, linHash, 10, std::allocator<int>, SegmentedLayout, LinkedChain, LatencyInstrumentation> ht;
+	 for (int i = 0; i < 100; ++i)
+		 ht.put(i, i);
+	 for (int i = 0; i < 200; ++i)
+		 ht.get(i);
+	 ht.contains(5);
+	 for (int i = 0; i < 95; ++i)
+		 ht.remove(i);
+
+	 const LatencyInstrumentation& m = ht.instrumentation();
+	 EXPECT_EQ((uint64_t)100, m.histogram(HashOp::Put).count());
+	 EXPECT_EQ((uint64_t)201, m.histogram(HashOp::Get).count());
+	 EXPECT_EQ((uint64_t)95, m.histogram(HashOp::Remove).count());
+	 EXPECT_TRUE(m.rehashCount() > 0);
+	 EXPECT_EQ(m.rehashCount(), m.histogram(HashOp::Rehash).count());
+	 EXPECT_TRUE(m.histogram(HashOp::Put).max() >= m.histogram(HashOp::Put).percentile(50));
+
+	 // Az elso rehash a 10 elemes tomb 90%-anal, egy put miatt tortent
+	 EXPECT_EQ((int)HashOp::Put, (int)m.event(0).cause);
+	 EXPECT_EQ((size_t)9, m.event(0).elements);
+	 EXPECT_EQ((size_t)10, m.event(0).fromBuckets);
+	 EXPECT_EQ((size_t)20, m.event(0).toBuckets);
+	 // Az utolso egy zsugoritas volt
+	 const RehashEvent& last = m.event(m.eventCount() - 1);
+	 EXPECT_EQ((int)HashOp::Remove, (int)last.cause);
+	 EXPECT_TRUE(last.toBuckets < last.fromBuckets);
+
+	 std::ostringstream text, json;
+	 m.dump(text);
+	 m.dump(json, LatencyInstrumentation::Json);
+	 EXPECT_TRUE(text.str().find("get: count=201") != std::string::npos) << text.str() << std::endl;
+	 EXPECT_TRUE(json.str().find("\"put\":{\"count\":100,") != std::string::npos) << json.str() << std::endl;
+	 EXPECT_TRUE(json.str().find("\"cause\":\"remove\"") != std::string::npos);
+
+	 // Idokozonkenti kiiras: 0 periodussal minden muvelet utan
+	 std::ostringstream periodic;
+	 ht.instrumentation().dumpEvery(&periodic, std::chrono::nanoseconds(0));
+	 ht.get(1);
+	 ht.get(2);
+	 ht.instrumentation().dumpEvery(nullptr, std::chrono::nanoseconds(0));
+	 ht.get(3);
+	 size_t dumps = 0;
+	 for (size_t pos = 0; (pos = periodic.str().find("rehashes:", pos)) != std::string::npos; ++pos)
+		 ++dumps;
+	 EXPECT_EQ((size_t)2, dumps);
+
+	 ht.instrumentation().reset();
+	 EXPECT_EQ((uint64_t)0, ht.instrumentation().histogram(HashOp::Get).count());
+ } END
+#endif
+
+#if TESTCASE > 24
+TEST(SipHash, vectors) {
+	 // A SipHash referencia implementacio tesztvektorai: kulcs 00..0f, uzenet 00..(n-1)
+	 unsigned char msg[64];
+	 for (int i = 0; i < 64; ++i) msg[i] = (unsigned char)i;
+	 uint64_t k0 = 0x0706050403020100ULL, k1 = 0x0f0e0d0c0b0a0908ULL;
+	 EXPECT_EQ(0x726fdb47dd0e0e31ULL, SipHash24::hash(msg, 0, k0, k1));
+	 EXPECT_EQ(0x74f839c593dc67fdULL, SipHash24::hash(msg, 1, k0, k1));
+	 EXPECT_EQ(0x93f5f5799a932462ULL, SipHash24::hash(msg, 8, k0, k1));
+	 EXPECT_EQ(0xa129ca6149be45e5ULL, SipHash24::hash(msg, 15, k0, k1));
+	 EXPECT_FALSE(SipHash13::hash(msg, 15, k0, k1) == SipHash13::hash(msg, 15, k0 + 1, k1));
+ } END
+
+TEST(SeededHashTable, flood) {
+	 // charCodeHash csak a sum(key[i] * i)-tol fugg: ha a-t b-vel, b-t a-val csokkentjuk, a hash nem valtozik
+	 std::vector<std::string> evil;
+	 {
+		 std::string k = "mmmmmmmm";
+		 std::mt19937 rng(1);
+		 HashSet<std::string> seen;
+		 while (evil.size() < 300) {
+			 size_t a = 1 + rng() % 7, b = 1 + rng() % 7;
+			 if (a == b || k[a] + b > 'z' || k[b] - a < 'a') continue;
+			 k[a] += (char)b;
+			 k[b] -= (char)a;
+			 if (seen.insert(k)) evil.push_back(k);
+		 }
+	 }
+	 for (const std::string& k : evil)
+		 EXPECT_EQ(charCodeHash(evil[0], 100000), charCodeHash(k, 100000));
+
+	 HashTable<int, std::string, charCodeHash, 100> weak;
+	 SeededHashTable<int, 100> strong(1, 2);
+	 for (size_t i = 0; i < evil.size(); ++i) {
+		 weak.put(evil[i], (int)i);
+		 strong.put(evil[i], (int)i);
+	 }
+	 EXPECT_EQ((size_t)300, weak.chainLength(evil[0])) << "mind egy lancba kerult" << std::endl;
+	 EXPECT_EQ((size_t)300, strong.size());
+	 EXPECT_EQ((size_t)0, strong.reseedCount());
+	 for (size_t i = 0; i < evil.size(); ++i)
+		 EXPECT_EQ((int)i, *strong.get(evil[i]));
+	 strong.remove(evil[0]);
+	 EXPECT_FALSE(strong.contains(evil[0]));
+	 EXPECT_FALSE(strong.put(evil[1], -1));
+
+	 // Tul szigoru kuszob: ujrasorsol, az elemek megmaradnak
+	 SeededHashTable<int, 10, SipHash24> tiny(3, 4);
+	 tiny.setMaxChainLength(1);
+	 for (int i = 0; i < 200; ++i)
+		 tiny.put("kulcs" + std::to_string(i), i);
+	 EXPECT_TRUE(tiny.reseedCount() > 0);
+	 EXPECT_TRUE(tiny.maxChainLength() > 1);
+	 EXPECT_EQ((size_t)200, tiny.size());
+	 for (int i = 0; i < 200; ++i)
+		 EXPECT_EQ(i, *tiny.get("kulcs" + std::to_string(i)));
+
+	 // Az ujrasorsolas megtartja a Bloom szurot
+	 SeededHashTable<int, 10> filtered(5, 6);
+	 filtered.enableBloomFilter(10);
+	 filtered.setMaxChainLength(1);
+	 for (int i = 0; i < 200; ++i)
+		 filtered.put("kulcs" + std::to_string(i), i);
+	 EXPECT_TRUE(filtered.reseedCount() > 0);
+	 for (int i = 0; i < 200; ++i)
+		 EXPECT_FALSE(filtered.contains("nincs" + std::to_string(i)));
+	 EXPECT_TRUE(filtered.bloomStats().filtered > 150) << filtered.bloomStats().filtered << std::endl;
+	 EXPECT_EQ(199, *filtered.get("kulcs199"));
+
+	 // Ha az ujraepites kozben kivetel repul, a regi kulcs es tabla marad
+	 CountingResource res;
+	 SeededHashTable<int, 10, SipHash13, std::pmr::polymorphic_allocator<int>> guarded(7, 8, &res);
+	 guarded.setMaxChainLength(0);
+	 for (int i = 0; i < 100; ++i)
+		 guarded.put("kulcs" + std::to_string(i), i);
+	 res.fail = true;
+	 EXPECT_THROW(guarded.reseed(), std::bad_alloc);
+	 res.fail = false;
+	 int lost = 0;
+	 for (int i = 0; i < 100; ++i)
+		 if (guarded.get("kulcs" + std::to_string(i)) == nullptr) ++lost;
+	 EXPECT_EQ(0, lost);
+ } END
+#endif
+
+#if TESTCASE > 25
+TEST(CuckooHashTable, basic) {
+	 CuckooHashTable<std::string, std::string> ct;
+	 EXPECT_TRUE(ct.put("alma", "piros"));
+	 EXPECT_FALSE(ct.put("alma", "zold"));
+	 EXPECT_EQ(std::string("piros"), *ct.get("alma"));
+	 EXPECT_TRUE(ct.get("korte") == nullptr);
+	 ct.remove("alma");
+	 ct.remove("alma");
+	 EXPECT_FALSE(ct.contains("alma"));
+	 EXPECT_EQ((size_t)0, ct.size());
+
+	 // Novekedes sok elemmel, a kiszoritott es a tartalekba kerult elemek sem vesznek el
+	 CuckooHashTable<int, int, linHash> it(4);
+	 for (int i = 0; i < 20000; ++i)
+		 EXPECT_TRUE(it.put(i * 7919, i));
+	 EXPECT_EQ((size_t)20000, it.size());
+	 EXPECT_TRUE(it.growths() > 0);
+	 EXPECT_TRUE(it.loadFactorAtGrowth() > 0.5) << "tul korai novekedes: " << it.loadFactorAtGrowth() << std::endl;
+	 for (int i = 0; i < 20000; ++i)
+		 EXPECT_EQ(i, *it.get(i * 7919));
+	 for (int i = 0; i < 20000; i += 2)
+		 it.remove(i * 7919);
+	 EXPECT_EQ((size_t)10000, it.size());
+	 for (int i = 0; i < 20000; ++i)
+		 EXPECT_EQ(i % 2 == 1, it.contains(i * 7919));
+ } END
+
+TEST(CuckooHashTable, stash) {
+	 // Ket vodorbol indulva sokszor kell athelyezni, tartalekba tenni es noni
+	 typedef CuckooHashTable<int, int, linHash> table;
+	 table ct(1);
+	 for (int i = 0; i < 300; ++i)
+		 ct.put(i, -i);
+	 for (int i = 0; i < 300; ++i)
+		 EXPECT_EQ(-i, *ct.get(i));
+	 EXPECT_TRUE(ct.stashed() <= table::stashSize);
+	 EXPECT_EQ((size_t)300, ct.size());
+	 for (int i = 0; i < 300; ++i)
+		 ct.remove(i);
+	 EXPECT_EQ((size_t)0, ct.stashed());
+	 EXPECT_EQ((size_t)0, ct.size());
+ } END
+#endif
+
+#if TESTCASE > 26
+TEST(HashTable, linearhashing) {
+	 HashTable<int, int, linHash, 10, std::allocator<int>, SegmentedLayout, LinkedChain, LatencyInstrumentation> ht;
+	 ht.enableLinearHashing();
+	 for (int i = 0; i < 900; ++i)
+		 EXPECT_TRUE(ht.put(i * 3, i));
+	 for (int i = 0; i < 900; ++i)
+		 EXPECT_EQ(i, *ht.get(i * 3));
+	 EXPECT_FALSE(ht.contains(1));
+	 // Egy put legfeljebb egy vodrot valaszt ketteve, nem hashel ujra mindent
+	 const LatencyInstrumentation& m = ht.instrumentation();
+	 EXPECT_TRUE(m.rehashCount() > 50);
+	 for (size_t e = 0; e < m.eventCount(); ++e) {
+		 EXPECT_TRUE(m.event(e).elements <= 5) << m.event(e).elements << std::endl;
+		 EXPECT_EQ(m.event(e).fromBuckets + 1, m.event(e).toBuckets);
+	 }
+
+	 // A szetvalasztas atlancolja a listaelemeket, igy minden pointer ervenyes marad
+	 std::vector<int*> ptrs;
+	 for (int i = 0; i < 900; ++i)
+		 ptrs.push_back(ht.get(i * 3));
+	 int moved = 0;
+	 for (int i = 900; i < 1000; ++i)
+		 ht.put(i * 3, i);
+	 for (int i = 0; i < 900; ++i) {
+		 if (ptrs[i] != ht.get(i * 3)) ++moved;
+		 else EXPECT_EQ(i, *ptrs[i]);
+	 }
+	 EXPECT_EQ(0, moved);
+
+	 // Torles, zsugoritas, majd ujra novekedes
+	 for (int i = 0; i < 1000; i += 2)
+		 ht.remove(i * 3);
+	 ht.shrink_to_fit();
+	 for (int i = 0; i < 1000; ++i)
+		 EXPECT_EQ(i % 2 == 1, ht.contains(i * 3));
+	 for (int i = 1000; i < 1500; ++i)
+		 ht.put(i * 3, i);
+	 EXPECT_EQ((size_t)1000, ht.size());
+	 int iterated = 0;
+	 for (auto iter = ht.begin(); iter != ht.end(); ++iter)
+		 ++iterated;
+	 EXPECT_EQ(1000, iterated);
+
+	 // Kigongyolitett lancokkal es string kulcsokkal is
+	 HashTable<int, std::string, charCodeHash, 16, std::allocator<int>, SegmentedLayout, UnrolledChain> st;
+	 st.enableLinearHashing();
+	 for (int i = 0; i < 500; ++i)
+		 st.put("kulcs" + std::to_string(i), i);
+	 for (int i = 0; i < 500; ++i)
+		 EXPECT_EQ(i, *st.get("kulcs" + std::to_string(i)));
+
+	 // A Bloom szuro a kulcsok szama szerint epul ujra, nem szintenkent, igy nem telik tul
+	 st.enableBloomFilter(10);
+	 for (int i = 500; i < 5000; ++i) {
+		 st.put("kulcs" + std::to_string(i), i);
+		 EXPECT_TRUE(st.bloomStats().estimatedFalsePositiveRate < 0.02) << i << std::endl;
+	 }
+	 for (int i = 0; i < 5000; ++i)
+		 EXPECT_FALSE(st.get("nincs" + std::to_string(i)) != nullptr);
+	 EXPECT_TRUE(st.bloomStats().falsePositiveRate() < 0.03) << st.bloomStats().falsePositiveRate() << std::endl;
+
+	 HashTable<int, int, linHash, 10, std::allocator<int>, FlatLayout> flat;
+	 EXPECT_THROW(flat.enableLinearHashing(), std::invalid_argument);
+	 flat.enableLinearHashing(false);
+ } END
+#endif
+
+#if TESTCASE > 27
+TEST(DiskHashTable, basic) {
+	 const std::string path = "disk_teszt.dat";
+	 unlink(path.c_str());
+	 unlink((path + ".dir").c_str());
+	 {
+		 // Kis lapok es 4 lapos cache, hogy sok kettevalasztas es kidobas legyen
+		 DiskHashTable<std::string, int, linHash, 512> dt(path, 4);
+		 for (int i = 0; i < 3000; ++i)
+			 EXPECT_TRUE(dt.put(i, "ertek" + std::to_string(i)));
+		 EXPECT_FALSE(dt.put(5, "masik"));
+		 EXPECT_EQ((size_t)3000, dt.size());
+		 EXPECT_TRUE(dt.depth() > 4);
+		 EXPECT_TRUE(dt.pageWrites() > 0);
+
+		 std::string v;
+		 dt.resetStats();
+		 for (int i = 0; i < 3000; ++i) {
+			 EXPECT_TRUE(dt.get(i, v));
+			 EXPECT_EQ("ertek" + std::to_string(i), v);
+		 }
+		 // Egy get legfeljebb egy lapot olvas be
+		 EXPECT_TRUE(dt.pageReads() <= 3000);
+		 EXPECT_FALSE(dt.get(3000, v));
+
+		 for (int i = 0; i < 3000; i += 3)
+			 EXPECT_TRUE(dt.remove(i));
+		 EXPECT_FALSE(dt.remove(0));
+		 dt.assign(1, "uj");
+		 EXPECT_TRUE(dt.get(1, v));
+		 EXPECT_EQ(std::string("uj"), v);
+		 EXPECT_EQ((size_t)2000, dt.size());
+	 }
+	 {
+		 // Ujranyitas utan ugyanaz a tartalom
+		 DiskHashTable<std::string, int, linHash, 512> dt(path, 4);
+		 EXPECT_EQ((size_t)2000, dt.size());
+		 std::string v;
+		 for (int i = 0; i < 3000; ++i)
+			 EXPECT_EQ(i % 3 != 0, dt.contains(i));
+		 EXPECT_TRUE(dt.get(2, v));
+		 EXPECT_EQ(std::string("ertek2"), v);
+		 EXPECT_TRUE(dt.get(1, v));
+		 EXPECT_EQ(std::string("uj"), v);
+	 }
+	 EXPECT_THROW((DiskHashTable<std::string, int, linHash, 1024>(path, 4)), std::runtime_error);
+	 EXPECT_THROW((DiskHashTable<std::string, int, linHash, 512>(path, 0)), std::invalid_argument);
+	 {
+		 DiskHashTable<std::string, int, linHash, 512> dt(path, 4);
+		 EXPECT_THROW(dt.put(-1, std::string(600, 'x')), std::length_error);
+	 }
+	 unlink(path.c_str());
+	 unlink((path + ".dir").c_str());
+ } END
+
+TEST(DiskHashTable, overflow) {
+	 const std::string path = "disk_teszt.dat";
+	 unlink(path.c_str());
+	 unlink((path + ".dir").c_str());
+	 {
+		 // Minden kulcs hash-e azonos: kettevalasztas helyett tulcsordulasi lapok
+		 DiskHashTable<int, int, constHash, 256> dt(path, 2);
+		 for (int i = 0; i < 500; ++i)
+			 EXPECT_TRUE(dt.put(i, i * i));
+		 EXPECT_EQ((size_t)0, dt.depth());
+		 EXPECT_TRUE(dt.pages() > 10);
+		 int v = 0;
+		 for (int i = 0; i < 500; ++i) {
+			 EXPECT_TRUE(dt.get(i, v));
+			 EXPECT_EQ(i * i, v);
+		 }
+		 for (int i = 0; i < 500; i += 2)
+			 dt.remove(i);
+		 for (int i = 0; i < 500; ++i)
+			 EXPECT_EQ(i % 2 == 1, dt.contains(i));
+	 }
+	 unlink(path.c_str());
+	 unlink((path + ".dir").c_str());
+ } END
+#endif
+
+#if TESTCASE > 28
+TEST(PersistentHashMap, snapshots) {
+	 PersistentHashMap<int, int, linHash> pm;
+	 for (int i = 0; i < 2000; ++i)
+		 EXPECT_TRUE(pm.put(i, i * 2));
+	 EXPECT_FALSE(pm.put(7, 0));
+	 EXPECT_EQ(14, *pm.get(7));
+	 EXPECT_EQ((size_t)2000, pm.size());
+
+	 PersistentHashMap<int, int, linHash>::Snapshot s1 = pm.snapshot();
+	 for (int i = 0; i < 2000; i += 2)
+		 EXPECT_TRUE(pm.remove(i));
+	 EXPECT_FALSE(pm.remove(0));
+	 pm.assign(1, -1);
+	 pm.put(5000, 1);
+
+	 // A pillanatkep nem valtozott
+	 EXPECT_EQ((size_t)2000, s1.size());
+	 for (int i = 0; i < 2000; ++i)
+		 EXPECT_EQ(i * 2, *s1.get(i));
+	 EXPECT_FALSE(s1.contains(5000));
+	 size_t n = 0;
+	 long long sum = 0;
+	 s1.forEach([&](int, int v) { ++n; sum += v; });
+	 EXPECT_EQ((size_t)2000, n);
+	 EXPECT_EQ(1999LL * 2000, sum);
+
+	 // Az uj valtozat
+	 EXPECT_EQ((size_t)1001, pm.size());
+	 EXPECT_EQ(-1, *pm.get(1));
+	 EXPECT_TRUE(pm.get(2) == nullptr);
+	 PersistentHashMap<int, int, linHash>::Snapshot s2 = pm.snapshot();
+	 pm.clear();
+	 EXPECT_EQ((size_t)0, pm.size());
+	 EXPECT_EQ((size_t)1001, s2.size());
+	 EXPECT_EQ(1, *s2.get(5000));
+ } END
+
+TEST(PersistentHashMap, collisions) {
+	 // Minden kulcsnak azonos a hash-e: a hash bitek elfogynak, utkozesi csucsok keletkeznek
+	 PersistentHashMap<std::string, int, constHash> pm;
+	 for (int i = 0; i < 50; ++i)
+		 EXPECT_TRUE(pm.put(i, std::to_string(i)));
+	 PersistentHashMap<std::string, int, constHash>::Snapshot s = pm.snapshot();
+	 for (int i = 0; i < 50; i += 2)
+		 EXPECT_TRUE(pm.remove(i));
+	 for (int i = 0; i < 50; ++i) {
+		 EXPECT_EQ(i % 2 == 1, pm.contains(i));
+		 EXPECT_EQ(std::to_string(i), *s.get(i));
+	 }
+	 for (int i = 1; i < 50; i += 2)
+		 EXPECT_TRUE(pm.remove(i));
+	 EXPECT_EQ((size_t)0, pm.size());
+	 EXPECT_EQ((size_t)50, s.size());
+ } END
+
+TEST(PersistentHashMap, concurrentReaders) {
+	 // Az iro sorban rakja be a kulcsokat, az olvaso pillanatkepeinek mindig 0..size()-1-et kell tartalmazniuk
+	 PersistentHashMap<int, int, linHash> pm;
+	 std::atomic<bool> done(false);
+	 std::atomic<int> bad(0);
+	 std::thread reader([&]() {
+		 while (!done) {
+			 PersistentHashMap<int, int, linHash>::Snapshot s = pm.snapshot();
+			 size_t n = 0;
+			 s.forEach([&](int k, int v) { ++n; if (k != v || (size_t)k >= s.size()) ++bad; });
+			 if (n != s.size()) ++bad;
+		 }
+	 });
+	 for (int i = 0; i < 20000; ++i)
+		 pm.put(i, i);
+	 done = true;
+	 reader.join();
+	 EXPECT_EQ(0, bad.load());
+	 EXPECT_EQ((size_t)20000, pm.size());
+ } END
+#endif
+
+#if TESTCASE > 29
+TEST(ThreadPool, parallelFor) {
+	 ThreadPool pool(4);
+	 EXPECT_EQ((size_t)4, pool.size());
+	 std::vector<std::atomic<int>> hits(10007);
+	 for (auto& h : hits) h = 0;
+	 pool.parallelFor(hits.size(), 100, [&](size_t first, size_t last, size_t worker) {
+		 EXPECT_TRUE(worker < 4);
+		 for (size_t i = first; i < last; ++i) ++hits[i];
+	 });
+	 int wrong = 0;
+	 for (auto& h : hits) wrong += h != 1;
+	 EXPECT_EQ(0, wrong);
+	 EXPECT_THROW(pool.run([](size_t i) { if (i == 2) throw std::runtime_error("hiba"); }), std::runtime_error);
+	 // Kivetel utan is hasznalhato
+	 std::atomic<int> ran(0);
+	 pool.run([&](size_t) { ++ran; });
+	 EXPECT_EQ(4, ran.load());
+ } END
+
+TEST(HashTable, parallel) {
+	 HashTable<int, int, linHash, 1000> ht;
+	 for (int i = 0; i < 100000; ++i)
+		 ht.put(i, i);
+	 ThreadPool pool(4);
+	 std::atomic<long long> sum(0);
+	 std::atomic<int> n(0);
+	 ht.for_each_parallel([&](const int& k, int& v) { sum += v; ++n; v = k * 2; }, pool);
+	 EXPECT_EQ(100000, n.load());
+	 EXPECT_EQ(99999LL * 100000 / 2, sum.load());
+	 EXPECT_EQ(84, *ht.get(42));
+
+	 long long total = ht.reduce(0LL, [](const int&, const int& v) { return (long long)v; }, [](long long a, long long b) { return a + b; }, pool);
+	 EXPECT_EQ(99999LL * 100000, total);
+	 int maxKey = ht.reduce(-1, [](const int& k, const int&) { return k; }, [](int a, int b) { return a > b ? a : b; }, 3);
+	 EXPECT_EQ(99999, maxKey);
+	 EXPECT_THROW(ht.reduce(0, [](const int& k, const int&) -> int { if (k == 500) throw std::out_of_range("hiba"); return 0; }, [](int a, int b) { return a + b; }, pool), std::out_of_range);
+
+	 // Egyetlen hosszu lanc: a tobbi szal nem kap munkat, de az eredmeny helyes
+	 HashTable<int, int, constHash, 1000> skewed;
+	 for (int i = 0; i < 2000; ++i)
+		 skewed.put(i, 1);
+	 EXPECT_EQ(2000, skewed.reduce(0, [](const int&, const int& v) { return v; }, [](int a, int b) { return a + b; }, pool));
+
+	 HashTable<int, int, linHash, 10> empty;
+	 EXPECT_EQ(0, empty.reduce(0, [](const int&, const int& v) { return v; }, [](int a, int b) { return a + b; }));
+ } END
+#endif
+
+#if TESTCASE > 30
+TEST(LinkedList, erase) {
+	 LinkedList<int> ll;
+	 for (int i = 1; i <= 5; ++i)
+		 ll.push(i);
+	 // Az elso elem torlese nem veszitheti el a lanc tobbi reszet
+	 EXPECT_TRUE(ll.remove(5));
+	 EXPECT_FALSE(ll.remove(5));
+	 EXPECT_EQ((size_t)4, ll.length());
+	 int* next = ll.erase(ll.find(3));
+	 EXPECT_EQ(2, *next);
+	 EXPECT_TRUE(ll.erase(ll.find(1)) == nullptr);
+	 EXPECT_EQ((size_t)2, ll.length());
+	 EXPECT_EQ((size_t)1, ll.erase_if([](int& v) { return v == 4; }));
+	 EXPECT_EQ(2, *ll.getFirst());
+	 EXPECT_EQ((size_t)1, ll.erase_if([](int&) { return true; }));
+	 EXPECT_TRUE(ll.isEmpty());
+
+	 // A hellyel (position) nem keres; ha egy push miatt elavult, megkeresi az elemet
+	 LinkedList<int> pl;
+	 pl.push(1);
+	 pl.push(2);
+	 LinkedList<int>::position pos;
+	 int* head = pl.getFirst(pos);
+	 pl.push(3);
+	 EXPECT_EQ(1, *pl.erase(head, pos));
+	 EXPECT_TRUE(pl.find(2) == nullptr && pl.find(3) != nullptr);
+	 for (int* p = pl.getFirst(pos); p != nullptr;)
+		 p = pl.erase(p, pos);
+	 EXPECT_TRUE(pl.isEmpty());
+
+	 UnrolledList<int, std::allocator<int>, 4> ul;
+	 for (int i = 0; i < 10; ++i)
+		 ul.push(i);
+	 // Bejaras kozbeni torles: minden elemet pontosan egyszer lat
+	 int seen = 0;
+	 for (int* p = ul.getFirst(); p != nullptr;) {
+		 ++seen;
+		 if (*p % 2 == 0) p = ul.erase(p);
+		 else p = ul.getNext(*p);
+	 }
+	 EXPECT_EQ(10, seen);
+	 EXPECT_EQ((size_t)5, ul.length());
+	 for (int i = 0; i < 10; ++i)
+		 EXPECT_EQ(i % 2 == 1, ul.find(i) != nullptr);
+	 EXPECT_EQ((size_t)3, ul.erase_if([](int& v) { return v > 4; }));
+	 EXPECT_EQ((size_t)2, ul.length());
+	 ul.push(20);
+	 EXPECT_TRUE(ul.remove(1));
+	 EXPECT_TRUE(ul.find(3) != nullptr && ul.find(20) != nullptr);
+
+	 UnrolledList<int, std::allocator<int>, 4>::position upos;
+	 seen = 0;
+	 for (int* p = ul.getFirst(upos); p != nullptr; p = ul.getNext(p, upos))
+		 ++seen;
+	 EXPECT_EQ(2, seen);
+	 for (int* p = ul.getFirst(upos); p != nullptr;)
+		 p = ul.erase(p, upos);
+	 EXPECT_TRUE(ul.isEmpty());
+ } END
+
+TEST(HashTable, erase) {
+	 HashTable<int, int, linHash, 10> ht;
+	 for (int i = 0; i < 1000; ++i)
+		 ht.put(i, i);
+	 int seen = 0;
+	 for (auto iter = ht.begin(); iter != ht.end();) {
+		 ++seen;
+		 if (iter->key % 3 == 0) iter = ht.erase(iter);
+		 else ++iter;
+	 }
+	 EXPECT_EQ(1000, seen);
+	 EXPECT_EQ((size_t)666, ht.size());
+	 for (int i = 0; i < 1000; ++i)
+		 EXPECT_EQ(i % 3 != 0, ht.contains(i));
+
+	 size_t cap = ht.capacity() + ht.size();
+	 EXPECT_EQ((size_t)632, ht.erase_if([](const int& k, int&) { return k > 50; }));
+	 EXPECT_EQ((size_t)34, ht.size());
+	 EXPECT_TRUE(ht.capacity() + ht.size() < cap) << "erase_if utan zsugorodnia kellett" << std::endl;
+	 for (int i = 0; i < 1000; ++i)
+		 EXPECT_EQ(i % 3 != 0 && i <= 50, ht.contains(i));
+
+	 HashTable<int, std::string, charCodeHash, 10, std::allocator<int>, SegmentedLayout, UnrolledChain> ut;
+	 for (int i = 0; i < 500; ++i)
+		 ut.put(std::to_string(i), i);
+	 seen = 0;
+	 for (auto iter = ut.begin(); iter != ut.end();) {
+		 ++seen;
+		 if (iter->value % 2 == 0) iter = ut.erase(iter);
+		 else ++iter;
+	 }
+	 EXPECT_EQ(500, seen);
+	 EXPECT_EQ((size_t)250, ut.size());
+	 EXPECT_EQ((size_t)125, ut.erase_if([](const std::string&, int& v) { return v % 4 == 1; }));
+	 for (int i = 0; i < 500; ++i)
+		 EXPECT_EQ(i % 4 == 3, ut.contains(std::to_string(i)));
+
+	 HashSet<int, linHash, 10> hs;
+	 for (int i = 0; i < 100; ++i)
+		 hs.insert(i);
+	 EXPECT_EQ((size_t)90, hs.erase_if([](const int& k) { return k >= 10; }));
+	 EXPECT_EQ((size_t)10, hs.size());
+ } END
+#endif
+
+#if TESTCASE > 31
+TEST(RadixTree, prefix) {
+	 RadixTree<int> rt;
+	 const char* langs[] = { "Java", "JavaScript", "C", "C++", "C#", "Python", "Jython", "Julia" };
+	 for (int i = 0; i < 8; ++i)
+		 EXPECT_TRUE(rt.put(langs[i], i));
+	 EXPECT_FALSE(rt.put("Java", 100));
+	 EXPECT_EQ((size_t)8, rt.size());
+	 EXPECT_EQ(1, *rt.get("JavaScript"));
+	 EXPECT_TRUE(rt.get("Jav") == nullptr);
+
+	 std::string found;
+	 rt.prefix("Java", [&](const std::string& k, int&) { found += k + ";"; });
+	 EXPECT_EQ(std::string("Java;JavaScript;"), found);
+	 found.clear();
+	 rt.prefix("J", [&](const std::string& k, int&) { found += k + ";"; });
+	 EXPECT_EQ(std::string("Java;JavaScript;Julia;Jython;"), found);
+	 found.clear();
+	 rt.range("C#", "Java", [&](const std::string& k, int&) { found += k + ";"; });
+	 EXPECT_EQ(std::string("C#;C++;"), found);
+	 found.clear();
+	 rt.forEach([&](const std::string& k, int&) { found += k + ";"; return found.size() < 9; });
+	 EXPECT_EQ(std::string("C;C#;C++;"), found);
+
+	 EXPECT_TRUE(rt.remove("Java"));
+	 EXPECT_FALSE(rt.remove("Java"));
+	 EXPECT_TRUE(rt.contains("JavaScript"));
+	 EXPECT_EQ((size_t)7, rt.size());
+
+	 // Minden byte ertek egy csucs alatt: Node4 -> 16 -> 48 -> 256 es vissza
+	 RadixTree<int> wide;
+	 for (int b = 0; b < 256; ++b)
+		 wide.put(std::string("x") + (char)b, b);
+	 for (int b = 0; b < 256; ++b)
+		 EXPECT_EQ(b, *wide.get(std::string("x") + (char)b));
+	 for (int b = 0; b < 256; b += 2)
+		 wide.remove(std::string("x") + (char)b);
+	 int prev = -1, n = 0;
+	 wide.forEach([&](const std::string& k, int& v) { EXPECT_TRUE(v > prev); EXPECT_EQ(v, (int)(unsigned char)k[1]); prev = v; ++n; });
+	 EXPECT_EQ(128, n);
+	 for (int b = 1; b < 256; b += 2)
+		 wide.remove(std::string("x") + (char)b);
+	 EXPECT_EQ((size_t)0, wide.size());
+ } END
+
+TEST(RadixTree, randomized) {
+	 // Osszevetes std::map-pel: kis abece, sok kozos prefix, '\0' es 0xff byte-ok is
+	 std::mt19937 rng(5);
+	 const char alphabet[] = { 'a', 'b', 'c', '\0', (char)0xff };
+	 auto randomKey = [&]() {
+		 std::string k;
+		 size_t len = rng() % 9;
+		 for (size_t i = 0; i < len; ++i) k += alphabet[rng() % 5];
+		 return k;
+	 };
+	 RadixTree<int> rt;
+	 std::map<std::string, int> ref;
+	 int bad = 0;
+	 for (int op = 0; op < 20000; ++op) {
+		 std::string k = randomKey();
+		 if (rng() % 3 == 0) {
+			 if (rt.remove(k) != (ref.erase(k) == 1)) ++bad;
+		 }
+		 else {
+			 if (rt.put(k, op) != ref.insert(std::make_pair(k, op)).second) ++bad;
+		 }
+	 }
+	 EXPECT_EQ(0, bad);
+	 EXPECT_EQ(ref.size(), rt.size());
+	 for (auto& kv : ref)
+		 if (rt.get(kv.first) == nullptr || *rt.get(kv.first) != kv.second) ++bad;
+	 EXPECT_EQ(0, bad);
+
+	 std::vector<std::string> all;
+	 rt.forEach([&](const std::string& k, int&) { all.push_back(k); });
+	 std::vector<std::string> expected;
+	 for (auto& kv : ref) expected.push_back(kv.first);
+	 EXPECT_TRUE(all == expected);
+
+	 for (int q = 0; q < 200; ++q) {
+		 std::string p = randomKey().substr(0, 3);
+		 std::vector<std::string> got, want;
+		 rt.prefix(p, [&](const std::string& k, int&) { got.push_back(k); });
+		 for (auto iter = ref.lower_bound(p); iter != ref.end() && iter->first.compare(0, p.size(), p) == 0; ++iter)
+			 want.push_back(iter->first);
+		 if (got != want) ++bad;
+
+		 std::string lo = randomKey(), hi = randomKey();
+		 if (hi < lo) std::swap(lo, hi);
+		 got.clear();
+		 want.clear();
+		 rt.range(lo, hi, [&](const std::string& k, int&) { got.push_back(k); });
+		 for (auto iter = ref.lower_bound(lo); iter != ref.end() && iter->first < hi; ++iter)
+			 want.push_back(iter->first);
+		 if (got != want) ++bad;
+	 }
+	 EXPECT_EQ(0, bad);
+ } END
+#endif
+
+#if TESTCASE > 32
+TEST(SplitHashTable, stableValues) {
+	 {
+		 SplitHashTable<BigValue, int, linHash, 10> t;
+		 EXPECT_TRUE(t.put(1, BigValue(1)));
+		 EXPECT_FALSE(t.put(1, BigValue(2)));
+		 BigValue* first = t.get(1);
+		 EXPECT_EQ(1, first->id);
+		 // Sok novekedes: az ertek cime nem valtozik
+		 for (int i = 2; i <= 1000; ++i)
+			 t.put(i, BigValue(i));
+		 EXPECT_TRUE(first == t.get(1));
+		 EXPECT_EQ((size_t)1000, t.size());
+		 EXPECT_EQ(1000, BigValue::live);
+		 EXPECT_TRUE(t.get(1001) == nullptr);
+		 EXPECT_TRUE(t.contains(500));
+
+		 // A torolt ertek helye ujrahasznosul
+		 BigValue* removed = t.get(500);
+		 t.remove(500);
+		 t.remove(500);
+		 EXPECT_FALSE(t.contains(500));
+		 EXPECT_EQ(999, BigValue::live);
+		 size_t blocks = t.valueBlocks();
+		 t.put(5000, BigValue(5000));
+		 EXPECT_TRUE(removed == t.get(5000));
+		 EXPECT_EQ(blocks, t.valueBlocks());
+
+		 long long sum = 0;
+		 t.forEach([&](const int& key, BigValue& v) { EXPECT_EQ(key, v.id); sum += v.id; });
+		 EXPECT_EQ(500500LL - 500 + 5000, sum);
+
+		 // A belso tablan is mukodnek a HashTable beallitasai
+		 t.index().enableBloomFilter();
+		 EXPECT_EQ(7, t.get(7)->id);
+	 }
+	 EXPECT_EQ(0, BigValue::live);
+
+	 // Ha a belso tabla push-a dob, a mar letrehozott ertek nem maradhat a taroloban
+	 {
+		 CountingResource res;
+		 SplitHashTable<BigValue, int, linHash, 10, std::pmr::polymorphic_allocator<BigValue>> t(&res);
+		 EXPECT_TRUE(t.put(1, BigValue(1)));
+		 res.fail = true;
+		 EXPECT_THROW(t.put(2, BigValue(2)), std::bad_alloc);
+		 res.fail = false;
+		 EXPECT_FALSE(t.contains(2));
+		 EXPECT_EQ(1, BigValue::live);
+		 EXPECT_TRUE(t.put(2, BigValue(2)));
+		 EXPECT_EQ(2, t.get(2)->id);
+	 }
+	 EXPECT_EQ(0, BigValue::live);
+
+	 // Sok torles: a tabla zsugorodik, a megmaradt ertekek cime nem valtozik
+	 SplitHashTable<std::string, std::string> s;
+	 for (int i = 0; i < 2000; ++i)
+		 s.put("url" + std::to_string(i), "https://example.org/" + std::to_string(i));
+	 std::string* kept = s.get("url1999");
+	 for (int i = 0; i < 1990; ++i)
+		 s.remove("url" + std::to_string(i));
+	 EXPECT_TRUE(kept == s.get("url1999"));
+	 EXPECT_EQ(std::string("https://example.org/1999"), *kept);
+	 EXPECT_EQ((size_t)10, s.size());
+ } END
+#endif
+
+#if TESTCASE > 33
+TEST(SharedHashTable, basic) {
+	 std::string name = "/sht_test_" + std::to_string(getpid());
+	 SharedHashTable<std::string>::unlink(name);
+	 SharedHashTable<std::string> t(name, 64, 1 << 16);
+	 EXPECT_THROW(SharedHashTable<std::string>(name, 64, 1 << 16), std::runtime_error);
+	 EXPECT_THROW(SharedHashTable<std::string>("/sht_nincs_ilyen"), std::runtime_error);
+	 EXPECT_TRUE(t.put("alma", "piros"));
+	 EXPECT_FALSE(t.put("alma", "zold"));
+	 std::string v;
+	 EXPECT_TRUE(t.get("alma", v));
+	 EXPECT_EQ(std::string("piros"), v);
+	 t.assign("alma", "sarga, de hosszabb erteket kap, mint az eddigi");
+	 EXPECT_TRUE(t.get("alma", v));
+	 EXPECT_EQ(std::string("sarga, de hosszabb erteket kap, mint az eddigi"), v);
+	 EXPECT_EQ((size_t)1, t.size());
+
+	 // Sok elem keves vodorben (hosszu lancok), torles kozepen es vegen
+	 for (int i = 0; i < 500; ++i)
+		 t.put("k" + std::to_string(i), std::to_string(i * i));
+	 for (int i = 0; i < 500; i += 3)
+		 EXPECT_TRUE(t.remove("k" + std::to_string(i)));
+	 EXPECT_FALSE(t.remove("k0"));
+	 int bad = 0;
+	 for (int i = 0; i < 500; ++i) {
+		 bool found = t.get("k" + std::to_string(i), v);
+		 if (found != (i % 3 != 0) || (found && v != std::to_string(i * i))) ++bad;
+	 }
+	 EXPECT_EQ(0, bad);
+	 size_t n = 0;
+	 t.forEach([&](const std::string&, const std::string&) { ++n; });
+	 EXPECT_EQ(t.size(), n);
+
+	 // A torolt elemek helye ujrahasznosul
+	 size_t used = t.bytesUsed();
+	 for (int i = 0; i < 500; i += 3)
+		 t.put("k" + std::to_string(i), std::to_string(i * i));
+	 EXPECT_EQ(used, t.bytesUsed());
+
+	 // Megtelt szegmens: length_error, a tabla hasznalhato marad
+	 EXPECT_THROW(t.put("nagy", std::string(1 << 16, 'x')), std::length_error);
+	 EXPECT_FALSE(t.contains("nagy"));
+	 EXPECT_TRUE(t.contains("k3"));
+	 EXPECT_TRUE(SharedHashTable<std::string>::unlink(name));
+ } END
+
+TEST(SharedHashTable, processes) {
+	 std::string name = "/sht_proc_" + std::to_string(getpid());
+	 SharedHashTable<int, int, linHash>::unlink(name);
+	 SharedHashTable<int, int, linHash> writer(name, 1024, 1 << 20);
+	 for (int i = 0; i < 1000; ++i)
+		 writer.put(i, i * 2);
+
+	 // Olvaso folyamatok nev szerint nyitjak meg, es kozben az iro tovabb ir
+	 std::vector<pid_t> readers;
+	 for (int r = 0; r < 3; ++r) {
+		 pid_t pid = fork();
+		 if (pid == 0) {
+			 int bad = 0;
+			 try {
+				 SharedHashTable<int, int, linHash> reader(name);
+				 for (int round = 0; round < 20; ++round)
+					 for (int i = 0; i < 1000; ++i) {
+						 int v;
+						 if (!reader.get(i, v) || v != i * 2) ++bad;
+					 }
+				 // Megvarja az iro jelet, es latja az uj elemet
+				 int v = 0;
+				 while (!reader.get(-1, v)) usleep(1000);
+				 if (v != 42) ++bad;
+			 }
+			 catch (...) {
+				 bad = 100;
+			 }
+			 _exit(bad > 100 ? 100 : bad);
+		 }
+		 readers.push_back(pid);
+	 }
+	 for (int i = 1000; i < 2000; ++i)
+		 writer.put(i, i * 2);
+	 writer.put(-1, 42);
+	 for (pid_t pid : readers) {
+		 int status = -1;
+		 waitpid(pid, &status, 0);
+		 EXPECT_TRUE(WIFEXITED(status));
+		 EXPECT_EQ(0, WEXITSTATUS(status));
+	 }
+	 EXPECT_EQ((size_t)2001, writer.size());
+	 SharedHashTable<int, int, linHash>::unlink(name);
+ } END
+#endif
+
+#if TESTCASE > 34
+TEST(HugePageResource, table) {
+	 HugePageResource res;
+	 {
+		 HugePageHashTable<int, int, linHash, 1 << 12> t(&res);
+		 for (int i = 0; i < 100000; ++i)
+			 t.put(i, i * 3);
+		 int bad = 0;
+		 for (int i = 0; i < 100000; ++i)
+			 if (t.get(i) == nullptr || *t.get(i) != i * 3) ++bad;
+		 EXPECT_EQ(0, bad);
+		 for (int i = 0; i < 100000; i += 2)
+			 t.remove(i);
+		 EXPECT_EQ((size_t)50000, t.size());
+		 EXPECT_TRUE(t.get(1) != nullptr);
+		 EXPECT_TRUE(t.get(2) == nullptr);
+	 }
+	 EXPECT_TRUE(res.bytesMapped() > 0);
+	 EXPECT_EQ((size_t)0, res.bytesMapped() % HugePageResource::hugePageSize);
+
+	 // A nagy foglalas sajat, 2 MiB-ra igazitott mappelest kap, es a felszabaditasa visszaadja
+	 size_t before = res.bytesMapped();
+	 void* big = res.allocate(3 << 20, 64);
+	 EXPECT_EQ((uintptr_t)0, (uintptr_t)big % HugePageResource::hugePageSize);
+	 EXPECT_EQ(before + (4 << 20), res.bytesMapped());
+	 std::memset(big, 1, 3 << 20);
+	 res.deallocate(big, 3 << 20, 64);
+	 EXPECT_EQ(before, res.bytesMapped());
+
+	 // FlatLayout: az egesz vodor tomb egy mappeles
+	 HugePageResource flatRes;
+	 HugePageHashTable<int, int, linHash, 1 << 12, FlatLayout> flat(&flatRes);
+	 for (int i = 0; i < 20000; ++i)
+		 flat.put(i, i);
+	 EXPECT_EQ(19999, *flat.get(19999));
+ } END
+#endif
+
+#if TESTCASE > 35
+TEST(hashBatch, sameAsScalar) {
+	 std::mt19937 rng(11);
+	 std::vector<std::string> keys;
+	 for (int i = 0; i < 2203; ++i) {
+		 std::string k;
+		 size_t len = i < 100 ? i : i < 2000 ? rng() % 80 : rng() % 33; // A vegen rovid kulcsok, nyolcasaval is
+		 for (size_t j = 0; j < len; ++j) k += (char)(rng() % 256); // negativ char-ok is
+		 keys.push_back(k);
+	 }
+	 const size_t sizes[] = { 1, 7, 100, 1000003, (size_t)1 << 40, SIZE_MAX };
+	 std::vector<size_t> out(keys.size());
+	 int bad = 0;
+	 for (size_t maxSize : sizes) {
+		 for (bool simd : { true, false }) {
+			 charCodeHashBatch(keys.data(), keys.size(), maxSize, out.data(), simd);
+			 for (size_t i = 0; i < keys.size(); ++i)
+				 if (out[i] != charCodeHash(keys[i], maxSize)) ++bad;
+		 }
+	 }
+	 EXPECT_EQ(0, bad);
+
+	 std::vector<int> ints;
+	 for (int i = 0; i < 1001; ++i) ints.push_back((int)rng());
+	 ints.push_back(0);
+	 ints.push_back(2147483647);
+	 ints.push_back(-1);
+	 for (int i = 0; i < 40; ++i) ints.push_back(i * 1000003); // A maxSize tobbszorosei
+	 const size_t intSizes[] = { 1, 3, 1000003, 2147483647, (size_t)1 << 31, SIZE_MAX };
+	 out.resize(ints.size());
+	 for (size_t maxSize : intSizes) {
+		 for (bool simd : { true, false }) {
+			 linHashBatch(ints.data(), ints.size(), maxSize, out.data(), simd);
+			 for (size_t i = 0; i < ints.size(); ++i)
+				 if (out[i] != linHash(ints[i], maxSize)) ++bad;
+		 }
+	 }
+	 EXPECT_EQ(0, bad);
+	 // Altalanos hash fuggvenyre kulcsonkent hiv
+	 hashBatch<int, constHash>(ints.data(), 3, 10, out.data());
+	 EXPECT_EQ((size_t)7, out[2]);
+ } END
+
+TEST(HashTable, putManyGetMany) {
+	 std::vector<std::string> keys;
+	 std::vector<int> values;
+	 for (int i = 0; i < 3000; ++i) {
+		 keys.push_back("kulcs" + std::to_string(i % 2500)); // 500 ismetlodo kulcs
+		 values.push_back(i);
+	 }
+	 HashTable<int, std::string, charCodeHash, 50> batch;
+	 HashTable<int, std::string, charCodeHash, 50> single;
+	 batch.put("kulcs7", -7);
+	 single.put("kulcs7", -7);
+	 EXPECT_EQ((size_t)2499, batch.put_many(keys.data(), values.data(), keys.size()));
+	 for (size_t i = 0; i < keys.size(); ++i) single.put(keys[i], values[i]);
+	 EXPECT_EQ(single.size(), batch.size());
+
+	 std::vector<std::string> probe(keys.begin(), keys.begin() + 600);
+	 probe.push_back("nincs benne");
+	 std::vector<int*> found(probe.size());
+	 EXPECT_EQ((size_t)600, batch.get_many(probe.data(), probe.size(), found.data()));
+	 int bad = 0;
+	 for (size_t i = 0; i < probe.size(); ++i) {
+		 int* expected = single.get(probe[i]);
+		 if ((found[i] == nullptr) != (expected == nullptr) || (found[i] != nullptr && *found[i] != *expected)) ++bad;
+	 }
+	 EXPECT_EQ(0, bad);
+	 EXPECT_EQ(-7, *found[7]);
+
+	 // Linearis hasheles: koteg kozben is novekszik, Bloom szuroval
+	 HashTable<int, int, linHash, 16> lin;
+	 lin.enableLinearHashing();
+	 lin.enableBloomFilter();
+	 std::vector<int> ikeys;
+	 for (int i = 0; i < 5000; ++i) ikeys.push_back(i * 13);
+	 EXPECT_EQ((size_t)5000, lin.put_many(ikeys.data(), ikeys.data(), ikeys.size()));
+	 for (int i = 0; i < 5000; ++i)
+		 if (lin.get(i * 13) == nullptr || *lin.get(i * 13) != i * 13) ++bad;
+	 EXPECT_EQ(0, bad);
+	 std::vector<int*> ifound(ikeys.size());
+	 EXPECT_EQ((size_t)5000, lin.get_many(ikeys.data(), ikeys.size(), ifound.data()));
+ } END
+#endif
+
+#if TESTCASE > 36
+TEST(FixedHashTable, basic) {
+	 typedef FixedHashTable<int, std::string, charCodeHash, 8> Table;
+	 static_assert(sizeof(Table) >= 8 * sizeof(std::string), "A helyek az objektumban vannak");
+	 Table t;
+	 EXPECT_EQ((size_t)8, t.capacity());
+	 for (int i = 0; i < 8; ++i)
+		 EXPECT_TRUE(t.put("k" + std::to_string(i), i) == Table::PutResult::Inserted);
+	 EXPECT_TRUE(t.full());
+	 EXPECT_TRUE(t.put("k3", 100) == Table::PutResult::Exists);
+	 EXPECT_TRUE(t.put("k8", 8) == Table::PutResult::Full);
+	 EXPECT_EQ(3, *t.get("k3"));
+	 EXPECT_TRUE(t.get("k8") == nullptr); // Teli tablaban is veget er a kereses
+	 EXPECT_TRUE(t.remove("k3"));
+	 EXPECT_FALSE(t.remove("k3"));
+	 EXPECT_TRUE(t.put("k8", 8) == Table::PutResult::Inserted);
+	 int sum = 0;
+	 t.forEach([&](const std::string&, int& v) { sum += v; });
+	 EXPECT_EQ(0 + 1 + 2 + 4 + 5 + 6 + 7 + 8, sum);
+
+	 // Elemek elettartama: a torles mozgat, de nem szivarogtat
+	 {
+		 FixedHashTable<BigValue, int, constHash, 16> big; // Minden kulcs ugyanoda: egy hosszu lanc
+		 for (int i = 0; i < 16; ++i) big.put(i, BigValue(i));
+		 EXPECT_EQ(16, BigValue::live);
+		 big.remove(0);
+		 big.remove(7);
+		 EXPECT_EQ(14, BigValue::live);
+		 EXPECT_EQ(15, big.get(15)->id);
+		 big.clear();
+		 EXPECT_EQ(0, BigValue::live);
+		 big.put(1, BigValue(1));
+	 }
+	 EXPECT_EQ(0, BigValue::live);
+ } END
+
+TEST(FixedHashTable, randomized) {
+	 // Osszevetes std::map-pel, sok torlessel, hogy a backward shift a tomb vegen is atforduljon
+	 std::mt19937 rng(17);
+	 FixedHashTable<int, int, linHash, 61> t;
+	 FixedHashTable<int, int, constHash, 13> clustered;
+	 std::map<int, int> ref, ref2;
+	 int bad = 0;
+	 for (int op = 0; op < 20000; ++op) {
+		 int k = (int)(rng() % 100);
+		 if (rng() % 2 == 0) {
+			 if (t.remove(k) != (ref.erase(k) == 1)) ++bad;
+			 if (clustered.remove(k % 20) != (ref2.erase(k % 20) == 1)) ++bad;
+		 }
+		 else {
+			 auto r = t.put(k, op);
+			 if (ref.size() == 61 && ref.count(k) == 0) { if (r != decltype(t)::PutResult::Full) ++bad; }
+			 else if ((r == decltype(t)::PutResult::Inserted) != ref.insert(std::make_pair(k, op)).second) ++bad;
+			 auto r2 = clustered.put(k % 20, op);
+			 if (ref2.size() == 13 && ref2.count(k % 20) == 0) { if (r2 != decltype(clustered)::PutResult::Full) ++bad; }
+			 else if ((r2 == decltype(clustered)::PutResult::Inserted) != ref2.insert(std::make_pair(k % 20, op)).second) ++bad;
+		 }
+		 if (op % 100 == 0) {
+			 for (int q = 0; q < 100; ++q) {
+				 auto it = ref.find(q);
+				 int* v = t.get(q);
+				 if ((v == nullptr) != (it == ref.end()) || (v != nullptr && *v != it->second)) ++bad;
+				 auto it2 = ref2.find(q);
+				 int* v2 = clustered.get(q);
+				 if ((v2 == nullptr) != (it2 == ref2.end()) || (v2 != nullptr && *v2 != it2->second)) ++bad;
+			 }
+		 }
+	 }
+	 EXPECT_EQ(0, bad);
+	 EXPECT_EQ(ref.size(), t.size());
+	 EXPECT_EQ(ref2.size(), clustered.size());
+ } END
+#endif
 
 
 	 return 0;
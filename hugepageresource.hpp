@@ -0,0 +1,174 @@
+﻿/*****************************************************************
+ * @file   hugepageresource.hpp
+ * @brief  HugePageResource class: 2 MiB-os, huge page-re igazított régiókból foglaló std::pmr::memory_resource nagy táblákhoz.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef HUGEPAGERESOURCE_H
+#define HUGEPAGERESOURCE_H
+#include <memory_resource>
+#include <vector>
+#include <new>
+#include <cstdint>
+#include <sys/mman.h>
+#include "hashtable.hpp"
+
+#include "memtrace.h"
+
+/**
+ * Memória erőforrás nagyon nagy táblákhoz.
+ * Sok millió elemnél a véletlen keresések idejét a TLB hiányok viszik el, mert a vödör tömbök és a
+ * listaelemek 4 KiB-os lapokon szóródnak szét. Ez az erőforrás 2 MiB-re igazított régiókat mappel,
+ * és madvise(MADV_HUGEPAGE)-dzsel kéri rájuk a transzparens huge page-eket, így egy TLB bejegyzés
+ * 512-szer annyi memóriát fed le.
+ *
+ * A kis foglalások (listaelemek, kis tömbök) egy std::pmr::unsynchronized_pool_resource-on keresztül
+ * a régiókból jönnek, és a pool újrahasznosítja őket. A largeAllocation-nél nagyobb foglalások
+ * (pl. egy nagy tábla vödör tömbjei) saját, 2 MiB többszörösére kerekített mappelést kapnak,
+ * amit a felszabadításuk vissza is ad. A kis foglalások régiói csak a destruktorban szabadulnak fel.
+ *
+ * Ha a rendszeren nincsenek transzparens huge page-ek (a madvise hibát ad, vagy nincs MADV_HUGEPAGE),
+ * az erőforrás ugyanígy működik 4 KiB-os lapokkal, ezt a hugePagesAdvised() mutatja.
+ * Nem szálbiztos, mint maga a HashTable sem.
+ */
+class HugePageResource : public std::pmr::memory_resource {
+public:
+	static const size_t hugePageSize = (size_t)2 << 20; //< 2 MiB
+	static const size_t largeAllocation = (size_t)1 << 20; //< Efölött saját mappelés
+private:
+	/**
+	 * A pool alatti réteg: 2 MiB-os régiókból darabol, a nagy foglalásokat külön mappeli.
+	 */
+	class Regions : public std::pmr::memory_resource {
+		std::vector<std::pair<char*, size_t>> maps; //< Az összes élő mappelés
+		char* cur; //< A jelenlegi régió első szabad byte-ja
+		size_t left; //< Ennyi byte maradt a jelenlegi régióban
+		size_t mappedBytes; //< Az élő mappelések összmérete
+		size_t adviseFailures; //< Ennyi madvise hívás nem sikerült
+
+		/**
+		 * Mappel egy hugePageSize-ra igazított területet: többet kér, és levágja a két szélét.
+		 * @param bytes hugePageSize többszöröse
+		 */
+		char* mapAligned(size_t bytes) {
+			size_t extra = bytes + hugePageSize;
+			void* p = ::mmap(nullptr, extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p == MAP_FAILED) throw std::bad_alloc();
+			uintptr_t start = (uintptr_t)p;
+			uintptr_t aligned = (start + hugePageSize - 1) & ~(uintptr_t)(hugePageSize - 1);
+			if (aligned > start)
+				::munmap(p, aligned - start);
+			if (start + extra > aligned + bytes)
+				::munmap((void*)(aligned + bytes), start + extra - aligned - bytes);
+#ifdef MADV_HUGEPAGE
+			if (::madvise((void*)aligned, bytes, MADV_HUGEPAGE) != 0) ++adviseFailures;
+#else
+			++adviseFailures;
+#endif
+			maps.push_back(std::make_pair((char*)aligned, bytes));
+			mappedBytes += bytes;
+			return (char*)aligned;
+		}
+
+		static size_t roundUp(size_t bytes) {
+			return (bytes + hugePageSize - 1) / hugePageSize * hugePageSize;
+		}
+
+		void* do_allocate(size_t bytes, size_t align) override {
+			if (bytes >= largeAllocation)
+				return mapAligned(roundUp(bytes));
+			size_t pad = (align - (uintptr_t)cur % align) % align;
+			if (cur == nullptr || pad + bytes > left) {
+				cur = mapAligned(hugePageSize);
+				left = hugePageSize;
+				pad = 0;
+			}
+			char* p = cur + pad;
+			cur += pad + bytes;
+			left -= pad + bytes;
+			return p;
+		}
+
+		void do_deallocate(void* p, size_t bytes, size_t) override {
+			if (bytes < largeAllocation) return; // A pool csak a destruktorában adja vissza
+			for (size_t i = 0; i < maps.size(); ++i) {
+				if (maps[i].first == (char*)p) {
+					::munmap(p, maps[i].second);
+					mappedBytes -= maps[i].second;
+					maps[i] = maps.back();
+					maps.pop_back();
+					return;
+				}
+			}
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+			return this == &other;
+		}
+	public:
+		Regions() :cur(nullptr), left(0), mappedBytes(0), adviseFailures(0) {};
+
+		size_t mapped() const { return mappedBytes; }
+		size_t failures() const { return adviseFailures; }
+
+		~Regions() {
+			for (const std::pair<char*, size_t>& m : maps)
+				::munmap(m.first, m.second);
+		}
+	};
+
+	Regions regions; //< A pool alatti réteg, a pool előtt kell létrejönnie
+	std::pmr::unsynchronized_pool_resource pool; //< A kis foglalások újrahasznosítása
+
+	static std::pmr::pool_options poolOptions() {
+		std::pmr::pool_options o;
+		o.max_blocks_per_chunk = 0; // Az implementáció alapértéke
+		o.largest_required_pool_block = largeAllocation;
+		return o;
+	}
+
+	void* do_allocate(size_t bytes, size_t align) override {
+		return pool.allocate(bytes, align);
+	}
+
+	void do_deallocate(void* p, size_t bytes, size_t align) override {
+		pool.deallocate(p, bytes, align);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+
+	HugePageResource(const HugePageResource&); //< Másoló konstruktor tiltása
+	HugePageResource& operator=(const HugePageResource&); //< Értékadás tiltása
+public:
+	HugePageResource() :regions(), pool(poolOptions(), &regions) {};
+
+	/**
+	 * @return a mappelt byte-ok száma (2 MiB többszöröse)
+	 */
+	size_t bytesMapped() const {
+		return regions.mapped();
+	}
+
+	/**
+	 * @return minden mappelésre sikerült-e kérni a huge page-eket. Azt nem garantálja,
+	 *         hogy a kernel meg is adta őket (ld. AnonHugePages a /proc/self/smaps-ben).
+	 */
+	bool hugePagesAdvised() const {
+		return regions.failures() == 0;
+	}
+};
+
+/**
+ * Nagy tábla huge page-eken: a vödör tömbök és a listaelemek is egy HugePageResource-ból foglalnak.
+ * pl. HugePageResource res; HugePageHashTable<int, int, linHash, 1 << 20> t(&res);
+ * Az erőforrásnak túl kell élnie a táblát. FlatLayout-tal a teljes vödör tömb egyetlen nagy mappelés.
+ */
+template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash, size_t defSize = 1 << 16, typename Layout = SegmentedLayout, typename Chain = LinkedChain>
+using HugePageHashTable = HashTable<T, keyType, hashFunction, defSize, std::pmr::polymorphic_allocator<T>, Layout, Chain>;
+
+#endif // !HUGEPAGERESOURCE_H
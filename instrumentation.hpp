@@ -0,0 +1,318 @@
+﻿/*****************************************************************
+ * @file   instrumentation.hpp
+ * @brief  A HashTable mérési policy-jei: NoInstrumentation (alapértelmezett, semmibe nem kerül)
+ *         és LatencyInstrumentation (műveletenkénti késleltetés hisztogramok, rehash események).
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+#include <cstdint>
+#include <chrono>
+#include <ostream>
+
+#include "memtrace.h"
+
+/**
+ * A mért művelettípusok.
+ */
+enum class HashOp {
+	Get, //< get, contains, operator[]
+	Put, //< put, insert, find_or_insert, get_or_insert_with
+	Remove, //< remove
+	Rehash, //< rehash (növekedés, zsugorítás)
+	count
+};
+
+/**
+ * @return a művelet neve
+ */
+inline const char* hashOpName(HashOp op) {
+	static const char* names[] = { "get", "put", "remove", "rehash" };
+	return names[(int)op];
+}
+
+/**
+ * Alapértelmezett policy: nem mér semmit. Üres osztály, minden függvénye üres inline,
+ * így a fordító a hívásokat és a tárolást is teljesen kihagyja.
+ */
+struct NoInstrumentation {
+	uint64_t start() { return 0; }
+	void record(HashOp, uint64_t) {}
+	void rehashed(HashOp, size_t, size_t, size_t, uint64_t) {}
+};
+
+/**
+ * HDR jellegű (log-lineáris) hisztogram nanoszekundumos értékekhez.
+ * Minden kettőhatvány-tartomány subBuckets egyenlő részre oszlik, így a relatív hiba legfeljebb 1/subBuckets,
+ * a memóriaigény pedig állandó (kb. 5 KB), akármennyi mérés kerül bele.
+ */
+class LatencyHistogram {
+	static const int subBits = 4;
+	static const uint64_t subBuckets = 1 << subBits; //< 16 rész kettőhatványonként: ~6% pontosság
+	static const int maxShift = 40; //< A legnagyobb tárolható érték kb. 2^44 ns (~4.9 óra), a nagyobbak ide esnek
+	static const size_t nBuckets = (maxShift + 1) * subBuckets + subBuckets;
+
+	uint64_t counts[nBuckets]; //< Vödrönkénti darabszám
+	uint64_t n; //< Az összes mérés száma
+	uint64_t sum; //< Az értékek összege
+	uint64_t minValue; //< A legkisebb érték
+	uint64_t maxValue; //< A legnagyobb érték
+
+	/**
+	 * @return az érték vödre
+	 */
+	static size_t index(uint64_t v) {
+		if (v < subBuckets) return (size_t)v;
+		int msb = 63;
+		while ((v >> msb) == 0) --msb;
+		int shift = msb - subBits;
+		if (shift > maxShift) return nBuckets - 1;
+		return (size_t)(shift + 1) * subBuckets + (size_t)((v >> shift) - subBuckets);
+	}
+
+	/**
+	 * @return a vödörbe eső legnagyobb érték
+	 */
+	static uint64_t upperBound(size_t i) {
+		if (i < subBuckets) return i;
+		int shift = (int)(i / subBuckets) - 1;
+		uint64_t mantissa = i % subBuckets + subBuckets;
+		return ((mantissa + 1) << shift) - 1;
+	}
+public:
+	LatencyHistogram() {
+		reset();
+	}
+
+	/**
+	 * Kiüríti a hisztogramot.
+	 */
+	void reset() {
+		for (size_t i = 0; i < nBuckets; ++i) counts[i] = 0;
+		n = sum = maxValue = 0;
+		minValue = UINT64_MAX;
+	}
+
+	/**
+	 * Hozzáad egy mérést.
+	 */
+	void add(uint64_t ns) {
+		++counts[index(ns)];
+		++n;
+		sum += ns;
+		if (ns < minValue) minValue = ns;
+		if (ns > maxValue) maxValue = ns;
+	}
+
+	/**
+	 * @return a mérések száma
+	 */
+	uint64_t count() const { return n; }
+
+	/**
+	 * @return a legkisebb mért érték, 0 ha nincs mérés
+	 */
+	uint64_t min() const { return n == 0 ? 0 : minValue; }
+
+	/**
+	 * @return a legnagyobb mért érték
+	 */
+	uint64_t max() const { return maxValue; }
+
+	/**
+	 * @return az átlag
+	 */
+	double mean() const { return n == 0 ? 0.0 : (double)sum / (double)n; }
+
+	/**
+	 * @param p a percentilis, 0 és 100 között
+	 * @return az az érték, aminél a mérések p százaléka nem nagyobb (a vödör felső határa, legfeljebb max())
+	 */
+	uint64_t percentile(double p) const {
+		if (n == 0) return 0;
+		uint64_t rank = (uint64_t)(p / 100.0 * (double)n + 0.5);
+		if (rank < 1) rank = 1;
+		if (rank > n) rank = n;
+		uint64_t seen = 0;
+		for (size_t i = 0; i < nBuckets; ++i) {
+			seen += counts[i];
+			if (seen >= rank) {
+				uint64_t v = upperBound(i);
+				return v > maxValue ? maxValue : v;
+			}
+		}
+		return maxValue;
+	}
+};
+
+/**
+ * Egy rehash adatai.
+ */
+struct RehashEvent {
+	HashOp cause; //< A rehash-t kiváltó művelet (Put: növekedés, Remove: automatikus zsugorítás, Rehash: shrink_to_fit)
+	size_t elements; //< Ennyi elemet kellett áthashelni
+	size_t fromBuckets; //< A vödrök száma előtte
+	size_t toBuckets; //< A vödrök száma utána
+	uint64_t ns; //< Időtartam
+};
+
+/**
+ * Mérő policy: műveletenként egy LatencyHistogram, a rehash-ekről hisztogram és az utolsó néhány esemény.
+ * Az eredmények a dump()-pal kérhetők le, vagy a dumpEvery() beállítása után időközönként íródnak ki.
+ * Nem szálbiztos, mint maga a HashTable sem.
+ */
+class LatencyInstrumentation {
+public:
+	enum Format { Text, Json };
+	static const size_t keptEvents = 64; //< Ennyi legutóbbi rehash eseményt tart meg
+private:
+	typedef std::chrono::steady_clock clock;
+
+	LatencyHistogram histograms[(int)HashOp::count]; //< Műveletenkénti hisztogramok
+	RehashEvent events[keptEvents]; //< A legutóbbi rehash-ek (körkörös puffer)
+	uint64_t nRehashes; //< Az összes rehash száma
+	std::ostream* dumpStream; //< Időközönkénti kiírás célja, vagy nullptr
+	Format dumpFormat; //< Időközönkénti kiírás formátuma
+	uint64_t dumpIntervalNs; //< Időközönkénti kiírás periódusa
+	uint64_t lastDump; //< Az utolsó kiírás ideje
+
+	static uint64_t now() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+	}
+
+	/**
+	 * Kiírja az eredményeket, ha letelt a periódus.
+	 */
+	void maybeDump(uint64_t t) {
+		if (dumpStream != nullptr && t - lastDump >= dumpIntervalNs) {
+			lastDump = t;
+			dump(*dumpStream, dumpFormat);
+		}
+	}
+public:
+	LatencyInstrumentation() :nRehashes(0), dumpStream(nullptr), dumpFormat(Text), dumpIntervalNs(0), lastDump(0) {};
+
+	/**
+	 * @return a mérés kezdete, a record() / rehashed() kapja vissza
+	 */
+	uint64_t start() {
+		return now();
+	}
+
+	/**
+	 * Rögzít egy művelet időtartamát.
+	 */
+	void record(HashOp op, uint64_t start) {
+		uint64_t t = now();
+		histograms[(int)op].add(t - start);
+		maybeDump(t);
+	}
+
+	/**
+	 * Rögzít egy rehash-t.
+	 */
+	void rehashed(HashOp cause, size_t elements, size_t fromBuckets, size_t toBuckets, uint64_t start) {
+		uint64_t t = now();
+		RehashEvent e = { cause, elements, fromBuckets, toBuckets, t - start };
+		events[nRehashes % keptEvents] = e;
+		++nRehashes;
+		histograms[(int)HashOp::Rehash].add(e.ns);
+	}
+
+	/**
+	 * @return a művelet hisztogramja
+	 */
+	const LatencyHistogram& histogram(HashOp op) const {
+		return histograms[(int)op];
+	}
+
+	/**
+	 * @return az összes rehash száma
+	 */
+	uint64_t rehashCount() const {
+		return nRehashes;
+	}
+
+	/**
+	 * @return a megtartott rehash események száma (legfeljebb keptEvents)
+	 */
+	size_t eventCount() const {
+		return nRehashes < keptEvents ? (size_t)nRehashes : keptEvents;
+	}
+
+	/**
+	 * @param i 0: a legrégebbi megtartott esemény, eventCount()-1: a legutóbbi
+	 */
+	const RehashEvent& event(size_t i) const {
+		size_t first = nRehashes < keptEvents ? 0 : (size_t)(nRehashes % keptEvents);
+		return events[(first + i) % keptEvents];
+	}
+
+	/**
+	 * Kiüríti a méréseket.
+	 */
+	void reset() {
+		for (int i = 0; i < (int)HashOp::count; ++i) histograms[i].reset();
+		nRehashes = 0;
+	}
+
+	/**
+	 * Beállítja az időközönkénti kiírást. A kiírás egy mért művelet végén történik, ha letelt a periódus.
+	 * @param os ide ír, nullptr: kikapcsolja
+	 * @param interval a periódus
+	 * @param format Text vagy Json
+	 */
+	void dumpEvery(std::ostream* os, std::chrono::nanoseconds interval, Format format = Text) {
+		dumpStream = os;
+		dumpIntervalNs = (uint64_t)interval.count();
+		dumpFormat = format;
+		lastDump = now();
+	}
+
+	/**
+	 * Kiírja a hisztogramok összefoglalóját (darab, min, átlag, p50, p90, p99, p99.9, max, ns-ban) és a rehash eseményeket.
+	 */
+	void dump(std::ostream& os, Format format = Text) const;
+};
+
+inline void LatencyInstrumentation::dump(std::ostream& os, Format format) const
+{
+	static const double ps[] = { 50, 90, 99, 99.9 };
+	static const char* pNames[] = { "p50", "p90", "p99", "p99_9" };
+	if (format == Json) os << "{\"operations\":{";
+	for (int i = 0; i < (int)HashOp::count; ++i) {
+		const LatencyHistogram& h = histograms[i];
+		if (format == Json) {
+			os << (i ? "," : "") << "\"" << hashOpName((HashOp)i) << "\":{\"count\":" << h.count()
+				<< ",\"min\":" << h.min() << ",\"mean\":" << (uint64_t)h.mean();
+			for (int p = 0; p < 4; ++p)
+				os << ",\"" << pNames[p] << "\":" << h.percentile(ps[p]);
+			os << ",\"max\":" << h.max() << "}";
+		}
+		else {
+			os << hashOpName((HashOp)i) << ": count=" << h.count() << " min=" << h.min() << " mean=" << (uint64_t)h.mean();
+			for (int p = 0; p < 4; ++p)
+				os << " " << pNames[p] << "=" << h.percentile(ps[p]);
+			os << " max=" << h.max() << " ns\n";
+		}
+	}
+	if (format == Json) os << "},\"rehashes\":" << nRehashes << ",\"recentRehashes\":[";
+	else os << "rehashes: " << nRehashes << "\n";
+	for (size_t i = 0; i < eventCount(); ++i) {
+		const RehashEvent& e = event(i);
+		if (format == Json)
+			os << (i ? "," : "") << "{\"cause\":\"" << hashOpName(e.cause) << "\",\"elements\":" << e.elements
+				<< ",\"fromBuckets\":" << e.fromBuckets << ",\"toBuckets\":" << e.toBuckets << ",\"ns\":" << e.ns << "}";
+		else
+			os << "  " << hashOpName(e.cause) << ": " << e.elements << " elements, " << e.fromBuckets << " -> " << e.toBuckets
+				<< " buckets, " << e.ns << " ns\n";
+	}
+	if (format == Json) os << "]}\n";
+	os.flush();
+}
+
+#endif // !INSTRUMENTATION_H
@@ -0,0 +1,262 @@
+﻿/*****************************************************************
+ * @file   kvclient.cpp
+ * @brief  Terhelés generátor a kvserver-hez: átviteli sebességet és késleltetés percentiliseket mér.
+ *         Fordítás: g++ -std=c++17 -O2 -pthread kvclient.cpp hashtable.cpp -o kvclient
+ *         Használat: kvclient [-s socket] [-c kapcsolatok] [-n kérések/kapcsolat] [-p pipeline mélység]
+ *                             [-k kulcstér] [-r olvasási arány %] [-b MGET köteg méret, 0: nincs MGET]
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "kvstore.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * A mérés beállításai.
+ */
+struct Options {
+	std::string path = "/tmp/hashtable.sock"; //< A szerver socketje
+	size_t connections = 4; //< Párhuzamos kapcsolatok (mindegyik külön szálon)
+	size_t requests = 100000; //< Kérések száma kapcsolatonként
+	size_t pipeline = 16; //< Legfeljebb ennyi válaszra nem várt kérés lehet egyszerre
+	size_t keys = 100000; //< A kulcstér mérete
+	size_t readPercent = 90; //< Az olvasások aránya százalékban
+	size_t batch = 0; //< Ha nem 0, az olvasások ekkora MGET kötegek
+};
+
+/**
+ * Csatlakozik a szerverhez.
+ * @return a socket, -1 hiba esetén
+ */
+static int connectTo(const std::string& path) {
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) return -1;
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+	if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/**
+ * Elküldi az egész puffert.
+ */
+static bool sendAll(int fd, const std::string& data) {
+	size_t sent = 0;
+	while (sent < data.size()) {
+		ssize_t n = write(fd, data.data() + sent, data.size() - sent);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return false;
+		sent += (size_t)n;
+	}
+	return true;
+}
+
+/**
+ * Egy kapcsolat olvasó oldala: beolvassa a válaszokat, és visszaadja, hány teljes keret jött.
+ */
+struct Receiver {
+	int fd; //< A socket
+	std::string in; //< Beérkezett byte-ok
+	size_t errors = 0; //< ERROR státuszú válaszok
+
+	/**
+	 * Blokkolva vár, amíg legalább egy teljes válasz megérkezik, és feldolgozza az összes teljeset.
+	 * @return a megérkezett válaszok száma, 0 ha a kapcsolat megszakadt
+	 */
+	size_t receive() {
+		char buf[64 * 1024];
+		for (;;) {
+			size_t done = 0, count = 0, frame;
+			while ((frame = kv::frameLength(in.data() + done, in.size() - done)) != 0) {
+				if (frame > 4 && (uint8_t)in[done + 4] == kv::ERROR) ++errors;
+				done += frame;
+				++count;
+			}
+			in.erase(0, done);
+			if (count != 0) return count;
+			ssize_t n = read(fd, buf, sizeof(buf));
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) return 0;
+			in.append(buf, (size_t)n);
+		}
+	}
+};
+
+static std::string keyName(size_t i) {
+	return "key" + std::to_string(i);
+}
+
+/**
+ * Feltölti a kulcsteret, hogy az olvasások találjanak.
+ */
+static bool preload(const Options& o) {
+	int fd = connectTo(o.path);
+	if (fd < 0) return false;
+	Receiver r{ fd, std::string(), 0 };
+	std::string out;
+	size_t pending = 0;
+	for (size_t i = 0; i < o.keys; ++i) {
+		kv::encodePut(out, 0, keyName(i), std::string(32, 'v'));
+		++pending;
+		if (out.size() > 64 * 1024 || i + 1 == o.keys) {
+			if (!sendAll(fd, out)) { close(fd); return false; }
+			out.clear();
+			while (pending > 0) {
+				size_t got = r.receive();
+				if (got == 0) { close(fd); return false; }
+				pending -= got;
+			}
+		}
+	}
+	close(fd);
+	return true;
+}
+
+/**
+ * Egy kapcsolat terhelése. A kérések küldési idejét egy FIFO-ban tartja, a válaszok sorrendben jönnek.
+ * @param latencies ide kerülnek a kérések késleltetései nanoszekundumban
+ * @return sikerült-e
+ */
+static bool worker(const Options& o, unsigned seed, std::vector<uint64_t>& latencies, size_t& errors) {
+	int fd = connectTo(o.path);
+	if (fd < 0) return false;
+	Receiver r{ fd, std::string(), 0 };
+	std::mt19937_64 rng(seed);
+	std::uniform_int_distribution<size_t> keyDist(0, o.keys - 1);
+	std::uniform_int_distribution<size_t> pctDist(0, 99);
+	std::deque<Clock::time_point> inFlight;
+	latencies.reserve(o.requests);
+
+	std::string out;
+	std::vector<std::string> batch;
+	size_t sent = 0;
+	while (latencies.size() < o.requests) {
+		// Feltölti a pipeline-t, és egyetlen write-tal küldi el
+		out.clear();
+		while (sent < o.requests && inFlight.size() < o.pipeline) {
+			if (pctDist(rng) < o.readPercent) {
+				if (o.batch > 0) {
+					batch.clear();
+					for (size_t i = 0; i < o.batch; ++i)
+						batch.push_back(keyName(keyDist(rng)));
+					kv::encodeMget(out, 0, batch);
+				}
+				else {
+					kv::encodeGet(out, 0, keyName(keyDist(rng)));
+				}
+			}
+			else {
+				kv::encodePut(out, 0, keyName(keyDist(rng)), std::string(32, 'w'));
+			}
+			++sent;
+			inFlight.push_back(Clock::now());
+		}
+		if (!out.empty() && !sendAll(fd, out)) { close(fd); return false; }
+
+		size_t got = r.receive();
+		if (got == 0) { close(fd); return false; }
+		Clock::time_point now = Clock::now();
+		for (size_t i = 0; i < got; ++i) {
+			latencies.push_back((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - inFlight.front()).count());
+			inFlight.pop_front();
+		}
+	}
+	errors = r.errors;
+	close(fd);
+	return true;
+}
+
+/**
+ * @return a rendezett minták p-edik percentilise mikroszekundumban
+ */
+static double percentileUs(const std::vector<uint64_t>& sorted, double p) {
+	if (sorted.empty()) return 0.0;
+	size_t i = (size_t)(p / 100.0 * (double)(sorted.size() - 1) + 0.5);
+	return (double)sorted[i] / 1000.0;
+}
+
+int main(int argc, char** argv) {
+	Options o;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string flag = argv[i];
+		size_t v = std::strtoul(argv[i + 1], nullptr, 10);
+		if (flag == "-s") o.path = argv[i + 1];
+		else if (flag == "-c") o.connections = v;
+		else if (flag == "-n") o.requests = v;
+		else if (flag == "-p") o.pipeline = v;
+		else if (flag == "-k") o.keys = v;
+		else if (flag == "-r") o.readPercent = v;
+		else if (flag == "-b") o.batch = v;
+		else {
+			std::cerr << "Hasznalat: " << argv[0] << " [-s socket] [-c kapcsolatok] [-n keresek] [-p pipeline] [-k kulcster] [-r olvasas%] [-b mget koteg]" << std::endl;
+			return 1;
+		}
+	}
+	if (o.connections == 0 || o.pipeline == 0 || o.keys == 0) {
+		std::cerr << "A kapcsolatok, a pipeline es a kulcster nem lehet 0." << std::endl;
+		return 1;
+	}
+	if (o.batch > 0xffff) {
+		std::cerr << "Egy MGET koteg legfeljebb 65535 kulcs lehet." << std::endl;
+		return 1;
+	}
+
+	if (!preload(o)) {
+		std::cerr << "Nem sikerult csatlakozni: " << o.path << std::endl;
+		return 1;
+	}
+
+	std::vector<std::vector<uint64_t>> latencies(o.connections);
+	std::vector<size_t> errors(o.connections, 0);
+	std::vector<char> ok(o.connections, 0);
+	std::vector<std::thread> threads;
+	Clock::time_point start = Clock::now();
+	for (size_t c = 0; c < o.connections; ++c)
+		threads.emplace_back([&, c]() { ok[c] = worker(o, (unsigned)(c + 1), latencies[c], errors[c]); });
+	for (std::thread& t : threads)
+		t.join();
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::vector<uint64_t> all;
+	size_t totalErrors = 0;
+	for (size_t c = 0; c < o.connections; ++c) {
+		if (!ok[c]) std::cerr << "A(z) " << c << ". kapcsolat megszakadt." << std::endl;
+		all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+		totalErrors += errors[c];
+	}
+	std::sort(all.begin(), all.end());
+
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "kapcsolatok=" << o.connections << " pipeline=" << o.pipeline << " olvasas=" << o.readPercent << "%";
+	if (o.batch > 0) std::cout << " mget=" << o.batch;
+	std::cout << std::endl;
+	std::cout << "keresek: " << all.size() << ", hibak: " << totalErrors << ", ido: " << seconds << " s" << std::endl;
+	std::cout << "atvitel: " << (double)all.size() / seconds << " keres/s" << std::endl;
+	std::cout << "kesleltetes (us): p50=" << percentileUs(all, 50) << " p90=" << percentileUs(all, 90)
+		<< " p99=" << percentileUs(all, 99) << " p99.9=" << percentileUs(all, 99.9) << std::endl;
+	return 0;
+}
@@ -0,0 +1,214 @@
+﻿/*****************************************************************
+ * @file   kvserver.cpp
+ * @brief  Önálló kulcs-érték szerver Unix domain socketen, epoll eseményhurokkal.
+ *         Fordítás: g++ -std=c++17 -O2 kvserver.cpp hashtable.cpp -o kvserver
+ *         Használat: kvserver [-s socket] [-t táblák száma]
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+
+#include "kvstore.hpp"
+
+/**
+ * Ennyi elküldetlen válasz byte fölött nem olvasunk többet a kapcsolatról, amíg a kliens le nem olvassa őket.
+ * Így egy pipeline-t csak küldő, de a válaszokat nem olvasó kliens nem tudja korlátlanul növelni a puffert.
+ */
+static const size_t outHighWater = 1 << 20;
+
+/**
+ * Egy kliens kapcsolat pufferei.
+ */
+struct Connection {
+	int fd; //< A socket
+	std::string in; //< Beérkezett, még fel nem dolgozott byte-ok
+	std::string out; //< Elküldendő válaszok
+	size_t outSent; //< Az out-ból már elküldött byte-ok
+	bool wantRead; //< Fel van-e iratkozva EPOLLIN-re
+	bool wantWrite; //< Fel van-e iratkozva EPOLLOUT-ra
+	bool readClosed; //< A kliens lezárta az író oldalát, több kérés nem jön
+	Connection(int fd) :fd(fd), outSent(0), wantRead(true), wantWrite(false), readClosed(false) {};
+
+	/**
+	 * @return az elküldetlen válasz byte-ok száma
+	 */
+	size_t pending() const {
+		return out.size() - outSent;
+	}
+};
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int) {
+	running = 0;
+}
+
+/**
+ * Nem blokkolóvá teszi a file leírót.
+ */
+static bool setNonBlocking(int fd) {
+	int flags = fcntl(fd, F_GETFL, 0);
+	return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/**
+ * Az epoll feliratkozást a kapcsolat állapotához igazítja: olvasás, ha a kliens még küldhet, és a válaszok
+ * a felső határ alatt vannak, írás, ha van elküldetlen válasz.
+ */
+static void updateEvents(int epfd, Connection& c) {
+	bool wantRead = !c.readClosed && c.pending() < outHighWater;
+	bool wantWrite = c.pending() != 0;
+	if (wantRead == c.wantRead && wantWrite == c.wantWrite) return;
+	epoll_event ev;
+	ev.events = (wantRead ? (uint32_t)EPOLLIN : 0u) | (wantWrite ? (uint32_t)EPOLLOUT : 0u);
+	ev.data.ptr = &c;
+	epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &ev);
+	c.wantRead = wantRead;
+	c.wantWrite = wantWrite;
+}
+
+/**
+ * Elküldi a kapcsolat összegyűlt válaszait, amennyi éppen kifér.
+ * @return false, ha a kapcsolatot le kell zárni: megszakadt, vagy a kliens lezárta az író oldalát, és minden válasz elment
+ */
+static bool flush(int epfd, Connection& c) {
+	while (c.outSent < c.out.size()) {
+		ssize_t n = write(c.fd, c.out.data() + c.outSent, c.out.size() - c.outSent);
+		if (n > 0) {
+			c.outSent += (size_t)n;
+			continue;
+		}
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+		return false;
+	}
+	if (c.outSent == c.out.size()) {
+		c.out.clear();
+		c.outSent = 0;
+	}
+	if (c.readClosed && c.pending() == 0)
+		return false;
+	updateEvents(epfd, c);
+	return true;
+}
+
+/**
+ * Beolvas mindent, ami elérhető (amíg a válaszok a felső határ alatt vannak), végrehajtja a teljes kéréseket,
+ * és a válaszokat egyben küldi el. Ha a kliens lezárta az író oldalát, a már beérkezett kérésekre még válaszol.
+ * @return false, ha a kapcsolatot le kell zárni
+ */
+static bool serve(int epfd, KvStore& store, Connection& c) {
+	char buf[64 * 1024];
+	while (c.pending() < outHighWater) {
+		ssize_t n = read(c.fd, buf, sizeof(buf));
+		if (n > 0) {
+			c.in.append(buf, (size_t)n);
+			try {
+				size_t done = store.process(c.in.data(), c.in.size(), c.out);
+				c.in.erase(0, done);
+			}
+			catch (std::length_error&) {
+				return false;
+			}
+			continue;
+		}
+		if (n == 0) { // A kliens lezárta az író oldalát, a c.in-ben maradt csonka kérés már nem egészül ki
+			c.readClosed = true;
+			break;
+		}
+		if (errno == EINTR) continue;
+		if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+		return false;
+	}
+	return flush(epfd, c);
+}
+
+int main(int argc, char** argv) {
+	std::string path = "/tmp/hashtable.sock";
+	size_t nTables = 1;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (std::strcmp(argv[i], "-s") == 0) path = argv[i + 1];
+		else if (std::strcmp(argv[i], "-t") == 0) nTables = std::strtoul(argv[i + 1], nullptr, 10);
+		else {
+			std::cerr << "Hasznalat: " << argv[0] << " [-s socket] [-t tablak]" << std::endl;
+			return 1;
+		}
+	}
+
+	KvStore store(nTables);
+	signal(SIGINT, stop);
+	signal(SIGTERM, stop);
+	signal(SIGPIPE, SIG_IGN);
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0) { perror("socket"); return 1; }
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path)) { std::cerr << "Tul hosszu socket utvonal." << std::endl; return 1; }
+	std::strcpy(addr.sun_path, path.c_str());
+	unlink(path.c_str());
+	if (bind(listener, (sockaddr*)&addr, sizeof(addr)) < 0) { perror("bind"); return 1; }
+	if (listen(listener, 128) < 0) { perror("listen"); return 1; }
+	setNonBlocking(listener);
+
+	int epfd = epoll_create1(0);
+	if (epfd < 0) { perror("epoll_create1"); return 1; }
+	epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.ptr = nullptr; // nullptr: a figyelő socket
+	epoll_ctl(epfd, EPOLL_CTL_ADD, listener, &ev);
+
+	std::cout << "Figyel: " << path << ", " << nTables << " tabla" << std::endl;
+	epoll_event events[256];
+	while (running) {
+		int n = epoll_wait(epfd, events, 256, 500);
+		if (n < 0 && errno != EINTR) { perror("epoll_wait"); break; }
+		for (int i = 0; i < n; ++i) {
+			if (events[i].data.ptr == nullptr) {
+				int fd;
+				while ((fd = accept(listener, nullptr, nullptr)) >= 0) {
+					setNonBlocking(fd);
+					Connection* c = new Connection(fd);
+					epoll_event cev;
+					cev.events = EPOLLIN;
+					cev.data.ptr = c;
+					epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &cev);
+				}
+				continue;
+			}
+			Connection* c = (Connection*)events[i].data.ptr;
+			bool ok = true;
+			if (events[i].events & (EPOLLERR | EPOLLHUP))
+				ok = (events[i].events & EPOLLIN) != 0; // Előbb még feldolgozzuk, ami beérkezett
+			if (ok && (events[i].events & EPOLLIN))
+				ok = serve(epfd, store, *c);
+			if (ok && (events[i].events & EPOLLOUT))
+				ok = flush(epfd, *c);
+			if (!ok) {
+				epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, nullptr);
+				close(c->fd);
+				delete c;
+			}
+		}
+	}
+	close(epfd);
+	close(listener);
+	unlink(path.c_str());
+	return 0;
+}
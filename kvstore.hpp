@@ -0,0 +1,299 @@
+﻿/*****************************************************************
+ * @file   kvstore.hpp
+ * @brief  Kulcs-érték szerver protokollja és a kérések végrehajtása (socketek nélkül).
+ *         A kvserver.cpp és a kvclient.cpp is ezt használja.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef KVSTORE_H
+#define KVSTORE_H
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include "hashtable.hpp"
+
+#include "memtrace.h"
+
+/**
+ * A protokoll. Minden szám little-endian (a szerver és a kliens ugyanazon a gépen fut).
+ *
+ * Kérés:  u32 hossz (a hossz mező után következő byte-ok száma), u8 művelet, u8 tábla, majd:
+ *   GET:  u16 kulcshossz, kulcs
+ *   PUT:  u16 kulcshossz, u32 értékhossz, kulcs, érték
+ *   DEL:  u16 kulcshossz, kulcs
+ *   MGET: u16 darab, majd darabszor (u16 kulcshossz, kulcs)
+ * Válasz: u32 hossz, u8 státusz, majd:
+ *   GET OK: u32 értékhossz, érték
+ *   MGET OK: u16 darab, majd darabszor (u8 megvan, ha megvan: u32 értékhossz, érték)
+ *   PUT, DEL és a hibák: nincs több adat
+ * A válaszok a kérések sorrendjében jönnek, így a kliens várakozás nélkül küldhet több kérést (pipelining).
+ */
+namespace kv {
+	enum Op : uint8_t { GET = 1, PUT = 2, DEL = 3, MGET = 4 };
+	enum Status : uint8_t { OK = 0, NOT_FOUND = 1, ERROR = 2 };
+
+	const size_t maxFrame = 16 * 1024 * 1024; //< Ennél hosszabb keret protokollhiba
+
+	inline void putU8(std::string& out, uint8_t v) {
+		out.push_back((char)v);
+	}
+	inline void putU16(std::string& out, uint16_t v) {
+		out.push_back((char)(v & 0xff));
+		out.push_back((char)(v >> 8));
+	}
+	inline void putU32(std::string& out, uint32_t v) {
+		for (int i = 0; i < 4; ++i)
+			out.push_back((char)((v >> (8 * i)) & 0xff));
+	}
+	inline uint16_t getU16(const char* p) {
+		return (uint16_t)((unsigned char)p[0] | ((unsigned char)p[1] << 8));
+	}
+	inline uint32_t getU32(const char* p) {
+		return (uint32_t)(unsigned char)p[0] | ((uint32_t)(unsigned char)p[1] << 8) | ((uint32_t)(unsigned char)p[2] << 16) | ((uint32_t)(unsigned char)p[3] << 24);
+	}
+
+	/**
+	 * @return a data elején álló teljes keret hossza (a hossz mezővel együtt), 0 ha még nem jött meg az egész.
+	 * @throw std::length_error ha a keret hosszabb a megengedettnél
+	 */
+	inline size_t frameLength(const char* data, size_t len) {
+		if (len < 4) return 0;
+		size_t body = getU32(data);
+		if (body > maxFrame) throw std::length_error("Tul hosszu keret.");
+		return (len >= 4 + body) ? 4 + body : 0;
+	}
+
+	/**
+	 * Elkezd egy keretet, a hosszt a finish() írja be.
+	 * @return a keret kezdete az out-ban
+	 */
+	inline size_t begin(std::string& out) {
+		size_t start = out.size();
+		putU32(out, 0);
+		return start;
+	}
+	/**
+	 * Beírja a keret hosszát.
+	 */
+	inline void finish(std::string& out, size_t start) {
+		uint32_t body = (uint32_t)(out.size() - start - 4);
+		for (int i = 0; i < 4; ++i)
+			out[start + i] = (char)((body >> (8 * i)) & 0xff);
+	}
+
+	/**
+	 * Ellenőrzi, hogy egy u16 hosszmező el tudja-e tárolni n-et. Az encode* függvények még az írás előtt hívják,
+	 * így csonkolt hossz nem kerülhet a keretbe, és hiba esetén az out nem változik.
+	 * @throw std::length_error ha n nagyobb 65535-nél
+	 */
+	inline void checkU16(size_t n) {
+		if (n > 0xffff) throw std::length_error("Tul hosszu kulcs vagy tul sok kulcs (legfeljebb 65535).");
+	}
+
+	inline void encodeGet(std::string& out, uint8_t table, const std::string& key) {
+		checkU16(key.size());
+		size_t s = begin(out);
+		putU8(out, GET); putU8(out, table);
+		putU16(out, (uint16_t)key.size());
+		out += key;
+		finish(out, s);
+	}
+	inline void encodePut(std::string& out, uint8_t table, const std::string& key, const std::string& value) {
+		checkU16(key.size());
+		if (8 + key.size() + value.size() > maxFrame) throw std::length_error("Tul hosszu keret.");
+		size_t s = begin(out);
+		putU8(out, PUT); putU8(out, table);
+		putU16(out, (uint16_t)key.size());
+		putU32(out, (uint32_t)value.size());
+		out += key;
+		out += value;
+		finish(out, s);
+	}
+	inline void encodeDel(std::string& out, uint8_t table, const std::string& key) {
+		checkU16(key.size());
+		size_t s = begin(out);
+		putU8(out, DEL); putU8(out, table);
+		putU16(out, (uint16_t)key.size());
+		out += key;
+		finish(out, s);
+	}
+	inline void encodeMget(std::string& out, uint8_t table, const std::vector<std::string>& keys) {
+		checkU16(keys.size());
+		size_t total = 4;
+		for (const std::string& key : keys) {
+			checkU16(key.size());
+			total += 2 + key.size();
+		}
+		if (total > maxFrame) throw std::length_error("Tul hosszu keret.");
+		size_t s = begin(out);
+		putU8(out, MGET); putU8(out, table);
+		putU16(out, (uint16_t)keys.size());
+		for (const std::string& key : keys) {
+			putU16(out, (uint16_t)key.size());
+			out += key;
+		}
+		finish(out, s);
+	}
+
+	/**
+	 * std::hash alapú hash függvény a szerver tábláihoz.
+	 */
+	inline size_t stdHash(const std::string key, const size_t maxSize) {
+		return std::hash<std::string>()(key) % maxSize;
+	}
+}
+
+/**
+ * Egy vagy több HashTable, amin a protokoll kéréseit végre lehet hajtani.
+ */
+class KvStore {
+	typedef HashTable<std::string, std::string, kv::stdHash, 4096> table;
+	std::vector<std::unique_ptr<table>> tables; //< A táblák, a kérésben lévő sorszám szerint
+
+	/**
+	 * Biztonságos olvasó a keret belsejéhez.
+	 */
+	struct Reader {
+		const char* p; //< A következő olvasandó byte
+		const char* end; //< A keret vége
+		bool ok; //< false, ha túlolvastunk
+		bool need(size_t n) {
+			if ((size_t)(end - p) < n) ok = false;
+			return ok;
+		}
+		uint8_t u8() { if (!need(1)) return 0; return (uint8_t)*p++; }
+		uint16_t u16() { if (!need(2)) return 0; uint16_t v = kv::getU16(p); p += 2; return v; }
+		uint32_t u32() { if (!need(4)) return 0; uint32_t v = kv::getU32(p); p += 4; return v; }
+		std::string str(size_t n) { if (!need(n)) return std::string(); std::string s(p, n); p += n; return s; }
+	};
+
+	/**
+	 * Végrehajt egy kérést, és a válasz keretet az out végére írja.
+	 */
+	void execute(const char* body, size_t len, std::string& out);
+
+	KvStore(const KvStore&); //< Másoló konstruktor tiltása
+	KvStore& operator=(const KvStore&); //< Értékadás tiltása
+public:
+	/**
+	 * Konstruktor.
+	 * @param nTables ennyi táblát hoz létre (legfeljebb 256)
+	 */
+	explicit KvStore(size_t nTables = 1) {
+		if (nTables == 0 || nTables > 256) throw std::invalid_argument("1 es 256 kozotti szamu tabla lehet.");
+		for (size_t i = 0; i < nTables; ++i)
+			tables.push_back(std::unique_ptr<table>(new table()));
+	}
+
+	/**
+	 * Végrehajtja a data-ban lévő összes teljes kérést, a válaszokat sorban az out végére írja.
+	 * @return a feldolgozott byte-ok száma. A maradék egy még be nem érkezett kérés eleje.
+	 * @throw std::length_error ha egy keret hosszabb a megengedettnél (ilyenkor a kapcsolatot le kell zárni)
+	 */
+	size_t process(const char* data, size_t len, std::string& out) {
+		size_t done = 0;
+		size_t frame;
+		while ((frame = kv::frameLength(data + done, len - done)) != 0) {
+			execute(data + done + 4, frame - 4, out);
+			done += frame;
+		}
+		return done;
+	}
+
+	/**
+	 * @return a táblák száma
+	 */
+	size_t size() const {
+		return tables.size();
+	}
+
+	/**
+	 * @return a megadott tábla elemszáma
+	 */
+	size_t size(size_t table) const {
+		return tables.at(table)->size();
+	}
+};
+
+inline void KvStore::execute(const char* body, size_t len, std::string& out)
+{
+	Reader r = { body, body + len, true };
+	uint8_t op = r.u8();
+	uint8_t t = r.u8();
+	size_t s = kv::begin(out);
+	if (!r.ok || t >= tables.size()) {
+		kv::putU8(out, kv::ERROR);
+		kv::finish(out, s);
+		return;
+	}
+	table& tab = *tables[t];
+
+	switch (op) {
+	case kv::GET: {
+		std::string key = r.str(r.u16());
+		if (!r.ok) break;
+		std::string* value = tab.get(key);
+		if (value == nullptr) {
+			kv::putU8(out, kv::NOT_FOUND);
+		}
+		else {
+			kv::putU8(out, kv::OK);
+			kv::putU32(out, (uint32_t)value->size());
+			out += *value;
+		}
+		kv::finish(out, s);
+		return;
+	}
+	case kv::PUT: {
+		uint16_t keyLen = r.u16();
+		uint32_t valueLen = r.u32();
+		std::string key = r.str(keyLen);
+		std::string value = r.str(valueLen);
+		if (!r.ok) break;
+		tab.find_or_insert(key).first->value = value; // Felülírja, ha már benne volt
+		kv::putU8(out, kv::OK);
+		kv::finish(out, s);
+		return;
+	}
+	case kv::DEL: {
+		std::string key = r.str(r.u16());
+		if (!r.ok) break;
+		kv::putU8(out, tab.remove(key) ? kv::OK : kv::NOT_FOUND);
+		kv::finish(out, s);
+		return;
+	}
+	case kv::MGET: {
+		uint16_t n = r.u16();
+		kv::putU8(out, kv::OK);
+		kv::putU16(out, n);
+		for (uint16_t i = 0; i < n && r.ok; ++i) {
+			std::string key = r.str(r.u16());
+			std::string* value = tab.get(key);
+			kv::putU8(out, value != nullptr);
+			if (value != nullptr) {
+				kv::putU32(out, (uint32_t)value->size());
+				out += *value;
+			}
+		}
+		if (!r.ok) break;
+		kv::finish(out, s);
+		return;
+	}
+	default:
+		break;
+	}
+	// Hibás kérés: a megkezdett választ hibára cseréli
+	out.resize(s);
+	s = kv::begin(out);
+	kv::putU8(out, kv::ERROR);
+	kv::finish(out, s);
+}
+
+#endif // !KVSTORE_H
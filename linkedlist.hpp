@@ -10,14 +10,16 @@
 #ifndef LINKEDLIST_H
 #define LINKEDLIST_H
 #include <iostream>
+#include <memory>
 
 #include "memtrace.h"
 
 /**
  * Generikus Láncolt Lista. (nem sorrendtartó)
  * @tparam T a tárolt elemek típusa
+ * @tparam Alloc a listaelemek foglalásához használt allokátor (default: std::allocator<T>)
  */
-template<typename T>
+template<typename T, typename Alloc = std::allocator<T>>
 class LinkedList {
 	/**
 	 * Láncoltlistaelem: Segédclass az elemek tárolásához. 
@@ -32,16 +34,50 @@ class LinkedList {
 		LinkedListItem(T data):data(data), next(nullptr) {};
 	};
 
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<LinkedListItem> itemAlloc;
+	typedef std::allocator_traits<itemAlloc> traits;
+
+	/**
+	 * A listaelemek allokátora.
+	 */
+	itemAlloc alloc;
+
 	/**
 	 * Az első láncoltlistaelem.
 	 */
 	LinkedListItem* first;
 	LinkedList(const LinkedList&); //< Másoló konstzruktor tiltása
+
+	/**
+	 * Felszabadítja a lista összes elemét.
+	 */
+	void clear();
+public:
+	typedef Alloc allocator_type;
+
+	/**
+	 * Egy elem helye a bejárásban: az elemre mutató pointer (first, vagy az előző listaelem next-je) címe.
+	 * Ezzel az elem keresés nélkül kiláncolható. Egy push után elavulhat, ezt a getNext és az erase észreveszi,
+	 * és az elejéről keres. Az előző elem törlése érvényteleníti.
+	 */
+	class position {
+		friend class LinkedList;
+		LinkedListItem** link; //< Az elemre mutató pointer címe, vagy nullptr, ha nem ismert
+	public:
+		position() :link(nullptr) {};
+	};
+private:
+	/**
+	 * @return az elemre mutató pointer címe: a pos-é, ha még arra mutat, különben megkeresi. nullptr, ha nincs a listában.
+	 */
+	LinkedListItem** linkTo(const T* item, position pos);
 public:
+
 	/**
 	 * Default konstruktor.
+	 * @param alloc a listaelemek foglalásához használt allokátor
 	 */
-	LinkedList() :first(nullptr) {};
+	LinkedList(const Alloc& alloc = Alloc()) :alloc(alloc), first(nullptr) {};
 
 	/**
 	 * Lemásolja a listát, (de fordított sorrendben), nem elvárt, hogy sorrendtartó legyen a lista.
@@ -51,14 +87,59 @@ public:
 	/**
 	 * Hozzáad egy elemet a lista elejéhez
 	 * @param item a tárolandóü elem
+	 * @return a tárolt elemre mutató pointer
+	 */
+	T* push(T item); 
+
+	/**
+	 * Hozzáad egy elemet a lista elejéhez, és megadja a helyét.
+	 * @param item a tárolandó elem
+	 * @param pos ide kerül a tárolt elem helye
+	 * @return a tárolt elemre mutató pointer
 	 */
-	void push(T item); 
+	T* push(T item, position& pos);
 
 	/**
-	 * Kitörli a megadott elemet a listából
+	 * Kitörli a megadott elemet a listából. Egyszer megy végig a listán.
 	 * @param item A törlendő elem referenciája.
+	 * @return true, ha benne volt és törölte
+	 */
+	bool remove(const T& item);
+
+	/**
+	 * Kitörli a megadott címen lévő elemet (pl. a find vagy a getNext eredményét).
+	 * @param item a listában lévő elemre mutató pointer
+	 * @return a lista következő elemére mutató pointer, vagy nullptr, ha ez volt az utolsó
+	 */
+	T* erase(const T* item);
+
+	/**
+	 * Kitörli a megadott címen lévő elemet. Ha a pos az elem helye, nem keres, különben egyszer végigmegy a listán.
+	 * @param item a listában lévő elemre mutató pointer
+	 * @param pos az elem helye, a visszatérés után a következő elem helye
+	 * @return a lista következő elemére mutató pointer, vagy nullptr, ha ez volt az utolsó
 	 */
-	void remove(const T& item);
+	T* erase(const T* item, position& pos);
+
+	/**
+	 * Egyetlen bejárással kitörli az összes elemet, amire a pred igaz.
+	 * A kiláncolt listaelemek a bejárás végén együtt szabadulnak fel.
+	 * @param pred pred(T&) -> bool
+	 * @return a törölt elemek száma
+	 */
+	template<typename F>
+	size_t erase_if(F pred);
+
+	/**
+	 * Egyetlen bejárással átláncolja a dst elejére az összes elemet, amire a pred igaz.
+	 * Nem másol és nem foglal, a listaelemek (és így az elemek címei) megmaradnak.
+	 * A dst-nek ugyanolyan allokátorral kell foglalnia, mert a listaelemeket ő szabadítja fel.
+	 * @param dst a cél lista
+	 * @param pred pred(T&) -> bool
+	 * @return az átláncolt elemek száma
+	 */
+	template<typename F>
+	size_t splice_if(LinkedList& dst, F pred);
 
 	/**
 	 * Megkeresi a megadott elemet.
@@ -67,6 +148,14 @@ public:
 	 */
 	T* find(const T& item);
 
+	/**
+	 * Megkeresi a megadott elemet, és megadja a helyét, hogy utána keresés nélkül lehessen törölni.
+	 * @param item Az elem referenciája.
+	 * @param pos ide kerül az elem helye, ha benne van
+	 * @return Az elemre mutató pointer, ha nincs a listában, nullptr-t ad
+	 */
+	T* find(const T& item, position& pos);
+
 	/**
 	 * Megkeresi a lista megadott elem utáni elemét. 
 	 * @param item Az elem referenciája.
@@ -74,28 +163,62 @@ public:
 	 */
 	T* getNext(const T& item); 
 
+	/**
+	 * A lista megadott elem utáni eleme. Ha a pos az elem helye, nem keres.
+	 * @param item a listában lévő elemre mutató pointer
+	 * @param pos az elem helye, a visszatérés után a következő elem helye
+	 * @return a következő elemre mutató pointer, vagy nullptr
+	 */
+	T* getNext(const T* item, position& pos);
+
 	/**
 	 * @return visszaadja az első elemére mutató ptr-t, vagy nullptr-t, ha üres a lista.
 	 */
 	T* getFirst();
 
+	/**
+	 * @param pos ide kerül az első elem helye
+	 * @return az első elemére mutató ptr, vagy nullptr, ha üres a lista.
+	 */
+	T* getFirst(position& pos);
+
 	/**
 	 * @return visszaadja, hogy üres-e a láncolt lista
 	 */
 	bool isEmpty() const;
 
+	/**
+	 * @return a lista elemeinek száma. Végigmegy a listán.
+	 */
+	size_t length() const;
+
+	/**
+	 * @return a használt allokátor másolata
+	 */
+	Alloc get_allocator() const;
+
 	/**
 	 * Destruktor
 	 */
 	~LinkedList();
 };
 
+/**
+ * Láncolt listás vödrök (alapértelmezett): minden elem külön listaelemben.
+ */
+struct LinkedChain {
+	template <typename T, typename Alloc>
+	using list = LinkedList<T, Alloc>;
+};
 
-template<typename T>
-inline LinkedList<T>& LinkedList<T>::operator=(const LinkedList& rhs)
+
+template<typename T, typename Alloc>
+inline LinkedList<T, Alloc>& LinkedList<T, Alloc>::operator=(const LinkedList& rhs)
 {
 	if (this == &rhs) return *this; // önértékadás
-	this->~LinkedList(); // Meg kell szüntetni a lista tartalmát, mielőtt feltöltjük.
+	clear(); // Meg kell szüntetni a lista tartalmát, mielőtt feltöltjük.
+	if constexpr (traits::propagate_on_container_copy_assignment::value)
+		alloc = rhs.alloc;
 	LinkedListItem* iter = rhs.first;
 	while (iter != nullptr)
 	{
@@ -105,42 +228,125 @@ inline LinkedList<T>& LinkedList<T>::operator=(const LinkedList& rhs)
 	return *this;
 }
 
-template<typename T>
-inline void LinkedList<T>::push(T item)
+template<typename T, typename Alloc>
+inline T* LinkedList<T, Alloc>::push(T item)
 {
 	LinkedListItem* tmp = first;
-	first = new LinkedListItem(item);
+	first = traits::allocate(alloc, 1);
+	traits::construct(alloc, first, item);
 	first->next = tmp;
+	return &(first->data);
+}
+
+template<typename T, typename Alloc>
+inline T* LinkedList<T, Alloc>::push(T item, position& pos)
+{
+	T* res = push(item);
+	pos.link = &first;
+	return res;
 }
 
 
 
-template<typename T>
-inline void LinkedList<T>::remove(const T& item)
+template<typename T, typename Alloc>
+inline bool LinkedList<T, Alloc>::remove(const T& item)
 {
-	LinkedListItem* iter = first;
-	T* res = find(item);
-	if (res == nullptr) return;
+	// A link arra a pointerre mutat, ami az aktuális elemre mutat (first vagy az előző next-je),
+	// így a kiláncoláshoz nem kell még egyszer megkeresni az előző elemet.
+	for (LinkedListItem** link = &first; *link != nullptr; link = &(*link)->next) {
+		if (!((*link)->data != item)) {
+			LinkedListItem* dead = *link;
+			*link = dead->next;
+			traits::destroy(alloc, dead);
+			traits::deallocate(alloc, dead, 1);
+			return true;
+		}
+	}
+	return false;
+}
 
-	LinkedListItem* prev = nullptr;
-	while (iter != nullptr) {
-		if (&(iter->data) == res) break;
-		prev = iter;
-		iter = iter->next;
+template<typename T, typename Alloc>
+inline typename LinkedList<T, Alloc>::LinkedListItem** LinkedList<T, Alloc>::linkTo(const T* item, position pos)
+{
+	if (pos.link != nullptr && *pos.link != nullptr && &(*pos.link)->data == item)
+		return pos.link;
+	for (LinkedListItem** link = &first; *link != nullptr; link = &(*link)->next) {
+		if (&(*link)->data == item)
+			return link;
+	}
+	return nullptr;
+}
+
+template<typename T, typename Alloc>
+inline T* LinkedList<T, Alloc>::erase(const T* item)
+{
+	position pos;
+	return erase(item, pos);
+}
+
+template<typename T, typename Alloc>
+inline T* LinkedList<T, Alloc>::erase(const T* item, position& pos)
+{
+	LinkedListItem** link = linkTo(item, pos);
+	if (link == nullptr) return nullptr;
+	LinkedListItem* dead = *link;
+	*link = dead->next;
+	traits::destroy(alloc, dead);
+	traits::deallocate(alloc, dead, 1);
+	pos.link = link;
+	return *link == nullptr ? nullptr : &(*link)->data;
+}
+
+template<typename T, typename Alloc>
+template<typename F>
+inline size_t LinkedList<T, Alloc>::erase_if(F pred)
+{
+	LinkedListItem* garbage = nullptr; // A kiláncolt elemek
+	size_t n = 0;
+	for (LinkedListItem** link = &first; *link != nullptr;) {
+		if (pred((*link)->data)) {
+			LinkedListItem* dead = *link;
+			*link = dead->next;
+			dead->next = garbage;
+			garbage = dead;
+			++n;
+		}
+		else {
+			link = &(*link)->next;
+		}
 	}
-	// Újralinkel
-	if (prev != nullptr)
-		prev->next = (iter == nullptr) ? nullptr : iter->next;
-	else
-		first = nullptr;
+	while (garbage != nullptr) {
+		LinkedListItem* next = garbage->next;
+		traits::destroy(alloc, garbage);
+		traits::deallocate(alloc, garbage, 1);
+		garbage = next;
+	}
+	return n;
+}
 
-	// Ha nullptr-t töröl nincs hatás
-	delete iter;
+template<typename T, typename Alloc>
+template<typename F>
+inline size_t LinkedList<T, Alloc>::splice_if(LinkedList& dst, F pred)
+{
+	size_t n = 0;
+	for (LinkedListItem** link = &first; *link != nullptr;) {
+		LinkedListItem* moving = *link;
+		if (pred(moving->data)) {
+			*link = moving->next;
+			moving->next = dst.first;
+			dst.first = moving;
+			++n;
+		}
+		else {
+			link = &moving->next;
+		}
+	}
+	return n;
 }
 
 
-template<typename T>
-inline T* LinkedList<T>::find(const T& item)
+template<typename T, typename Alloc>
+inline T* LinkedList<T, Alloc>::find(const T& item)
 {
 	if (isEmpty()) return nullptr;
 	LinkedListItem* iter = first;
@@ -152,8 +358,20 @@ inline T* LinkedList<T>::find(const T& item)
 	return &(iter->data);
 }
 
-template<typename T>
-inline T* LinkedList<T>::getNext(const T& item) {
+template<typename T, typename Alloc>
+inline T* LinkedList<T, Alloc>::find(const T& item, position& pos)
+{
+	for (LinkedListItem** link = &first; *link != nullptr; link = &(*link)->next) {
+		if (!((*link)->data != item)) {
+			pos.link = link;
+			return &(*link)->data;
+		}
+	}
+	return nullptr;
+}
+
+template<typename T, typename Alloc>
+inline T* LinkedList<T, Alloc>::getNext(const T& item) {
 		if (&item == nullptr) return nullptr;
 	if (isEmpty()) return nullptr;
 	LinkedListItem* iter = first;
@@ -166,28 +384,66 @@ inline T* LinkedList<T>::getNext(const T& item) {
 	return &(iter->next->data);
 }
 
-template<typename T>
-inline T* LinkedList<T>::getFirst() 
+template<typename T, typename Alloc>
+inline T* LinkedList<T, Alloc>::getFirst() 
 {
 	if (isEmpty()) return nullptr;
 	return &(first->data);
 }
 
-template<typename T>
-inline bool LinkedList<T>::isEmpty() const
+template<typename T, typename Alloc>
+inline T* LinkedList<T, Alloc>::getFirst(position& pos)
+{
+	pos.link = &first;
+	return getFirst();
+}
+
+template<typename T, typename Alloc>
+inline T* LinkedList<T, Alloc>::getNext(const T* item, position& pos)
+{
+	LinkedListItem** link = linkTo(item, pos);
+	if (link == nullptr) return nullptr;
+	pos.link = &(*link)->next;
+	return *pos.link == nullptr ? nullptr : &(*pos.link)->data;
+}
+
+template<typename T, typename Alloc>
+inline bool LinkedList<T, Alloc>::isEmpty() const
 {
 	return first == nullptr;
 }
 
-template<typename T>
-inline LinkedList<T>::~LinkedList()
+template<typename T, typename Alloc>
+inline size_t LinkedList<T, Alloc>::length() const
+{
+	size_t n = 0;
+	for (LinkedListItem* iter = first; iter != nullptr; iter = iter->next)
+		++n;
+	return n;
+}
+
+template<typename T, typename Alloc>
+inline Alloc LinkedList<T, Alloc>::get_allocator() const
+{
+	return Alloc(alloc);
+}
+
+template<typename T, typename Alloc>
+inline void LinkedList<T, Alloc>::clear()
 {
 	while (!isEmpty()) {
 		LinkedListItem* next = first->next;
-		delete first;
+		traits::destroy(alloc, first);
+		traits::deallocate(alloc, first, 1);
 		first = next;
 	}
 }
 
+template<typename T, typename Alloc>
+inline LinkedList<T, Alloc>::~LinkedList()
+{
+	clear();
+}
+
 
 #endif // !LINKEDLIST_H
\ No newline at end of file
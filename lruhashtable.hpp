@@ -0,0 +1,270 @@
+﻿/*****************************************************************
+ * @file   lruhashtable.hpp
+ * @brief  LruHashTable class: korlátos méretű, LRU alapon ürülő cache HashTable-re építve.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef LRUHASHTABLE_H
+#define LRUHASHTABLE_H
+#include <memory>
+#include <stdexcept>
+#include "hashtable.hpp"
+
+#include "memtrace.h"
+
+/**
+ * Korlátos méretű cache.
+ * Az elemek egy kétirányú láncolt listára vannak felfűzve a használat sorrendjében (elöl a legutóbb használt).
+ * A HashTable csak az elemekre mutató pointereket tárolja, így az újrahashelés nem mozgatja az elemeket,
+ * és a lista pointerei érvényesek maradnak.
+ * Ha a tábla tele van, a put a legrégebben használt elemet dobja ki. Minden művelet várhatóan O(1):
+ * a belső tábla a konstruktorban egyszer maxElements elemre nő, és nem zsugorodik, így később soha nem hashel újra.
+ * @tparam T A tárolt adat típusa
+ * @tparam keyType A kulcs típusa.
+ * @tparam hashFunction Hash függvény, ami a megadott kulcstípusból előállít egy indexet a hashtábla mérettartományán belül.
+ * @tparam defSize A belső tábla tömbmérete.
+ * @tparam Alloc Allokátor, az elemek és a belső tábla is ebből foglalnak. (default: std::allocator<T>)
+ */
+template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash, size_t defSize = 100, typename Alloc = std::allocator<T>>
+class LruHashTable {
+	/**
+	 * A listára fűzött elem.
+	 */
+	struct LruItem {
+		keyType key; //< Az elemhez tartozó kulcs, a kidobáskor kell
+		T value; //< A tárolt elem
+		LruItem* prev; //< Az eggyel később használt elem, vagy nullptr
+		LruItem* next; //< Az eggyel régebben használt elem, vagy nullptr
+		LruItem(const keyType& key, const T& value) :key(key), value(value), prev(nullptr), next(nullptr) {};
+	};
+
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<LruItem> itemAlloc;
+	typedef std::allocator_traits<itemAlloc> traits;
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<LruItem*> tableAlloc;
+
+	itemAlloc alloc; //< Az elemek allokátora
+	typedef HashTable<LruItem*, keyType, hashFunction, defSize, tableAlloc> table_type;
+	table_type table; //< kulcs -> elem
+	LruItem* head; //< A legutóbb használt elem
+	LruItem* tail; //< A legrégebben használt elem
+	size_t maxElements; //< Ennyi elem fér a cache-be
+	size_t nHits; //< Találatok száma
+	size_t nMisses; //< Sikertelen get-ek száma
+	size_t nEvictions; //< Kidobott elemek száma
+
+	/**
+	 * Kifűzi az elemet a listából.
+	 */
+	void unlink(LruItem* item);
+
+	/**
+	 * Befűzi az elemet a lista elejére.
+	 */
+	void pushFront(LruItem* item);
+
+	/**
+	 * Kiveszi a táblából és felszabadítja az elemet.
+	 */
+	void destroy(LruItem* item);
+
+	LruHashTable(const LruHashTable&); //< Másoló konstruktor tiltása
+	LruHashTable& operator=(const LruHashTable&); //< Értékadás tiltása
+public:
+	/**
+	 * Konstruktor.
+	 * @param maxElements a cache-ben tárolható elemek maximális száma, legalább 1
+	 * @param alloc az elemek és a belső tábla allokátora
+	 */
+	explicit LruHashTable(size_t maxElements, const Alloc& alloc = Alloc());
+
+	/**
+	 * Berakja az elemet a cache-be, és legutóbb használtnak jelöli.
+	 * Ha már benne van, felülírja az értékét. Ha a cache tele van, kidobja a legrégebben használt elemet.
+	 * Egyszer hashel és egyszer keres. Ha az elem foglalása kivételt dob, a cache nem változik.
+	 * @param key az elemhez tartozó kulcs
+	 * @param value Tárolandó elem
+	 */
+	void put(keyType key, const T& value);
+
+	/**
+	 * Megkeresi az elemet, és legutóbb használtnak jelöli.
+	 * @param key Az elemhez tartozó kulcs.
+	 * @return Visszaadja a kulcshoz tartozó adatra mutató pointert, ha nem találja nullptr-t.
+	 *         A pointer az elem kidobásáig vagy törléséig érvényes.
+	 */
+	T* get(keyType key);
+
+	/**
+	 * Kitörli a kulcs által jelölt elemet. Ha nincs benne, nem csinál semmit.
+	 * @param key Az elemhez tartozó kulcs.
+	 */
+	void remove(keyType key);
+
+	/**
+	 * @return Visszaadja a jelenlegi elemszámot
+	 */
+	size_t size() const;
+
+	/**
+	 * @return a cache-ben tárolható elemek maximális száma
+	 */
+	size_t maxSize() const;
+
+	/**
+	 * @return a sikeres get-ek száma
+	 */
+	size_t hits() const;
+
+	/**
+	 * @return a sikertelen get-ek száma
+	 */
+	size_t misses() const;
+
+	/**
+	 * @return a helyhiány miatt kidobott elemek száma
+	 */
+	size_t evictions() const;
+
+	/**
+	 * Destruktor
+	 */
+	~LruHashTable();
+};
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline LruHashTable<T, keyType, hashFunction, defSize, Alloc>::LruHashTable(size_t maxElements, const Alloc& alloc)
+	:alloc(alloc), table(tableAlloc(alloc)), head(nullptr), tail(nullptr), maxElements(maxElements), nHits(0), nMisses(0), nEvictions(0)
+{
+	if (maxElements == 0) throw std::invalid_argument("Legalabb 1 elemnek el kell fernie.");
+	table.reserve(maxElements + 1); // Az új elem a kidobás előtt kerül be
+	table.setMinLoadFactor(0); // A kidobás és a törlés ne zsugorítson, a következő put-ok úgyis visszatöltik
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline void LruHashTable<T, keyType, hashFunction, defSize, Alloc>::unlink(LruItem* item)
+{
+	if (item->prev != nullptr) item->prev->next = item->next;
+	else head = item->next;
+	if (item->next != nullptr) item->next->prev = item->prev;
+	else tail = item->prev;
+	item->prev = item->next = nullptr;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline void LruHashTable<T, keyType, hashFunction, defSize, Alloc>::pushFront(LruItem* item)
+{
+	item->prev = nullptr;
+	item->next = head;
+	if (head != nullptr) head->prev = item;
+	head = item;
+	if (tail == nullptr) tail = item;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline void LruHashTable<T, keyType, hashFunction, defSize, Alloc>::destroy(LruItem* item)
+{
+	unlink(item);
+	table.remove(item->key);
+	traits::destroy(alloc, item);
+	traits::deallocate(alloc, item, 1);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline void LruHashTable<T, keyType, hashFunction, defSize, Alloc>::put(keyType key, const T& value)
+{
+	std::pair<typename table_type::iterator, bool> found = table.find_or_insert(key);
+	if (!found.second) {
+		LruItem* item = found.first->value;
+		item->value = value;
+		unlink(item);
+		pushFront(item);
+		return;
+	}
+	LruItem* item = nullptr;
+	try {
+		item = traits::allocate(alloc, 1);
+		traits::construct(alloc, item, key, value);
+	}
+	catch (...) {
+		if (item != nullptr) traits::deallocate(alloc, item, 1);
+		table.erase(found.first); // A kulcs ne maradjon elem nélkül a táblában
+		throw;
+	}
+	found.first->value = item;
+	pushFront(item); // Csak a sikeres berakás után kerül a listába
+	if (table.size() > maxElements) {
+		destroy(tail);
+		++nEvictions;
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline T* LruHashTable<T, keyType, hashFunction, defSize, Alloc>::get(keyType key)
+{
+	LruItem** found = table.get(key);
+	if (found == nullptr) {
+		++nMisses;
+		return nullptr;
+	}
+	++nHits;
+	if (*found != head) {
+		unlink(*found);
+		pushFront(*found);
+	}
+	return &(*found)->value;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline void LruHashTable<T, keyType, hashFunction, defSize, Alloc>::remove(keyType key)
+{
+	LruItem** found = table.get(key);
+	if (found == nullptr) return;
+	destroy(*found);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline size_t LruHashTable<T, keyType, hashFunction, defSize, Alloc>::size() const
+{
+	return table.size();
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline size_t LruHashTable<T, keyType, hashFunction, defSize, Alloc>::maxSize() const
+{
+	return maxElements;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline size_t LruHashTable<T, keyType, hashFunction, defSize, Alloc>::hits() const
+{
+	return nHits;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline size_t LruHashTable<T, keyType, hashFunction, defSize, Alloc>::misses() const
+{
+	return nMisses;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline size_t LruHashTable<T, keyType, hashFunction, defSize, Alloc>::evictions() const
+{
+	return nEvictions;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline LruHashTable<T, keyType, hashFunction, defSize, Alloc>::~LruHashTable()
+{
+	// A táblát a saját destruktora üríti, itt csak az elemeket kell felszabadítani.
+	while (head != nullptr) {
+		LruItem* next = head->next;
+		traits::destroy(alloc, head);
+		traits::deallocate(alloc, head, 1);
+		head = next;
+	}
+}
+
+#endif // !LRUHASHTABLE_H
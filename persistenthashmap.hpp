@@ -0,0 +1,408 @@
+﻿/*****************************************************************
+ * @file   persistenthashmap.hpp
+ * @brief  PersistentHashMap class: tartós (immutable) HAMT, O(1) pillanatképekkel.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef PERSISTENTHASHMAP_H
+#define PERSISTENTHASHMAP_H
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "hashtable.hpp"
+
+#include "memtrace.h"
+
+/**
+ * @return az 1-es bitek száma
+ */
+inline int popCount32(uint32_t x) {
+#if defined(__GNUC__)
+	return __builtin_popcount(x);
+#else
+	x = x - ((x >> 1) & 0x55555555u);
+	x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+	return (int)((((x + (x >> 4)) & 0x0f0f0f0fu) * 0x01010101u) >> 24);
+#endif
+}
+
+/**
+ * Hash array mapped trie (Bagwell): 32 ágú fa, a szinteken a kulcs hash-ének egymás utáni 5 bites darabjai választanak ágat.
+ * A csúcsok tömörítettek: egy 32 bites bitmap jelzi, mely ágak léteznek, és csak azok vannak tárolva,
+ * az ág helye a bitmap alatta lévő bitjeinek száma (popcount).
+ *
+ * A csúcsok létrehozásuk után nem változnak. Egy módosítás csak a gyökértől a kulcsig vezető
+ * O(log32 n) csúcsot másolja le, a többi csúcson az új és a régi változat osztozik (structural sharing).
+ * Így a snapshot() csak a gyökér pointer másolása: O(1), és a pillanatkép később sem változik.
+ * A csúcsokat std::shared_ptr tartja életben, ezért egy pillanatkép (és minden, amire pointert ad)
+ * addig érvényes, amíg a Snapshot objektum él, akkor is, ha a tábla közben tovább változik.
+ *
+ * Szálkezelés: egyszerre egy író lehet (mint a HashTable-nél). A snapshot() bármelyik szálból hívható
+ * az író mellett, a gyökér atomikusan cserélődik. A pillanatképek bármelyik szálból olvashatók.
+ * @tparam T A tárolt adat típusa
+ * @tparam keyType A kulcs típusa.
+ * @tparam hashFunction Hash függvény, H(kulcs) % maxSize alakú: a tábla maxSize = SIZE_MAX-szal hívja,
+ *         és a teljes értéket keveri tovább.
+ */
+template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash>
+class PersistentHashMap {
+	static const int bits = 5; //< Szintenként ennyi hash bit
+	static const uint32_t mask = (1u << bits) - 1;
+
+	/**
+	 * Kulcs-érték pár.
+	 */
+	struct Leaf {
+		uint64_t hash; //< A kulcs teljes hash-e
+		keyType key; //< A kulcs
+		T value; //< Az adat
+		Leaf(uint64_t hash, const keyType& key, const T& value) :hash(hash), key(key), value(value) {};
+	};
+
+	struct Node;
+	typedef std::shared_ptr<const Node> NodePtr;
+	typedef std::shared_ptr<const Leaf> LeafPtr;
+
+	/**
+	 * Egy ág: vagy gyerek csúcs, vagy levél.
+	 */
+	struct Entry {
+		NodePtr child; //< A gyerek csúcs, vagy nullptr, ha levél
+		LeafPtr leaf; //< A levél, ha nincs gyerek
+	};
+
+	/**
+	 * Tömörített csúcs. A hash bitek elfogyása után (shift >= 64) ütközési csúcs:
+	 * a bitmap 0, az entries csupa azonos hash-ű levél.
+	 */
+	struct Node {
+		uint32_t bitmap; //< A létező ágak
+		size_t size; //< A részfa leveleinek száma
+		std::vector<Entry> entries; //< A létező ágak, az ágindex szerint rendezve
+		Node() :bitmap(0), size(0) {};
+	};
+
+	NodePtr root; //< A jelenlegi változat gyökere, nullptr ha üres
+
+	/**
+	 * A hash függvény teljes értéke, összekeverve, hogy minden bitje egyenletes legyen.
+	 */
+	static uint64_t fullHash(const keyType& key) {
+		uint64_t h = (uint64_t)hashFunction(key, SIZE_MAX);
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	/**
+	 * @return az ág helye a csúcs entries tömbjében
+	 */
+	static size_t position(uint32_t bitmap, uint32_t bit) {
+		return (size_t)popCount32(bitmap & (bit - 1));
+	}
+
+	static const T* find(const Node* n, uint64_t h, const keyType& key);
+
+	/**
+	 * Két különböző kulcsú levélből épít részfát a shift-edik bittől.
+	 */
+	static NodePtr merge(const LeafPtr& a, const LeafPtr& b, int shift);
+
+	/**
+	 * @return az új részfa, vagy n maga, ha nem változott
+	 */
+	static NodePtr insert(const NodePtr& n, int shift, const LeafPtr& leaf, bool overwrite, bool& added);
+
+	/**
+	 * @return az új részfa (nullptr, ha kiürült), vagy n maga, ha nem változott
+	 */
+	static NodePtr erase(const NodePtr& n, int shift, uint64_t h, const keyType& key);
+
+	template<typename F>
+	static void forEachIn(const Node* n, F& f);
+
+	/**
+	 * Atomikusan lecseréli a gyökeret, hogy a snapshot() más szálból is biztonságosan olvashassa.
+	 */
+	void publish(const NodePtr& n) {
+		std::atomic_store(&root, n);
+	}
+public:
+	/**
+	 * Egy változat, ami később sem változik. Másolása O(1).
+	 */
+	class Snapshot {
+		NodePtr root; //< A változat gyökere
+	public:
+		explicit Snapshot(const NodePtr& root = NodePtr()) :root(root) {};
+
+		/**
+		 * @return a kulcshoz tartozó adatra mutató pointer, vagy nullptr. Amíg a Snapshot él, érvényes.
+		 */
+		const T* get(const keyType& key) const {
+			return root ? find(root.get(), fullHash(key), key) : nullptr;
+		}
+
+		/**
+		 * @return benne van-e a kulcs
+		 */
+		bool contains(const keyType& key) const {
+			return get(key) != nullptr;
+		}
+
+		/**
+		 * @return az elemek száma
+		 */
+		size_t size() const {
+			return root ? root->size : 0;
+		}
+
+		/**
+		 * Minden elemre meghívja az f(key, value) függvényt, a hash szerinti sorrendben.
+		 */
+		template<typename F>
+		void forEach(F f) const {
+			if (root) forEachIn(root.get(), f);
+		}
+	};
+
+	PersistentHashMap() {};
+
+	/**
+	 * Berakja az elemet, ha a kulcs még nincs benne.
+	 * @return true, ha új elem került be
+	 */
+	bool put(const keyType& key, const T& value) {
+		bool added = false;
+		NodePtr n = insert(root, 0, std::make_shared<const Leaf>(fullHash(key), key, value), false, added);
+		if (n != root) publish(n);
+		return added;
+	}
+
+	/**
+	 * Berakja az elemet, a meglévő értéket felülírja.
+	 */
+	void assign(const keyType& key, const T& value) {
+		bool added = false;
+		publish(insert(root, 0, std::make_shared<const Leaf>(fullHash(key), key, value), true, added));
+	}
+
+	/**
+	 * Kitörli a kulcsot, ha benne van.
+	 * @return true, ha törölt
+	 */
+	bool remove(const keyType& key) {
+		if (!root) return false;
+		NodePtr n = erase(root, 0, fullHash(key), key);
+		if (n == root) return false;
+		publish(n);
+		return true;
+	}
+
+	/**
+	 * @return a kulcshoz tartozó adatra mutató pointer, vagy nullptr. A következő módosításig érvényes.
+	 */
+	const T* get(const keyType& key) const {
+		return root ? find(root.get(), fullHash(key), key) : nullptr;
+	}
+
+	/**
+	 * @return benne van-e a kulcs
+	 */
+	bool contains(const keyType& key) const {
+		return get(key) != nullptr;
+	}
+
+	/**
+	 * @return az elemek száma
+	 */
+	size_t size() const {
+		return root ? root->size : 0;
+	}
+
+	/**
+	 * Kiüríti a táblát. A korábbi pillanatképek megmaradnak.
+	 */
+	void clear() {
+		publish(NodePtr());
+	}
+
+	/**
+	 * O(1) pillanatkép a jelenlegi állapotról. Az író mellett más szálból is hívható.
+	 */
+	Snapshot snapshot() const {
+		return Snapshot(std::atomic_load(&root));
+	}
+};
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline const T* PersistentHashMap<T, keyType, hashFunction>::find(const Node* n, uint64_t h, const keyType& key)
+{
+	for (int shift = 0; ; shift += bits) {
+		if (shift >= 64) {
+			for (const Entry& e : n->entries)
+				if (e.leaf->key == key) return &e.leaf->value;
+			return nullptr;
+		}
+		uint32_t bit = 1u << ((h >> shift) & mask);
+		if ((n->bitmap & bit) == 0) return nullptr;
+		const Entry& e = n->entries[position(n->bitmap, bit)];
+		if (!e.child) return e.leaf->hash == h && e.leaf->key == key ? &e.leaf->value : nullptr;
+		n = e.child.get();
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline typename PersistentHashMap<T, keyType, hashFunction>::NodePtr PersistentHashMap<T, keyType, hashFunction>::merge(const LeafPtr& a, const LeafPtr& b, int shift)
+{
+	std::shared_ptr<Node> n = std::make_shared<Node>();
+	n->size = 2;
+	Entry ea, eb;
+	ea.leaf = a;
+	eb.leaf = b;
+	if (shift >= 64) {
+		n->entries.push_back(ea);
+		n->entries.push_back(eb);
+		return n;
+	}
+	uint32_t ia = (uint32_t)(a->hash >> shift) & mask;
+	uint32_t ib = (uint32_t)(b->hash >> shift) & mask;
+	if (ia == ib) {
+		Entry e;
+		e.child = merge(a, b, shift + bits);
+		n->bitmap = 1u << ia;
+		n->entries.push_back(e);
+	}
+	else {
+		n->bitmap = (1u << ia) | (1u << ib);
+		n->entries.push_back(ia < ib ? ea : eb);
+		n->entries.push_back(ia < ib ? eb : ea);
+	}
+	return n;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline typename PersistentHashMap<T, keyType, hashFunction>::NodePtr PersistentHashMap<T, keyType, hashFunction>::insert(const NodePtr& n, int shift, const LeafPtr& leaf, bool overwrite, bool& added)
+{
+	Entry le;
+	le.leaf = leaf;
+	if (!n) {
+		std::shared_ptr<Node> fresh = std::make_shared<Node>();
+		fresh->bitmap = 1u << ((leaf->hash >> shift) & mask);
+		fresh->size = 1;
+		fresh->entries.push_back(le);
+		added = true;
+		return fresh;
+	}
+	if (shift >= 64) {
+		for (size_t i = 0; i < n->entries.size(); ++i) {
+			if (n->entries[i].leaf->key == leaf->key) {
+				if (!overwrite) return n;
+				std::shared_ptr<Node> copy = std::make_shared<Node>(*n);
+				copy->entries[i] = le;
+				return copy;
+			}
+		}
+		std::shared_ptr<Node> copy = std::make_shared<Node>(*n);
+		copy->entries.push_back(le);
+		++copy->size;
+		added = true;
+		return copy;
+	}
+
+	uint32_t bit = 1u << ((leaf->hash >> shift) & mask);
+	size_t pos = position(n->bitmap, bit);
+	if ((n->bitmap & bit) == 0) {
+		std::shared_ptr<Node> copy = std::make_shared<Node>(*n);
+		copy->bitmap |= bit;
+		copy->entries.insert(copy->entries.begin() + pos, le);
+		++copy->size;
+		added = true;
+		return copy;
+	}
+	const Entry& e = n->entries[pos];
+	Entry replacement;
+	if (e.child) {
+		replacement.child = insert(e.child, shift + bits, leaf, overwrite, added);
+		if (replacement.child == e.child) return n;
+	}
+	else if (e.leaf->hash == leaf->hash && e.leaf->key == leaf->key) {
+		if (!overwrite) return n;
+		replacement = le;
+	}
+	else {
+		replacement.child = merge(e.leaf, leaf, shift + bits);
+		added = true;
+	}
+	std::shared_ptr<Node> copy = std::make_shared<Node>(*n);
+	copy->entries[pos] = replacement;
+	if (added) ++copy->size;
+	return copy;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline typename PersistentHashMap<T, keyType, hashFunction>::NodePtr PersistentHashMap<T, keyType, hashFunction>::erase(const NodePtr& n, int shift, uint64_t h, const keyType& key)
+{
+	if (shift >= 64) {
+		for (size_t i = 0; i < n->entries.size(); ++i) {
+			if (n->entries[i].leaf->key == key) {
+				if (n->entries.size() == 1) return NodePtr();
+				std::shared_ptr<Node> copy = std::make_shared<Node>(*n);
+				copy->entries.erase(copy->entries.begin() + i);
+				--copy->size;
+				return copy;
+			}
+		}
+		return n;
+	}
+
+	uint32_t bit = 1u << ((h >> shift) & mask);
+	if ((n->bitmap & bit) == 0) return n;
+	size_t pos = position(n->bitmap, bit);
+	const Entry& e = n->entries[pos];
+	Entry replacement;
+	if (e.child) {
+		replacement.child = erase(e.child, shift + bits, h, key);
+		if (replacement.child == e.child) return n;
+		// Az egyetlen levelet tartalmazó gyereket a levéllel helyettesíti, hogy a fa ne maradjon feleslegesen mély
+		if (replacement.child && replacement.child->size == 1 && !replacement.child->entries[0].child) {
+			replacement.leaf = replacement.child->entries[0].leaf;
+			replacement.child.reset();
+		}
+	}
+	else if (e.leaf->hash != h || e.leaf->key != key) {
+		return n;
+	}
+
+	if (!replacement.child && !replacement.leaf) {
+		if (n->entries.size() == 1) return NodePtr();
+		std::shared_ptr<Node> copy = std::make_shared<Node>(*n);
+		copy->bitmap &= ~bit;
+		copy->entries.erase(copy->entries.begin() + pos);
+		--copy->size;
+		return copy;
+	}
+	std::shared_ptr<Node> copy = std::make_shared<Node>(*n);
+	copy->entries[pos] = replacement;
+	--copy->size;
+	return copy;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+template<typename F>
+inline void PersistentHashMap<T, keyType, hashFunction>::forEachIn(const Node* n, F& f)
+{
+	for (const Entry& e : n->entries) {
+		if (e.child) forEachIn(e.child.get(), f);
+		else f(e.leaf->key, e.leaf->value);
+	}
+}
+
+#endif // !PERSISTENTHASHMAP_H
@@ -32,8 +32,7 @@ void programnyelvek_teszt() {
 	while (is) {
 		std::getline(is, name, ',');
 		std::getline(is, url);
-		if (nyelvek.get(name) == nullptr) { // Erre a feltetelre szukseg van, hogy helyesen tudjuk szamolni a betett nyelveket. A fileban lehetnek duplikaciok
-			nyelvek.put(name, url);
+		if (nyelvek.insert(name, url).second) { // Csak az uj nyelveket szamoljuk. A fileban lehetnek duplikaciok
 			++n;
 		}
 		
@@ -0,0 +1,710 @@
+﻿/*****************************************************************
+ * @file   radixtree.hpp
+ * @brief  RadixTree class: adaptív radix fa (ART) string kulcsokhoz, rendezett, prefix és tartomány lekérdezésekkel.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef RADIXTREE_H
+#define RADIXTREE_H
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "memtrace.h"
+
+/**
+ * Adaptív radix fa (Leis et al., ART). A kulcs byte-jai szintenként választanak ágat, a belső csúcsok
+ * mérete a gyerekek számához igazodik: Node4, Node16 (SSE2 összehasonlítással keres), Node48 (256 byte-os
+ * index), Node256 (közvetlen tömb). Az egy gyerekű láncok a csúcs prefixébe tömörülnek, és egy levél
+ * addig nem kerül mélyebbre, amíg egy másik kulcs el nem válik tőle, így egy keresés legfeljebb
+ * a kulcs hosszának megfelelő szintet jár be.
+ *
+ * A kulcsok byte-onként (unsigned char) rendezettek, mint a std::string operator<-je, így a bejárás
+ * rendezett, és a prefix és tartomány lekérdezések csak az érintett részfákat járják be.
+ * Ha egy kulcs egy másik kulcs prefixe (pl. "Java" és "JavaScript"), a rövidebb a belső csúcs levele.
+ * A kulcsokban lehet '\0' is.
+ * @tparam T A tárolt adat típusa
+ */
+template<typename T>
+class RadixTree {
+	/**
+	 * Kulcs-érték pár. A levelek egyenként foglalódnak, így a rájuk mutató pointerek a törlésükig érvényesek.
+	 */
+	struct Leaf {
+		std::string key; //< A teljes kulcs
+		T value; //< Az adat
+		Leaf(const std::string& key, const T& value) :key(key), value(value) {};
+	};
+
+	enum NodeType : uint8_t { N4, N16, N48, N256 };
+
+	/**
+	 * Gyerekre mutató pointer: a legalsó bit 1, ha levél, 0, ha belső csúcs.
+	 */
+	typedef uintptr_t Ref;
+
+	/**
+	 * A belső csúcsok közös része.
+	 */
+	struct Node {
+		NodeType type; //< A csúcs fajtája
+		uint16_t count; //< A gyerekek száma
+		std::string prefix; //< A tömörített egy gyerekű lánc byte-jai
+		Leaf* leaf; //< Az itt végződő kulcs, vagy nullptr
+		Node(NodeType type) :type(type), count(0), leaf(nullptr) {};
+	};
+	struct Node4 : Node {
+		uint8_t keys[4]; //< Rendezett byte-ok
+		Ref children[4];
+		Node4() :Node(N4) {};
+	};
+	struct Node16 : Node {
+		uint8_t keys[16]; //< Rendezett byte-ok
+		Ref children[16];
+		Node16() :Node(N16) {};
+	};
+	struct Node48 : Node {
+		uint8_t index[256]; //< A byte gyerekének helye + 1, 0: nincs
+		Ref children[48]; //< 0: szabad hely
+		Node48() :Node(N48) {
+			std::memset(index, 0, sizeof(index));
+			std::memset(children, 0, sizeof(children));
+		};
+	};
+	struct Node256 : Node {
+		Ref children[256]; //< 0: nincs
+		Node256() :Node(N256) {
+			std::memset(children, 0, sizeof(children));
+		};
+	};
+
+	Ref root; //< A gyökér, 0 ha üres
+	size_t count; //< Az elemek száma
+
+	static bool isLeaf(Ref r) { return (r & 1) != 0; }
+	static Leaf* asLeaf(Ref r) { return reinterpret_cast<Leaf*>(r & ~(uintptr_t)1); }
+	static Node* asNode(Ref r) { return reinterpret_cast<Node*>(r); }
+	static Ref refOf(Leaf* l) { return reinterpret_cast<uintptr_t>(l) | 1; }
+	static Ref refOf(Node* n) { return reinterpret_cast<uintptr_t>(n); }
+
+	/**
+	 * @return a byte-hoz tartozó gyerek helye, vagy nullptr
+	 */
+	static Ref* findChild(Node* n, uint8_t b);
+
+	/**
+	 * Hozzáad egy gyereket. Ha a csúcs tele van, nagyobbra cseréli, és a ref-et átírja.
+	 */
+	static void addChild(Ref& ref, uint8_t b, Ref child);
+
+	/**
+	 * Kiveszi a byte gyerekét. Ha a csúcs elég kicsi lett, kisebbre cseréli.
+	 */
+	static void removeChild(Ref& ref, uint8_t b);
+
+	/**
+	 * Megszünteti a felesleges csúcsot: az üreset, a csak levelet tartalmazót, és az egy gyerekűt (a gyerek prefixébe olvasztja).
+	 */
+	static void compact(Ref& ref);
+
+	/**
+	 * Felszabadítja a csúcsot a gyerekei és a levele nélkül.
+	 */
+	static void freeNode(Node* n);
+
+	/**
+	 * Minden gyereket byte sorrendben meghív.
+	 * @return false, ha az f leállította a bejárást
+	 */
+	template<typename F>
+	static bool forEachChild(Node* n, F f);
+
+	static bool insert(Ref& ref, const std::string& key, size_t depth, Leaf* leaf);
+	static Leaf* erase(Ref& ref, const std::string& key, size_t depth);
+	static void destroy(Ref r);
+
+	/**
+	 * Rendezett bejárás a [lo, hi) tartományban (nullptr: nincs korlát).
+	 * A path a csúcs prefixe előtti byte-ok, a teljesen a tartományon kívüli részfákat kihagyja.
+	 * @return false, ha a bejárás véget ért (elérte a hi-t, vagy az f false-t adott)
+	 */
+	template<typename F>
+	static bool walk(Ref r, std::string& path, const std::string* lo, const std::string* hi, F& f);
+
+	/**
+	 * @return negatív, nulla vagy pozitív, ahogy a path aránylik a bound első path.size() byte-jához
+	 */
+	static int comparePrefix(const std::string& path, const std::string& bound) {
+		return path.compare(0, path.size(), bound, 0, path.size() < bound.size() ? path.size() : bound.size());
+	}
+
+	/**
+	 * @return a kulcs levele, vagy nullptr
+	 */
+	Leaf* lookup(const std::string& key) const;
+
+	RadixTree(const RadixTree&); //< Másoló konstruktor tiltása
+	RadixTree& operator=(const RadixTree&); //< Értékadás tiltása
+public:
+	RadixTree() :root(0), count(0) {};
+
+	~RadixTree() {
+		destroy(root);
+	}
+
+	/**
+	 * Berakja az elemet, ha a kulcs még nincs benne.
+	 * @return true, ha új elem került be
+	 */
+	bool put(const std::string& key, const T& value);
+
+	/**
+	 * @return a kulcshoz tartozó adatra mutató pointer, vagy nullptr. A kulcs törléséig érvényes.
+	 */
+	T* get(const std::string& key) {
+		Leaf* l = lookup(key);
+		return l == nullptr ? nullptr : &l->value;
+	}
+
+	/**
+	 * @return benne van-e a kulcs
+	 */
+	bool contains(const std::string& key) const {
+		return lookup(key) != nullptr;
+	}
+
+	/**
+	 * Kitörli a kulcsot, ha benne van.
+	 * @return true, ha törölt
+	 */
+	bool remove(const std::string& key);
+
+	/**
+	 * @return az elemek száma
+	 */
+	size_t size() const {
+		return count;
+	}
+
+	/**
+	 * Kulcs szerint növekvő sorrendben meghívja az f(key, value) függvényt minden elemre.
+	 * @param f f(const std::string&, T&), ha bool-t ad vissza, false-ra leáll
+	 */
+	template<typename F>
+	void forEach(F f) {
+		std::string path;
+		walk(root, path, nullptr, nullptr, f);
+	}
+
+	/**
+	 * A prefixszel kezdődő kulcsokat járja be, rendezetten. Csak a prefix részfáját érinti:
+	 * a költség a prefix hossza plusz a találatok száma.
+	 * @param f f(const std::string&, T&), ha bool-t ad vissza, false-ra leáll
+	 */
+	template<typename F>
+	void prefix(const std::string& p, F f);
+
+	/**
+	 * A [lo, hi) tartományba eső kulcsokat járja be, rendezetten.
+	 * @param f f(const std::string&, T&), ha bool-t ad vissza, false-ra leáll
+	 */
+	template<typename F>
+	void range(const std::string& lo, const std::string& hi, F f) {
+		std::string path;
+		walk(root, path, &lo, &hi, f);
+	}
+};
+
+/**
+ * Meghívja az f-et, és ha bool-t ad vissza, azt adja tovább, különben true-t.
+ */
+template<typename F, typename K, typename V>
+inline bool radixVisit(F& f, const K& key, V& value) {
+	if constexpr (std::is_same<decltype(f(key, value)), bool>::value)
+		return f(key, value);
+	else {
+		f(key, value);
+		return true;
+	}
+}
+
+template<typename T>
+inline typename RadixTree<T>::Ref* RadixTree<T>::findChild(Node* n, uint8_t b)
+{
+	switch (n->type) {
+	case N4: {
+		Node4* n4 = static_cast<Node4*>(n);
+		for (int i = 0; i < n4->count; ++i)
+			if (n4->keys[i] == b) return &n4->children[i];
+		return nullptr;
+	}
+	case N16: {
+		Node16* n16 = static_cast<Node16*>(n);
+#if defined(__SSE2__)
+		// A 16 byte egyetlen összehasonlítással
+		__m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)b), _mm_loadu_si128(reinterpret_cast<const __m128i*>(n16->keys)));
+		unsigned mask = (unsigned)_mm_movemask_epi8(cmp) & ((1u << n16->count) - 1);
+		return mask == 0 ? nullptr : &n16->children[__builtin_ctz(mask)];
+#else
+		for (int i = 0; i < n16->count; ++i)
+			if (n16->keys[i] == b) return &n16->children[i];
+		return nullptr;
+#endif
+	}
+	case N48: {
+		Node48* n48 = static_cast<Node48*>(n);
+		return n48->index[b] == 0 ? nullptr : &n48->children[n48->index[b] - 1];
+	}
+	default: {
+		Node256* n256 = static_cast<Node256*>(n);
+		return n256->children[b] == 0 ? nullptr : &n256->children[b];
+	}
+	}
+}
+
+template<typename T>
+inline void RadixTree<T>::freeNode(Node* n)
+{
+	switch (n->type) {
+	case N4: delete static_cast<Node4*>(n); break;
+	case N16: delete static_cast<Node16*>(n); break;
+	case N48: delete static_cast<Node48*>(n); break;
+	default: delete static_cast<Node256*>(n); break;
+	}
+}
+
+template<typename T>
+inline void RadixTree<T>::addChild(Ref& ref, uint8_t b, Ref child)
+{
+	Node* n = asNode(ref);
+	switch (n->type) {
+	case N4: {
+		Node4* n4 = static_cast<Node4*>(n);
+		if (n4->count == 4) {
+			Node16* n16 = new Node16();
+			std::memcpy(n16->keys, n4->keys, 4);
+			std::memcpy(n16->children, n4->children, 4 * sizeof(Ref));
+			n16->count = 4;
+			n16->prefix.swap(n4->prefix);
+			n16->leaf = n4->leaf;
+			delete n4;
+			ref = refOf(n16);
+			addChild(ref, b, child);
+			return;
+		}
+		int i = 0;
+		while (i < n4->count && n4->keys[i] < b) ++i;
+		std::memmove(n4->keys + i + 1, n4->keys + i, n4->count - i);
+		std::memmove(n4->children + i + 1, n4->children + i, (n4->count - i) * sizeof(Ref));
+		n4->keys[i] = b;
+		n4->children[i] = child;
+		++n4->count;
+		return;
+	}
+	case N16: {
+		Node16* n16 = static_cast<Node16*>(n);
+		if (n16->count == 16) {
+			Node48* n48 = new Node48();
+			for (int i = 0; i < 16; ++i) {
+				n48->children[i] = n16->children[i];
+				n48->index[n16->keys[i]] = (uint8_t)(i + 1);
+			}
+			n48->count = 16;
+			n48->prefix.swap(n16->prefix);
+			n48->leaf = n16->leaf;
+			delete n16;
+			ref = refOf(n48);
+			addChild(ref, b, child);
+			return;
+		}
+		int i = 0;
+		while (i < n16->count && n16->keys[i] < b) ++i;
+		std::memmove(n16->keys + i + 1, n16->keys + i, n16->count - i);
+		std::memmove(n16->children + i + 1, n16->children + i, (n16->count - i) * sizeof(Ref));
+		n16->keys[i] = b;
+		n16->children[i] = child;
+		++n16->count;
+		return;
+	}
+	case N48: {
+		Node48* n48 = static_cast<Node48*>(n);
+		if (n48->count == 48) {
+			Node256* n256 = new Node256();
+			for (int c = 0; c < 256; ++c)
+				if (n48->index[c] != 0) n256->children[c] = n48->children[n48->index[c] - 1];
+			n256->count = 48;
+			n256->prefix.swap(n48->prefix);
+			n256->leaf = n48->leaf;
+			delete n48;
+			ref = refOf(n256);
+			addChild(ref, b, child);
+			return;
+		}
+		// A törlések után a helyek nem feltétlenül egybefüggőek: az első szabadot keresi
+		int slot = 0;
+		while (n48->children[slot] != 0) ++slot;
+		n48->children[slot] = child;
+		n48->index[b] = (uint8_t)(slot + 1);
+		++n48->count;
+		return;
+	}
+	default: {
+		Node256* n256 = static_cast<Node256*>(n);
+		n256->children[b] = child;
+		++n256->count;
+		return;
+	}
+	}
+}
+
+template<typename T>
+inline void RadixTree<T>::removeChild(Ref& ref, uint8_t b)
+{
+	Node* n = asNode(ref);
+	switch (n->type) {
+	case N4:
+	case N16: {
+		uint8_t* keys = n->type == N4 ? static_cast<Node4*>(n)->keys : static_cast<Node16*>(n)->keys;
+		Ref* children = n->type == N4 ? static_cast<Node4*>(n)->children : static_cast<Node16*>(n)->children;
+		int i = 0;
+		while (keys[i] != b) ++i;
+		std::memmove(keys + i, keys + i + 1, n->count - i - 1);
+		std::memmove(children + i, children + i + 1, (n->count - i - 1) * sizeof(Ref));
+		--n->count;
+		if (n->type == N16 && n->count <= 3) {
+			Node16* n16 = static_cast<Node16*>(n);
+			Node4* n4 = new Node4();
+			std::memcpy(n4->keys, n16->keys, n16->count);
+			std::memcpy(n4->children, n16->children, n16->count * sizeof(Ref));
+			n4->count = n16->count;
+			n4->prefix.swap(n16->prefix);
+			n4->leaf = n16->leaf;
+			delete n16;
+			ref = refOf(n4);
+		}
+		return;
+	}
+	case N48: {
+		Node48* n48 = static_cast<Node48*>(n);
+		n48->children[n48->index[b] - 1] = 0;
+		n48->index[b] = 0;
+		--n48->count;
+		if (n48->count <= 12) {
+			Node16* n16 = new Node16();
+			for (int c = 0; c < 256; ++c) {
+				if (n48->index[c] != 0) {
+					n16->keys[n16->count] = (uint8_t)c;
+					n16->children[n16->count++] = n48->children[n48->index[c] - 1];
+				}
+			}
+			n16->prefix.swap(n48->prefix);
+			n16->leaf = n48->leaf;
+			delete n48;
+			ref = refOf(n16);
+		}
+		return;
+	}
+	default: {
+		Node256* n256 = static_cast<Node256*>(n);
+		n256->children[b] = 0;
+		--n256->count;
+		if (n256->count <= 37) {
+			Node48* n48 = new Node48();
+			for (int c = 0; c < 256; ++c) {
+				if (n256->children[c] != 0) {
+					n48->children[n48->count] = n256->children[c];
+					n48->index[c] = (uint8_t)(++n48->count);
+				}
+			}
+			n48->prefix.swap(n256->prefix);
+			n48->leaf = n256->leaf;
+			delete n256;
+			ref = refOf(n48);
+		}
+		return;
+	}
+	}
+}
+
+template<typename T>
+template<typename F>
+inline bool RadixTree<T>::forEachChild(Node* n, F f)
+{
+	switch (n->type) {
+	case N4: {
+		Node4* n4 = static_cast<Node4*>(n);
+		for (int i = 0; i < n4->count; ++i)
+			if (!f(n4->keys[i], n4->children[i])) return false;
+		return true;
+	}
+	case N16: {
+		Node16* n16 = static_cast<Node16*>(n);
+		for (int i = 0; i < n16->count; ++i)
+			if (!f(n16->keys[i], n16->children[i])) return false;
+		return true;
+	}
+	case N48: {
+		Node48* n48 = static_cast<Node48*>(n);
+		for (int c = 0; c < 256; ++c)
+			if (n48->index[c] != 0 && !f((uint8_t)c, n48->children[n48->index[c] - 1])) return false;
+		return true;
+	}
+	default: {
+		Node256* n256 = static_cast<Node256*>(n);
+		for (int c = 0; c < 256; ++c)
+			if (n256->children[c] != 0 && !f((uint8_t)c, n256->children[c])) return false;
+		return true;
+	}
+	}
+}
+
+template<typename T>
+inline void RadixTree<T>::compact(Ref& ref)
+{
+	Node* n = asNode(ref);
+	if (n->count == 0) {
+		ref = n->leaf == nullptr ? 0 : refOf(n->leaf);
+		freeNode(n);
+		return;
+	}
+	if (n->count == 1 && n->leaf == nullptr) {
+		// Az egyetlen gyerek a helyére lép, a prefix + ág byte a gyerek prefixe elé kerül
+		uint8_t b = 0;
+		Ref child = 0;
+		forEachChild(n, [&](uint8_t c, Ref r) { b = c; child = r; return false; });
+		if (!isLeaf(child)) {
+			Node* cn = asNode(child);
+			cn->prefix = n->prefix + (char)b + cn->prefix;
+		}
+		freeNode(n);
+		ref = child;
+	}
+}
+
+template<typename T>
+inline void RadixTree<T>::destroy(Ref r)
+{
+	if (r == 0) return;
+	if (isLeaf(r)) {
+		delete asLeaf(r);
+		return;
+	}
+	Node* n = asNode(r);
+	forEachChild(n, [](uint8_t, Ref c) { destroy(c); return true; });
+	delete n->leaf;
+	freeNode(n);
+}
+
+template<typename T>
+inline typename RadixTree<T>::Leaf* RadixTree<T>::lookup(const std::string& key) const
+{
+	Ref r = root;
+	size_t depth = 0;
+	while (r != 0) {
+		if (isLeaf(r)) {
+			Leaf* l = asLeaf(r);
+			return l->key == key ? l : nullptr;
+		}
+		Node* n = asNode(r);
+		size_t p = n->prefix.size();
+		if (key.size() - depth < p || std::memcmp(key.data() + depth, n->prefix.data(), p) != 0) return nullptr;
+		depth += p;
+		if (depth == key.size()) return n->leaf;
+		Ref* c = findChild(n, (uint8_t)key[depth]);
+		if (c == nullptr) return nullptr;
+		r = *c;
+		++depth;
+	}
+	return nullptr;
+}
+
+template<typename T>
+inline bool RadixTree<T>::insert(Ref& ref, const std::string& key, size_t depth, Leaf* leaf)
+{
+	if (ref == 0) {
+		ref = refOf(leaf);
+		return true;
+	}
+	if (isLeaf(ref)) {
+		Leaf* old = asLeaf(ref);
+		if (old->key == key) return false;
+		// Új csúcs a két kulcs közös részével, alatta a két levél
+		size_t common = 0;
+		while (depth + common < key.size() && depth + common < old->key.size() && key[depth + common] == old->key[depth + common])
+			++common;
+		Node4* n = new Node4();
+		n->prefix.assign(key, depth, common);
+		Ref nref = refOf(n);
+		size_t d = depth + common;
+		for (Leaf* l : { old, leaf }) {
+			if (d == l->key.size()) n->leaf = l;
+			else addChild(nref, (uint8_t)l->key[d], refOf(l));
+		}
+		ref = nref;
+		return true;
+	}
+	Node* n = asNode(ref);
+	size_t p = 0;
+	while (p < n->prefix.size() && depth + p < key.size() && n->prefix[p] == key[depth + p])
+		++p;
+	if (p < n->prefix.size()) {
+		// A prefix közepén válik el: új szülő a közös résszel
+		Node4* parent = new Node4();
+		parent->prefix.assign(n->prefix, 0, p);
+		Ref pref = refOf(parent);
+		uint8_t b = (uint8_t)n->prefix[p];
+		n->prefix.erase(0, p + 1);
+		addChild(pref, b, ref);
+		if (depth + p == key.size()) parent->leaf = leaf;
+		else addChild(pref, (uint8_t)key[depth + p], refOf(leaf));
+		ref = pref;
+		return true;
+	}
+	depth += p;
+	if (depth == key.size()) {
+		if (n->leaf != nullptr) return false;
+		n->leaf = leaf;
+		return true;
+	}
+	Ref* c = findChild(n, (uint8_t)key[depth]);
+	if (c != nullptr) return insert(*c, key, depth + 1, leaf);
+	addChild(ref, (uint8_t)key[depth], refOf(leaf));
+	return true;
+}
+
+template<typename T>
+inline bool RadixTree<T>::put(const std::string& key, const T& value)
+{
+	Leaf* l = new Leaf(key, value);
+	if (!insert(root, key, 0, l)) {
+		delete l;
+		return false;
+	}
+	++count;
+	return true;
+}
+
+template<typename T>
+inline typename RadixTree<T>::Leaf* RadixTree<T>::erase(Ref& ref, const std::string& key, size_t depth)
+{
+	if (ref == 0) return nullptr;
+	if (isLeaf(ref)) {
+		Leaf* l = asLeaf(ref);
+		if (l->key != key) return nullptr;
+		ref = 0;
+		return l;
+	}
+	Node* n = asNode(ref);
+	size_t p = n->prefix.size();
+	if (key.size() - depth < p || std::memcmp(key.data() + depth, n->prefix.data(), p) != 0) return nullptr;
+	depth += p;
+	Leaf* l;
+	if (depth == key.size()) {
+		l = n->leaf;
+		if (l == nullptr) return nullptr;
+		n->leaf = nullptr;
+	}
+	else {
+		uint8_t b = (uint8_t)key[depth];
+		Ref* c = findChild(n, b);
+		if (c == nullptr) return nullptr;
+		l = erase(*c, key, depth + 1);
+		if (l == nullptr) return nullptr;
+		if (*c == 0) removeChild(ref, b);
+	}
+	compact(ref);
+	return l;
+}
+
+template<typename T>
+inline bool RadixTree<T>::remove(const std::string& key)
+{
+	Leaf* l = erase(root, key, 0);
+	if (l == nullptr) return false;
+	delete l;
+	--count;
+	return true;
+}
+
+template<typename T>
+template<typename F>
+inline bool RadixTree<T>::walk(Ref r, std::string& path, const std::string* lo, const std::string* hi, F& f)
+{
+	if (r == 0) return true;
+	if (isLeaf(r)) {
+		Leaf* l = asLeaf(r);
+		if (lo != nullptr && l->key < *lo) return true;
+		if (hi != nullptr && !(l->key < *hi)) return false;
+		return radixVisit(f, (const std::string&)l->key, l->value);
+	}
+	Node* n = asNode(r);
+	size_t old = path.size();
+	path += n->prefix;
+	if (lo != nullptr) {
+		int c = comparePrefix(path, *lo);
+		if (c < 0) { // Az egész részfa a lo előtt van
+			path.resize(old);
+			return true;
+		}
+		if (c > 0) lo = nullptr; // Az egész részfa a lo után van
+	}
+	if (hi != nullptr && comparePrefix(path, *hi) > 0) { // Az egész részfa a hi után van
+		path.resize(old);
+		return false;
+	}
+	bool go = true;
+	if (n->leaf != nullptr) {
+		Leaf* l = n->leaf;
+		if (hi != nullptr && !(l->key < *hi)) go = false;
+		else if (lo == nullptr || !(l->key < *lo)) go = radixVisit(f, (const std::string&)l->key, l->value);
+	}
+	if (go) {
+		go = forEachChild(n, [&](uint8_t b, Ref c) {
+			path.push_back((char)b);
+			bool res = walk(c, path, lo, hi, f);
+			path.pop_back();
+			return res;
+		});
+	}
+	path.resize(old);
+	return go;
+}
+
+template<typename T>
+template<typename F>
+inline void RadixTree<T>::prefix(const std::string& p, F f)
+{
+	// Leereszkedik a prefix részfájáig, onnan korlát nélkül jár be
+	Ref r = root;
+	size_t depth = 0;
+	while (r != 0) {
+		if (isLeaf(r)) {
+			Leaf* l = asLeaf(r);
+			if (l->key.compare(0, p.size(), p) == 0) radixVisit(f, (const std::string&)l->key, l->value);
+			return;
+		}
+		Node* n = asNode(r);
+		size_t np = n->prefix.size();
+		size_t cmp = p.size() - depth < np ? p.size() - depth : np;
+		if (std::memcmp(p.data() + depth, n->prefix.data(), cmp) != 0) return;
+		if (depth + np >= p.size()) {
+			std::string path;
+			walk(r, path, nullptr, nullptr, f);
+			return;
+		}
+		depth += np;
+		Ref* c = findChild(n, (uint8_t)p[depth]);
+		if (c == nullptr) return;
+		r = *c;
+		++depth;
+	}
+}
+
+#endif // !RADIXTREE_H
@@ -0,0 +1,235 @@
+﻿/*****************************************************************
+ * @file   seededhashtable.hpp
+ * @brief  SeededHashTable class: véletlen kulccsal hashelő HashTable megbízhatatlan forrásból jövő string kulcsokhoz.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef SEEDEDHASHTABLE_H
+#define SEEDEDHASHTABLE_H
+#include <memory>
+#include <random>
+#include <string>
+#include "hashtable.hpp"
+#include "siphash.hpp"
+
+#include "memtrace.h"
+
+/**
+ * String kulcs a tábla kulcsával számolt hash értékével együtt.
+ * A HashTable hash függvénye nem kaphat táblánkénti paramétert, ezért a hash a kulccsal utazik,
+ * és a seededKeyHash csak leképezi a tábla méretére.
+ */
+struct SeededKey {
+	std::string str; //< A kulcs
+	uint64_t hash; //< A kulcs kulcsolt hash-e
+
+	SeededKey() :hash(0) {};
+	SeededKey(const std::string& str, uint64_t hash) :str(str), hash(hash) {};
+
+	/**
+	 * Először a hash-t hasonlítja, így a különböző kulcsok többnyire stringösszehasonlítás nélkül kiesnek.
+	 */
+	bool operator==(const SeededKey& rhs) const {
+		return hash == rhs.hash && str == rhs.str;
+	}
+	bool operator!=(const SeededKey& rhs) const {
+		return !(*this == rhs);
+	}
+};
+
+/**
+ * A SeededKey-ben tárolt hash-t képezi le a tábla méretére.
+ */
+inline size_t seededKeyHash(const SeededKey key, const size_t maxSize) {
+	return (size_t)(key.hash % maxSize);
+}
+
+/**
+ * Hash tábla támadó által választott string kulcsokhoz.
+ * A charCodeHash és a többi rögzített hash függvény könnyen invertálható: sok ütköző kulccsal
+ * minden keresés egyetlen hosszú lánc végigjárása lenne. Ez a tábla véletlen 128 bites kulccsal
+ * paraméterezett SipHash-t használ, amit a kulcs ismerete nélkül nem lehet ütköztetni.
+ * Második védelmi vonalként minden új elem után megnézi a lánc hosszát, és ha az
+ * a küszöb fölé nő, új véletlen kulcsot sorsol, és újrahashel mindent.
+ * @tparam T A tárolt adat típusa
+ * @tparam defSize A belső tábla tömbmérete.
+ * @tparam Hasher Kulcsolt hash policy: SipHash13 (default, gyorsabb) vagy SipHash24.
+ * @tparam Alloc Allokátor, a belső tábla ebből foglal. (default: std::allocator<T>)
+ */
+template<typename T, size_t defSize = 100, typename Hasher = SipHash13, typename Alloc = std::allocator<T>>
+class SeededHashTable {
+	typedef HashTable<T, SeededKey, seededKeyHash, defSize, Alloc> table;
+
+	std::unique_ptr<table> data; //< Az elemek
+	uint64_t k0; //< A hash kulcs alsó fele
+	uint64_t k1; //< A hash kulcs felső fele
+	size_t maxChain; //< Ennél hosszabb lánc újrasorsolja a kulcsot, 0: nincs ellenőrzés
+	size_t nReseeds; //< Az újrasorsolások száma
+	Alloc alloc; //< A belső tábla allokátora
+
+	/**
+	 * @return a kulcs a megadott hash kulccsal
+	 */
+	static SeededKey makeKey(const std::string& key, uint64_t seed0, uint64_t seed1) {
+		return SeededKey(key, Hasher::hash(key.data(), key.size(), seed0, seed1));
+	}
+
+	/**
+	 * @return a kulcs a jelenlegi hash kulccsal
+	 */
+	SeededKey makeKey(const std::string& key) const {
+		return makeKey(key, k0, k1);
+	}
+
+	/**
+	 * Új véletlen hash kulcsot sorsol a megadott változókba.
+	 */
+	static void randomSeed(uint64_t& seed0, uint64_t& seed1) {
+		std::random_device rd;
+		seed0 = ((uint64_t)rd() << 32) ^ rd();
+		seed1 = ((uint64_t)rd() << 32) ^ rd();
+	}
+
+	SeededHashTable(const SeededHashTable&); //< Másoló konstruktor tiltása
+	SeededHashTable& operator=(const SeededHashTable&); //< Értékadás tiltása
+public:
+	/**
+	 * Konstruktor véletlen hash kulccsal.
+	 * @param alloc a belső tábla allokátora
+	 */
+	explicit SeededHashTable(const Alloc& alloc = Alloc()) :data(new table(alloc)), maxChain(16), nReseeds(0), alloc(alloc) {
+		randomSeed(k0, k1);
+	}
+
+	/**
+	 * Konstruktor megadott hash kulccsal (reprodukálható tesztekhez, méréshez).
+	 * A kulcs titokban tartásán múlik a védelem.
+	 */
+	SeededHashTable(uint64_t k0, uint64_t k1, const Alloc& alloc = Alloc()) :data(new table(alloc)), k0(k0), k1(k1), maxChain(16), nReseeds(0), alloc(alloc) {};
+
+	/**
+	 * Berakja az elemet, ha a kulcs még nincs benne. Ha a lánc túl hosszú lett, újrasorsolja a hash kulcsot.
+	 * @return true, ha új elem került be
+	 */
+	bool put(const std::string& key, const T& value);
+
+	/**
+	 * @return a kulcshoz tartozó adatra mutató pointer, vagy nullptr
+	 */
+	T* get(const std::string& key) {
+		return data->get(makeKey(key));
+	}
+
+	/**
+	 * @return benne van-e a kulcs
+	 */
+	bool contains(const std::string& key) {
+		return data->contains(makeKey(key));
+	}
+
+	/**
+	 * Kitörli a kulcsot, ha benne van.
+	 */
+	void remove(const std::string& key) {
+		data->remove(makeKey(key));
+	}
+
+	/**
+	 * @return az elemek száma
+	 */
+	size_t size() const {
+		return data->size();
+	}
+
+	/**
+	 * Beállítja a láncok megengedett hosszát.
+	 * @param n ennél hosszabb lánc újrasorsolja a hash kulcsot. 0: nincs ellenőrzés
+	 */
+	void setMaxChainLength(size_t n) {
+		maxChain = n;
+	}
+
+	/**
+	 * Beállítja a belső tábla automatikus zsugorítási küszöbét (ld. HashTable::setMinLoadFactor).
+	 */
+	void setMinLoadFactor(double f) {
+		data->setMinLoadFactor(f);
+	}
+
+	/**
+	 * Bekapcsolja a belső tábla Bloom szűrőjét (ld. HashTable::enableBloomFilter).
+	 */
+	void enableBloomFilter(size_t bitsPerKey = 10) {
+		data->enableBloomFilter(bitsPerKey);
+	}
+
+	/**
+	 * @return a belső tábla Bloom szűrőjének statisztikái
+	 */
+	BloomStats bloomStats() const {
+		return data->bloomStats();
+	}
+
+	/**
+	 * Be- vagy kikapcsolja a belső tábla lineáris hashelését (ld. HashTable::enableLinearHashing).
+	 */
+	void enableLinearHashing(bool on = true) {
+		data->enableLinearHashing(on);
+	}
+
+	/**
+	 * @return a láncok megengedett hossza. Ha egy újrasorsolás sem segített, megduplázódik.
+	 */
+	size_t maxChainLength() const {
+		return maxChain;
+	}
+
+	/**
+	 * @return ennyiszer sorsolt új hash kulcsot a tábla
+	 */
+	size_t reseedCount() const {
+		return nReseeds;
+	}
+
+	/**
+	 * Új véletlen hash kulcsot sorsol, és minden elemet újrahashel vele.
+	 * Az új tábla előre a jelenlegi elemszámra nő, így az újraépítés egyetlen menet, és megkapja a régi beállításait.
+	 * A kulcsot csak a sikeres újraépítés után cseréli, így ha közben kivétel repül, a régi tábla érintetlen.
+	 */
+	void reseed();
+};
+
+template<typename T, size_t defSize, typename Hasher, typename Alloc>
+inline bool SeededHashTable<T, defSize, Hasher, Alloc>::put(const std::string& key, const T& value)
+{
+	SeededKey k = makeKey(key);
+	if (!data->put(k, value)) return false;
+	if (maxChain != 0 && data->chainLength(k) > maxChain) {
+		reseed();
+		// Ha egy friss kulcs mellett is túl hosszú, nem támadás, hanem túl kicsi a küszöb
+		if (data->chainLength(makeKey(key)) > maxChain)
+			maxChain *= 2;
+	}
+	return true;
+}
+
+template<typename T, size_t defSize, typename Hasher, typename Alloc>
+inline void SeededHashTable<T, defSize, Hasher, Alloc>::reseed()
+{
+	uint64_t seed0, seed1;
+	randomSeed(seed0, seed1);
+	std::unique_ptr<table> fresh(new table(alloc));
+	fresh->reserve(data->size());
+	fresh->copySettings(*data);
+	for (typename table::iterator iter = data->begin(); iter != data->end(); ++iter)
+		fresh->put(makeKey(iter->key.str, seed0, seed1), iter->value);
+	data.swap(fresh);
+	k0 = seed0;
+	k1 = seed1;
+	++nReseeds;
+}
+
+#endif // !SEEDEDHASHTABLE_H
@@ -0,0 +1,494 @@
+﻿/*****************************************************************
+ * @file   sharedhashtable.hpp
+ * @brief  SharedHashTable class: POSIX megosztott memóriában tárolt hash tábla, több folyamat közös használatára.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef SHAREDHASHTABLE_H
+#define SHAREDHASHTABLE_H
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include "hashtable.hpp"
+#include "durabletable.hpp"
+
+#include "memtrace.h"
+
+/**
+ * Hash tábla egy POSIX megosztott memória szegmensben (shm_open + mmap), hogy egy példány
+ * több folyamatot is kiszolgáljon (pl. előre forkolt munkafolyamatok közös keresőtáblája).
+ * A szegmensben minden hivatkozás a szegmens elejétől mért eltolás (offset), nem pointer,
+ * mert a folyamatok más-más címre mappelhetik. A 0 eltolás jelenti a nullptr-t (ott a fejléc van).
+ *
+ * Szegmens: fejléc, nBuckets vödörfej (u64 eltolás), majd az aréna a lánc elemeknek.
+ * Egy lánc elem: u64 következő, u64 hash, u32 kulcs hossz, u32 érték hossz, kulcs, érték.
+ * A kulcsok és értékek a wal::encode / wal::decode függvényekkel kerülnek a szegmensbe
+ * (std::string és triviálisan másolható típusok), ezért a get másolatot ad, nem pointert.
+ * Az aréna 16 << c byte-os méretosztályokból foglal, a törölt elemek helye a méretosztály
+ * szabad listájára kerül. A vödrök száma és a szegmens mérete a létrehozáskor rögzül, nincs újrahashelés.
+ *
+ * Szinkronizáció: folyamatok között megosztott (PTHREAD_PROCESS_SHARED) író-olvasó zár a fejlécben.
+ * Az olvasók egyszerre olvashatnak, az író kizárólagosan ír. A kódolás és a dekódolás a záron kívül fut
+ * (kivéve a forEach-et). Ha egy folyamat a zárat tartva hal meg, a zár nem szabadul fel.
+ * @tparam T A tárolt adat típusa
+ * @tparam keyType A kulcs típusa.
+ * @tparam hashFunction Hash függvény, H(kulcs) % maxSize alakú: a tábla maxSize = SIZE_MAX-szal hívja,
+ *         és a teljes értéket keveri tovább.
+ */
+template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash>
+class SharedHashTable {
+	static const uint32_t magic = 0x54485348; //< "HSHT"
+	static const size_t nodeHeader = 24; //< u64 következő, u64 hash, u32 kulcs hossz, u32 érték hossz
+	static const size_t sizeClasses = 40; //< 16 byte-tól 16 << 39 byte-ig
+
+	/**
+	 * A szegmens eleje.
+	 */
+	struct Header {
+		std::atomic<uint32_t> ready; //< A létrehozó a végén írja be a magic-et
+		uint32_t pad; //< Igazítás
+		uint64_t segmentSize; //< A szegmens mérete byte-ban
+		uint64_t nBuckets; //< A vödrök száma
+		uint64_t count; //< Az elemek száma
+		uint64_t arenaTop; //< Az aréna első még nem használt byte-ja
+		uint64_t freeLists[sizeClasses]; //< Méretosztályonként a szabad elemek listája
+		pthread_rwlock_t lock; //< Folyamatok között megosztott író-olvasó zár
+	};
+
+	/**
+	 * Olvasási zár a blokk végéig.
+	 */
+	struct ReadLock {
+		pthread_rwlock_t* l;
+		explicit ReadLock(pthread_rwlock_t* l) :l(l) { pthread_rwlock_rdlock(l); }
+		~ReadLock() { pthread_rwlock_unlock(l); }
+	};
+
+	/**
+	 * Írási zár a blokk végéig.
+	 */
+	struct WriteLock {
+		pthread_rwlock_t* l;
+		explicit WriteLock(pthread_rwlock_t* l) :l(l) { pthread_rwlock_wrlock(l); }
+		~WriteLock() { pthread_rwlock_unlock(l); }
+	};
+
+	int fd; //< A megosztott memória objektum
+	char* base; //< A szegmens eleje ebben a folyamatban
+	size_t mapped; //< A mappelt byte-ok
+	std::string name; //< A szegmens neve
+
+	Header* header() const { return reinterpret_cast<Header*>(base); }
+	uint64_t* bucketHeads() const { return reinterpret_cast<uint64_t*>(base + headerBytes()); }
+	char* at(uint64_t off) const { return base + off; }
+
+	static uint64_t getU64(const char* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+	static void setU64(char* p, uint64_t v) { std::memcpy(p, &v, 8); }
+	static uint32_t getU32(const char* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+	static void setU32(char* p, uint32_t v) { std::memcpy(p, &v, 4); }
+
+	/**
+	 * @return a fejléc mérete 16-ra kerekítve
+	 */
+	static size_t headerBytes() {
+		return (sizeof(Header) + 15) / 16 * 16;
+	}
+
+	/**
+	 * A hash függvény teljes értéke, összekeverve, hogy az alsó bitek is egyenletesek legyenek.
+	 */
+	static uint64_t fullHash(const keyType& key) {
+		uint64_t h = (uint64_t)hashFunction(key, SIZE_MAX);
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	/**
+	 * @return a legkisebb méretosztály, amibe bytes byte belefér
+	 */
+	static size_t sizeClass(size_t bytes) {
+		size_t c = 0;
+		while (((size_t)16 << c) < bytes) ++c;
+		return c;
+	}
+
+	/**
+	 * Lefoglal egy bytes méretű elemet az arénából. Csak írási zár alatt hívható.
+	 * @return az elem eltolása
+	 * @throw std::length_error ha a szegmens megtelt
+	 */
+	uint64_t allocNode(size_t bytes);
+
+	/**
+	 * Visszarakja az elemet a méretosztálya szabad listájára. Csak írási zár alatt hívható.
+	 */
+	void freeNode(uint64_t off);
+
+	/**
+	 * Megkeresi az elemet a vödrében. Olvasási vagy írási zár alatt hívható.
+	 * @param ekey a kulcs wal::encode-dal kódolva
+	 * @param link ide kerül a rá mutató eltolás címe (a vödörfej vagy az előző elem next mezője)
+	 * @return az elem eltolása, vagy 0
+	 */
+	uint64_t find(const std::string& ekey, uint64_t h, char** link) const;
+
+	/**
+	 * Új elemet fűz a vödre elejére. Csak írási zár alatt hívható.
+	 * @param ekey, evalue a kulcs és az érték wal::encode-dal kódolva
+	 */
+	void insertNode(const std::string& ekey, uint64_t h, const std::string& evalue);
+
+	/**
+	 * Leképezi a szegmenst.
+	 */
+	void map(size_t bytes);
+
+	SharedHashTable(const SharedHashTable&); //< Másoló konstruktor tiltása
+	SharedHashTable& operator=(const SharedHashTable&); //< Értékadás tiltása
+public:
+	/**
+	 * Létrehoz egy új megosztott szegmenst, és benne egy üres táblát.
+	 * A többi folyamat a név alapján nyithatja meg, vagy fork után közvetlenül használhatja ezt a példányt.
+	 * @param name a szegmens neve, "/"-rel kezdődik (shm_open)
+	 * @param buckets a vödrök száma, a várható elemszámhoz érdemes választani
+	 * @param bytes a szegmens teljes mérete (fejléc, vödrök és aréna)
+	 * @throw std::invalid_argument ha a vödrök nem férnek el a megadott méretben
+	 * @throw std::runtime_error ha már létezik ilyen nevű szegmens, vagy nem hozható létre
+	 */
+	SharedHashTable(const std::string& name, size_t buckets, size_t bytes);
+
+	/**
+	 * Megnyit egy már létrehozott szegmenst.
+	 * @param name a szegmens neve
+	 * @throw std::runtime_error ha nincs ilyen szegmens, vagy nem SharedHashTable (vagy még nincs kész)
+	 */
+	explicit SharedHashTable(const std::string& name);
+
+	/**
+	 * Törli a szegmens nevét. A már megnyitott példányok tovább működnek, a memória az utolsó bezáráskor szabadul fel.
+	 * @return sikerült-e
+	 */
+	static bool unlink(const std::string& name) {
+		return ::shm_unlink(name.c_str()) == 0;
+	}
+
+	/**
+	 * Berakja a megadott elemet, ha a kulcs még nincs benne.
+	 * @return true, ha új elem került be, false, ha a kulcs már benne volt
+	 * @throw std::length_error ha a szegmens megtelt
+	 */
+	bool put(keyType key, const T& value);
+
+	/**
+	 * Berakja vagy felülírja a megadott elemet.
+	 * @throw std::length_error ha a szegmens megtelt (ilyenkor a régi érték megmarad)
+	 */
+	void assign(keyType key, const T& value);
+
+	/**
+	 * @param value ide kerül a kulcshoz tartozó érték másolata, ha megtalálta
+	 * @return megtalálta-e
+	 */
+	bool get(keyType key, T& value) const;
+
+	/**
+	 * @return benne van-e a kulcs a táblában
+	 */
+	bool contains(keyType key) const;
+
+	/**
+	 * Kitörli a kulcs által jelölt elemet.
+	 * @return benne volt-e
+	 */
+	bool remove(keyType key);
+
+	/**
+	 * Olvasási zár alatt meghívja az f(key, value) függvényt minden elemre.
+	 * @param f f(const keyType&, const T&), nem módosíthatja ezt a táblát
+	 */
+	template<typename F>
+	void forEach(F f) const;
+
+	/**
+	 * @return Visszaadja a jelenlegi elemszámot
+	 */
+	size_t size() const;
+
+	/**
+	 * @return a vödrök száma
+	 */
+	size_t buckets() const {
+		return (size_t)header()->nBuckets;
+	}
+
+	/**
+	 * @return a szegmens eddig használt byte-jai (fejléc, vödrök, aréna)
+	 */
+	size_t bytesUsed() const;
+
+	/**
+	 * @return a szegmens mérete
+	 */
+	size_t bytes() const {
+		return mapped;
+	}
+
+	/**
+	 * Leképezi és bezárja a szegmenst. A szegmenst nem törli, arra az unlink() való.
+	 */
+	~SharedHashTable();
+};
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline void SharedHashTable<T, keyType, hashFunction>::map(size_t bytes)
+{
+	void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (p == MAP_FAILED) {
+		::close(fd);
+		throw std::runtime_error("Nem mappelheto: " + name);
+	}
+	base = (char*)p;
+	mapped = bytes;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline SharedHashTable<T, keyType, hashFunction>::SharedHashTable(const std::string& name, size_t buckets, size_t bytes)
+	:fd(-1), base(nullptr), mapped(0), name(name)
+{
+	if (buckets == 0) throw std::invalid_argument("Legalabb egy vodor kell.");
+	size_t arenaStart = headerBytes() + (buckets * 8 + 15) / 16 * 16;
+	if (bytes < arenaStart + 64) throw std::invalid_argument("A vodrok nem fernek el a szegmensben.");
+	fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0) throw std::runtime_error("Nem hozhato letre (mar letezik?): " + name);
+	if (::ftruncate(fd, (off_t)bytes) != 0) {
+		::close(fd);
+		::shm_unlink(name.c_str());
+		throw std::runtime_error("Nem foglalhato le a szegmens: " + name);
+	}
+	map(bytes);
+	// Az ftruncate nullázza a szegmenst, így a vödörfejek és a szabad listák már üresek
+	Header* h = header();
+	h->segmentSize = bytes;
+	h->nBuckets = buckets;
+	h->count = 0;
+	h->arenaTop = arenaStart;
+	pthread_rwlockattr_t attr;
+	pthread_rwlockattr_init(&attr);
+	pthread_rwlockattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+#ifdef __GLIBC__
+	// Sok olvasó mellett se éheztesse ki az írót
+	pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+	pthread_rwlock_init(&h->lock, &attr);
+	pthread_rwlockattr_destroy(&attr);
+	h->ready.store(magic, std::memory_order_release);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline SharedHashTable<T, keyType, hashFunction>::SharedHashTable(const std::string& name)
+	:fd(-1), base(nullptr), mapped(0), name(name)
+{
+	fd = ::shm_open(name.c_str(), O_RDWR, 0);
+	if (fd < 0) throw std::runtime_error("Nem nyithato meg: " + name);
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || (size_t)st.st_size < headerBytes()) {
+		::close(fd);
+		throw std::runtime_error("Hibas szegmens: " + name);
+	}
+	map((size_t)st.st_size);
+	if (header()->ready.load(std::memory_order_acquire) != magic || header()->segmentSize != mapped) {
+		::munmap(base, mapped);
+		::close(fd);
+		throw std::runtime_error("Nem SharedHashTable, vagy meg nincs kesz: " + name);
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline SharedHashTable<T, keyType, hashFunction>::~SharedHashTable()
+{
+	::munmap(base, mapped);
+	::close(fd);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline uint64_t SharedHashTable<T, keyType, hashFunction>::allocNode(size_t bytes)
+{
+	size_t c = sizeClass(bytes);
+	if (c >= sizeClasses) throw std::length_error("Tul nagy elem.");
+	Header* h = header();
+	uint64_t off = h->freeLists[c];
+	if (off != 0) {
+		h->freeLists[c] = getU64(at(off));
+		return off;
+	}
+	size_t size = (size_t)16 << c;
+	if (size > h->segmentSize - h->arenaTop) throw std::length_error("Megtelt a megosztott szegmens.");
+	off = h->arenaTop;
+	h->arenaTop += size;
+	return off;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline void SharedHashTable<T, keyType, hashFunction>::freeNode(uint64_t off)
+{
+	char* p = at(off);
+	size_t c = sizeClass(nodeHeader + getU32(p + 16) + getU32(p + 20));
+	setU64(p, header()->freeLists[c]);
+	header()->freeLists[c] = off;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline uint64_t SharedHashTable<T, keyType, hashFunction>::find(const std::string& ekey, uint64_t h, char** link) const
+{
+	char* prev = (char*)&bucketHeads()[h % header()->nBuckets];
+	for (uint64_t off = getU64(prev); off != 0; off = getU64(prev)) {
+		const char* p = at(off);
+		if (getU64(p + 8) == h && getU32(p + 16) == ekey.size() && std::memcmp(p + nodeHeader, ekey.data(), ekey.size()) == 0) {
+			if (link != nullptr) *link = prev;
+			return off;
+		}
+		prev = at(off); // A next mező az elem elején van
+	}
+	return 0;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline void SharedHashTable<T, keyType, hashFunction>::insertNode(const std::string& ekey, uint64_t h, const std::string& evalue)
+{
+	uint64_t off = allocNode(nodeHeader + ekey.size() + evalue.size());
+	char* p = at(off);
+	uint64_t* head = &bucketHeads()[h % header()->nBuckets];
+	setU64(p, *head);
+	setU64(p + 8, h);
+	setU32(p + 16, (uint32_t)ekey.size());
+	setU32(p + 20, (uint32_t)evalue.size());
+	std::memcpy(p + nodeHeader, ekey.data(), ekey.size());
+	std::memcpy(p + nodeHeader + ekey.size(), evalue.data(), evalue.size());
+	*head = off;
+	++header()->count;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline bool SharedHashTable<T, keyType, hashFunction>::put(keyType key, const T& value)
+{
+	std::string ekey, evalue;
+	wal::encode(ekey, key);
+	wal::encode(evalue, value);
+	uint64_t h = fullHash(key);
+	WriteLock lock(&header()->lock);
+	if (find(ekey, h, nullptr) != 0) return false;
+	insertNode(ekey, h, evalue);
+	return true;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline void SharedHashTable<T, keyType, hashFunction>::assign(keyType key, const T& value)
+{
+	std::string ekey, evalue;
+	wal::encode(ekey, key);
+	wal::encode(evalue, value);
+	uint64_t h = fullHash(key);
+	WriteLock lock(&header()->lock);
+	char* link;
+	uint64_t old = find(ekey, h, &link);
+	insertNode(ekey, h, evalue); // Ha dob, a régi elem érintetlen
+	if (old != 0) {
+		// Az új elem a vödör elejére került, így ha a régi volt az első, a link már az új elem next mezője
+		if (getU64(link) != old) link = at(getU64(link));
+		setU64(link, getU64(at(old)));
+		freeNode(old);
+		--header()->count;
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline bool SharedHashTable<T, keyType, hashFunction>::get(keyType key, T& value) const
+{
+	std::string ekey;
+	wal::encode(ekey, key);
+	uint64_t h = fullHash(key);
+	std::string evalue;
+	{
+		ReadLock lock(&header()->lock);
+		uint64_t off = find(ekey, h, nullptr);
+		if (off == 0) return false;
+		const char* p = at(off);
+		evalue.assign(p + nodeHeader + ekey.size(), getU32(p + 20));
+	}
+	const char* q = evalue.data();
+	return wal::decode(q, q + evalue.size(), value);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline bool SharedHashTable<T, keyType, hashFunction>::contains(keyType key) const
+{
+	std::string ekey;
+	wal::encode(ekey, key);
+	uint64_t h = fullHash(key);
+	ReadLock lock(&header()->lock);
+	return find(ekey, h, nullptr) != 0;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline bool SharedHashTable<T, keyType, hashFunction>::remove(keyType key)
+{
+	std::string ekey;
+	wal::encode(ekey, key);
+	uint64_t h = fullHash(key);
+	WriteLock lock(&header()->lock);
+	char* link;
+	uint64_t off = find(ekey, h, &link);
+	if (off == 0) return false;
+	setU64(link, getU64(at(off)));
+	freeNode(off);
+	--header()->count;
+	return true;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+template<typename F>
+inline void SharedHashTable<T, keyType, hashFunction>::forEach(F f) const
+{
+	ReadLock lock(&header()->lock);
+	uint64_t* heads = bucketHeads();
+	for (uint64_t b = 0; b < header()->nBuckets; ++b) {
+		for (uint64_t off = heads[b]; off != 0; off = getU64(at(off))) {
+			const char* p = at(off) + nodeHeader;
+			const char* end = p + getU32(at(off) + 16) + getU32(at(off) + 20);
+			keyType key;
+			T value;
+			if (wal::decode(p, end, key) && wal::decode(p, end, value))
+				f((const keyType&)key, (const T&)value);
+		}
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline size_t SharedHashTable<T, keyType, hashFunction>::size() const
+{
+	ReadLock lock(&header()->lock);
+	return (size_t)header()->count;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize)>
+inline size_t SharedHashTable<T, keyType, hashFunction>::bytesUsed() const
+{
+	ReadLock lock(&header()->lock);
+	return (size_t)header()->arenaTop;
+}
+
+#endif // !SHAREDHASHTABLE_H
@@ -0,0 +1,83 @@
+﻿/*****************************************************************
+ * @file   siphash.hpp
+ * @brief  SipHash kulcsolt hash függvény, a SeededHashTable hash policy-jei.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef SIPHASH_H
+#define SIPHASH_H
+#include <cstdint>
+#include <cstddef>
+
+#include "memtrace.h"
+
+/**
+ * SipHash-c-d (Aumasson, Bernstein). 128 bites titkos kulccsal paraméterezett 64 bites hash:
+ * a kulcs ismerete nélkül nem lehet egymással ütköző bemeneteket előállítani.
+ * @tparam cRounds tömörítő körök 8 byte-onként
+ * @tparam dRounds befejező körök
+ * @param data a hashelendő byte-ok
+ * @param len a byte-ok száma
+ * @param k0 a kulcs alsó 64 bitje
+ * @param k1 a kulcs felső 64 bitje
+ */
+template<int cRounds, int dRounds>
+uint64_t sipHash(const void* data, size_t len, uint64_t k0, uint64_t k1) {
+	const unsigned char* p = (const unsigned char*)data;
+	uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+	uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+	uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+	uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+	auto rotl = [](uint64_t x, int b) { return (x << b) | (x >> (64 - b)); };
+	auto round = [&]() {
+		v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+		v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+		v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+		v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+	};
+	auto compress = [&](uint64_t m) {
+		v3 ^= m;
+		for (int i = 0; i < cRounds; ++i) round();
+		v0 ^= m;
+	};
+
+	size_t words = len / 8;
+	for (size_t w = 0; w < words; ++w, p += 8) {
+		uint64_t m = 0;
+		for (int i = 0; i < 8; ++i)
+			m |= (uint64_t)p[i] << (8 * i); // little-endian, a géptől függetlenül
+		compress(m);
+	}
+	uint64_t b = (uint64_t)len << 56;
+	for (size_t i = 0; i < len % 8; ++i)
+		b |= (uint64_t)p[i] << (8 * i);
+	compress(b);
+
+	v2 ^= 0xff;
+	for (int i = 0; i < dRounds; ++i) round();
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/**
+ * SipHash-2-4: a szabványos, konzervatív változat.
+ */
+struct SipHash24 {
+	static uint64_t hash(const void* data, size_t len, uint64_t k0, uint64_t k1) {
+		return sipHash<2, 4>(data, len, k0, k1);
+	}
+};
+
+/**
+ * SipHash-1-3: kevesebb körrel, kb. kétszer gyorsabb. Hash tábla kulcsokhoz elegendő (a Rust HashMap is ezt használja).
+ */
+struct SipHash13 {
+	static uint64_t hash(const void* data, size_t len, uint64_t k0, uint64_t k1) {
+		return sipHash<1, 3>(data, len, k0, k1);
+	}
+};
+
+#endif // !SIPHASH_H
@@ -0,0 +1,279 @@
+﻿/*****************************************************************
+ * @file   splithashtable.hpp
+ * @brief  SplitHashTable class: a kulcsok a vödrökben, a nagy értékek külön, stabil címen tárolva (hot/cold split).
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef SPLITHASHTABLE_H
+#define SPLITHASHTABLE_H
+#include <memory>
+#include <vector>
+#include <new>
+#include "hashtable.hpp"
+
+#include "memtrace.h"
+
+/**
+ * Értéktároló: blockSize elemes blokkokból, szabad hely listával.
+ * Egy érték a törléséig ugyanazon a címen marad, a blokkok soha nem mozognak.
+ * @tparam T A tárolt érték típusa
+ * @tparam Alloc Allokátor, ebből foglalódnak a blokkok
+ * @tparam blockSize Egy blokk ennyi értéket tárol
+ */
+template<typename T, typename Alloc = std::allocator<T>, size_t blockSize = 64>
+class ValueStore {
+	/**
+	 * Egy hely: vagy egy élő érték, vagy a következő szabad hely.
+	 */
+	union Slot {
+		Slot* next; //< Szabad hely esetén a következő szabad hely
+		alignas(T) unsigned char storage[sizeof(T)]; //< Az érték helye
+	};
+
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Slot> slotAlloc;
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Slot*> blockAlloc;
+
+	slotAlloc alloc; //< A blokkok allokátora
+	std::vector<Slot*, blockAlloc> blocks; //< A lefoglalt blokkok
+	Slot* freeList; //< A szabad helyek listája
+	size_t used; //< Az élő értékek száma
+
+	ValueStore(const ValueStore&); //< Másoló konstruktor tiltása
+	ValueStore& operator=(const ValueStore&); //< Értékadás tiltása
+public:
+	explicit ValueStore(const Alloc& alloc = Alloc()) :alloc(alloc), blocks(blockAlloc(alloc)), freeList(nullptr), used(0) {};
+
+	/**
+	 * Létrehoz egy értéket egy szabad helyen. Ha nincs szabad hely, új blokkot foglal.
+	 * @return az érték címe, a destroy-ig érvényes
+	 */
+	template<typename... Args>
+	T* create(Args&&... args);
+
+	/**
+	 * Megszünteti az értéket, és a helyét visszarakja a szabad helyek közé.
+	 */
+	void destroy(T* value);
+
+	/**
+	 * @return az élő értékek száma
+	 */
+	size_t size() const {
+		return used;
+	}
+
+	/**
+	 * @return a lefoglalt blokkok száma
+	 */
+	size_t blockCount() const {
+		return blocks.size();
+	}
+
+	/**
+	 * Felszabadítja a blokkokat. Az élő értékeket előtte a tulajdonosnak kell destroy-jal megszüntetnie.
+	 */
+	~ValueStore();
+};
+
+template<typename T, typename Alloc, size_t blockSize>
+template<typename... Args>
+inline T* ValueStore<T, Alloc, blockSize>::create(Args&&... args)
+{
+	if (freeList == nullptr) {
+		Slot* block = std::allocator_traits<slotAlloc>::allocate(alloc, blockSize);
+		try {
+			blocks.push_back(block);
+		}
+		catch (...) {
+			std::allocator_traits<slotAlloc>::deallocate(alloc, block, blockSize);
+			throw;
+		}
+		for (size_t i = blockSize; i > 0; --i) {
+			block[i - 1].next = freeList;
+			freeList = &block[i - 1];
+		}
+	}
+	Slot* slot = freeList;
+	Slot* next = slot->next;
+	// A placement new helyett a std::allocator construct-ja, mert a memtrace átdefiniálja a new-t
+	T* value = reinterpret_cast<T*>(slot->storage);
+	std::allocator<T> plain;
+	std::allocator_traits<std::allocator<T>>::construct(plain, value, std::forward<Args>(args)...); // Ha dob, a hely szabad marad
+	freeList = next;
+	++used;
+	return value;
+}
+
+template<typename T, typename Alloc, size_t blockSize>
+inline void ValueStore<T, Alloc, blockSize>::destroy(T* value)
+{
+	value->~T();
+	Slot* slot = reinterpret_cast<Slot*>(value);
+	slot->next = freeList;
+	freeList = slot;
+	--used;
+}
+
+template<typename T, typename Alloc, size_t blockSize>
+inline ValueStore<T, Alloc, blockSize>::~ValueStore()
+{
+	for (Slot* block : blocks)
+		std::allocator_traits<slotAlloc>::deallocate(alloc, block, blockSize);
+}
+
+
+/**
+ * Hot/cold szétválasztott hash tábla nagy értékekhez.
+ * A vödrökben csak a kulcs és egy értékre mutató pointer van, maguk az értékek egy ValueStore-ban.
+ * Így a láncok bejárása (és a sikertelen keresés) nem húzza be a cache-be az értékeket, csak a találat,
+ * és az újrahashelés is csak a kulcsokat és a pointereket másolja.
+ * A get által visszaadott pointer a kulcs törléséig érvényes, az újrahashelés nem érvényteleníti.
+ * Kis értékekhez (int, pointer) a sima HashTable a jobb: ott az érték a kulccsal egy cache sorban van.
+ * @tparam T A tárolt adat típusa
+ * @tparam keyType A kulcs típusa.
+ * @tparam hashFunction Hash függvény, ami a megadott kulcstípusból előállít egy indexet a hashtábla mérettartományán belül.
+ * @tparam defSize A belső tábla tömbmérete.
+ * @tparam Alloc Allokátor, az értékek és a belső tábla is ebből foglalnak. (default: std::allocator<T>)
+ * @tparam Layout A belső tábla vödreinek elrendezése. (default: SegmentedLayout)
+ * @tparam Chain A belső tábla láncai. (default: LinkedChain)
+ */
+template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash, size_t defSize = 100, typename Alloc = std::allocator<T>, typename Layout = SegmentedLayout, typename Chain = LinkedChain>
+class SplitHashTable {
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<T*> tableAlloc;
+	typedef HashTable<T*, keyType, hashFunction, defSize, tableAlloc, Layout, Chain> table_type;
+
+	ValueStore<T, Alloc> values; //< Az értékek (cold)
+	table_type table; //< kulcs -> érték címe (hot)
+
+	SplitHashTable(const SplitHashTable&); //< Másoló konstruktor tiltása
+	SplitHashTable& operator=(const SplitHashTable&); //< Értékadás tiltása
+public:
+	/**
+	 * Konstruktor.
+	 * @param alloc az értékek és a belső tábla allokátora
+	 */
+	explicit SplitHashTable(const Alloc& alloc = Alloc()) :values(alloc), table(tableAlloc(alloc)) {};
+
+	/**
+	 * Berakja a megadott elemet, ha a kulcs még nincs benne. Egyszer hashel és egyszer keres.
+	 * Ha a belső tábla bővítése kivételt dob, a már létrehozott értéket megszünteti.
+	 * @param key az elemhez tartozó kulcs
+	 * @param value Tárolandó elem
+	 * @return true, ha új elem került be, false, ha a kulcs már benne volt
+	 */
+	bool put(keyType key, const T& value);
+
+	/**
+	 * @param key Az elemhez tartozó kulcs.
+	 * @return a kulcshoz tartozó adatra mutató pointer, ha nem találja nullptr.
+	 *         A pointer a kulcs törléséig érvényes, a táblát növelő put-ok után is.
+	 */
+	T* get(keyType key);
+
+	/**
+	 * @param key Az elemhez tartozó kulcs.
+	 * @return benne van-e a kulcs a táblában. Az értéket nem érinti.
+	 */
+	bool contains(keyType key);
+
+	/**
+	 * Kitörli a kulcs által jelölt elemet, az értéke helye újrahasznosul. Ha nincs benne, nem csinál semmit.
+	 * Egyszer hashel és egyszer keres.
+	 * @param key Az elemhez tartozó kulcs.
+	 */
+	void remove(keyType key);
+
+	/**
+	 * Meghívja az f(key, value) függvényt minden elemre.
+	 * @param f f(const keyType&, T&)
+	 */
+	template<typename F>
+	void forEach(F f);
+
+	/**
+	 * @return Visszaadja a jelenlegi elemszámot
+	 */
+	size_t size() const {
+		return table.size();
+	}
+
+	/**
+	 * @return az értéktároló blokkjainak száma
+	 */
+	size_t valueBlocks() const {
+		return values.blockCount();
+	}
+
+	/**
+	 * @return a belső tábla, pl. a Bloom szűrő vagy a lineáris hashelés bekapcsolásához
+	 */
+	table_type& index() {
+		return table;
+	}
+
+	/**
+	 * Destruktor. Megszünteti az összes értéket.
+	 */
+	~SplitHashTable();
+};
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline bool SplitHashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain>::put(keyType key, const T& value)
+{
+	T* created = nullptr;
+	try {
+		table.get_or_insert_with(key, [&]() {
+			created = values.create(value);
+			return created;
+		});
+	}
+	catch (...) {
+		// A push a factory után dobott: az érték nem került be a táblába, a helyét vissza kell adni
+		if (created != nullptr)
+			values.destroy(created);
+		throw;
+	}
+	return created != nullptr;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline T* SplitHashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain>::get(keyType key)
+{
+	T** found = table.get(key);
+	return found == nullptr ? nullptr : *found;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline bool SplitHashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain>::contains(keyType key)
+{
+	return table.contains(key);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline void SplitHashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain>::remove(keyType key)
+{
+	T* value;
+	if (table.remove(key, value))
+		values.destroy(value);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain>
+template<typename F>
+inline void SplitHashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain>::forEach(F f)
+{
+	for (typename table_type::iterator iter = table.begin(); iter != table.end(); ++iter)
+		f((const keyType&)iter->key, *iter->value);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc, typename Layout, typename Chain>
+inline SplitHashTable<T, keyType, hashFunction, defSize, Alloc, Layout, Chain>::~SplitHashTable()
+{
+	// A tábla a saját destruktorában ürül, itt csak az értékeket kell megszüntetni.
+	for (typename table_type::iterator iter = table.begin(); iter != table.end(); ++iter)
+		values.destroy(iter->value);
+}
+
+#endif // !SPLITHASHTABLE_H
@@ -0,0 +1,171 @@
+﻿/*****************************************************************
+ * @file   threadpool.hpp
+ * @brief  ThreadPool class: állandó szálak párhuzamos bejárásokhoz, munkalopó (work stealing) ciklussal.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <cstdint>
+
+#include "memtrace.h"
+
+/**
+ * Fix számú szál, amik a run() hívásra egyszerre elvégzik ugyanazt a feladatot.
+ * A hívó szál is dolgozik (ő a 0. munkás), így size() szálhoz size()-1 szálat indít.
+ * A szálak a pool élettartama alatt élnek, egy run() nem indít és nem állít le szálat.
+ * Egyszerre egy run() futhat, és a feladat nem hívhat run()-t ugyanazon a poolon.
+ */
+class ThreadPool {
+	std::vector<std::thread> workers; //< A háttérszálak
+	std::mutex m; //< A lenti mezők védelme
+	std::condition_variable wake; //< Új feladat vagy leállítás
+	std::condition_variable finished; //< Az utolsó háttérszál végzett
+	std::function<void(size_t)> task; //< A jelenlegi feladat, a munkás sorszámát kapja
+	uint64_t generation; //< Ennyiedik feladat, a szálak ebből látják, hogy új feladat jött
+	size_t running; //< Ennyi háttérszál dolgozik még a jelenlegi feladaton
+	bool stopping; //< Leállítás
+	std::exception_ptr error; //< Az első kivétel a feladatból
+
+	/**
+	 * Futtatja a feladatot, és megjegyzi az első kivételt.
+	 */
+	void runTask(size_t index) {
+		try {
+			task(index);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(m);
+			if (!error) error = std::current_exception();
+		}
+	}
+
+	void loop(size_t index) {
+		uint64_t seen = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(m);
+				wake.wait(lock, [&] { return stopping || generation != seen; });
+				if (stopping) return;
+				seen = generation;
+			}
+			runTask(index);
+			std::lock_guard<std::mutex> lock(m);
+			if (--running == 0) finished.notify_one();
+		}
+	}
+
+	ThreadPool(const ThreadPool&); //< Másoló konstruktor tiltása
+	ThreadPool& operator=(const ThreadPool&); //< Értékadás tiltása
+public:
+	/**
+	 * @param threads a munkások száma a hívó szállal együtt. 0: a hardveres szálak száma
+	 */
+	explicit ThreadPool(size_t threads = 0) :generation(0), running(0), stopping(false) {
+		if (threads == 0) threads = std::thread::hardware_concurrency();
+		if (threads == 0) threads = 1;
+		for (size_t i = 1; i < threads; ++i)
+			workers.push_back(std::thread(&ThreadPool::loop, this, i));
+	}
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(m);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::thread& t : workers) t.join();
+	}
+
+	/**
+	 * @return a munkások száma a hívó szállal együtt
+	 */
+	size_t size() const {
+		return workers.size() + 1;
+	}
+
+	/**
+	 * Minden munkáson meghívja az f(index) függvényt (index: 0 .. size()-1), és megvárja, hogy mind végezzen.
+	 * @throw a feladat első kivételét továbbdobja, miután minden munkás végzett
+	 */
+	template<typename F>
+	void run(F f);
+
+	/**
+	 * Párhuzamos ciklus munkalopással a [0, n) tartományon, chunk méretű darabokban.
+	 * Minden munkás kap egy egybefüggő darabsort, és az elejéről vesz. Ha elfogyott, a többiek
+	 * soraiból lop, így az egyenetlen darabok (pl. hosszú láncok) sem hagynak tétlen szálat.
+	 * @param f f(begin, end, worker) egy darabot dolgoz fel
+	 * @param maxWorkers legfeljebb ennyi munkás dolgozik (0: mind)
+	 */
+	template<typename F>
+	void parallelFor(size_t n, size_t chunk, F f, size_t maxWorkers = 0);
+};
+
+template<typename F>
+inline void ThreadPool::run(F f)
+{
+	{
+		std::lock_guard<std::mutex> lock(m);
+		task = f;
+		error = nullptr;
+		running = workers.size();
+		++generation;
+	}
+	wake.notify_all();
+	runTask(0);
+	std::unique_lock<std::mutex> lock(m);
+	finished.wait(lock, [&] { return running == 0; });
+	task = nullptr;
+	if (error) {
+		std::exception_ptr e = error;
+		error = nullptr;
+		std::rethrow_exception(e);
+	}
+}
+
+template<typename F>
+inline void ThreadPool::parallelFor(size_t n, size_t chunk, F f, size_t maxWorkers)
+{
+	if (n == 0) return;
+	if (chunk == 0) chunk = 1;
+	size_t chunks = (n + chunk - 1) / chunk;
+	size_t w = maxWorkers == 0 || maxWorkers > size() ? size() : maxWorkers;
+	if (w > chunks) w = chunks;
+
+	/**
+	 * Egy munkás darabsora. Külön cache sorban, hogy a számlálók ne ütközzenek (false sharing).
+	 */
+	struct alignas(64) Queue {
+		std::atomic<size_t> next; //< A következő kivehető darab
+		size_t end; //< A sor vége
+	};
+	std::vector<Queue> queues(w);
+	for (size_t i = 0; i < w; ++i) {
+		queues[i].next = chunks * i / w;
+		queues[i].end = chunks * (i + 1) / w;
+	}
+	run([&](size_t index) {
+		if (index >= w) return;
+		// A saját sor, majd sorban a többiek: a fetch_add miatt a tulajdonos és a tolvaj sem vehet ki kétszer egy darabot
+		for (size_t k = 0; k < w; ++k) {
+			Queue& q = queues[(index + k) % w];
+			for (size_t c = q.next.fetch_add(1); c < q.end; c = q.next.fetch_add(1)) {
+				size_t begin = c * chunk;
+				f(begin, begin + chunk < n ? begin + chunk : n, index);
+			}
+		}
+	});
+}
+
+#endif // !THREADPOOL_H
@@ -0,0 +1,288 @@
+﻿/*****************************************************************
+ * @file   ttlhashtable.hpp
+ * @brief  TtlHashTable class: lejárati idővel (TTL) rendelkező elemek, hierarchikus időzítő kerékkel.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef TTLHASHTABLE_H
+#define TTLHASHTABLE_H
+#include <memory>
+#include <utility>
+#include "hashtable.hpp"
+
+#include "memtrace.h"
+
+/**
+ * Hash tábla, amiben az elemek adott számú tick után lejárnak.
+ * Az idő tickekben telik, egy tick az expire_tick() egy hívása. (pl. ha 10 ms-onként hívjuk, egy tick 10 ms)
+ * A lejárt elemet a get már nem adja vissza (és törli), az expire_tick() pedig a lejárt elemeket szabadítja fel.
+ * Az elemek egy hierarchikus időzítő kerékben vannak: nLevels szint, szintenként 64 rekesz.
+ * A 0. szint egy rekesze egy tick, az 1. szinté 64 tick, és így tovább. A magasabb szintek rekeszei
+ * akkor kerülnek szétosztásra az alacsonyabb szinteken, amikor az idő eléri őket, így egy tick költsége
+ * a lejáró (és átrendezendő) elemek számával arányos, nem a tábla méretével. Ezért a belső tábla
+ * törléskor nem zsugorodik (egy tömeges lejárat különben teljes újrahashelést váltana ki).
+ * @tparam T A tárolt adat típusa
+ * @tparam keyType A kulcs típusa.
+ * @tparam hashFunction Hash függvény, ami a megadott kulcstípusból előállít egy indexet a hashtábla mérettartományán belül.
+ * @tparam defSize A belső tábla tömbmérete.
+ * @tparam Alloc Allokátor, az elemek és a belső tábla is ebből foglalnak. (default: std::allocator<T>)
+ */
+template<typename T, typename keyType = std::string, size_t hashFunction(keyType key, const size_t maxSize) = charCodeHash, size_t defSize = 100, typename Alloc = std::allocator<T>>
+class TtlHashTable {
+	static const size_t slotBits = 6; //< Egy szint 2^slotBits rekeszből áll
+	static const size_t nSlots = (size_t)1 << slotBits;
+	static const size_t nLevels = 4; //< Szintek száma. Ennél messzebbi lejárat a legfelső szinten vár.
+
+	/**
+	 * Időzített elem.
+	 */
+	struct TtlItem {
+		keyType key; //< Az elemhez tartozó kulcs, a lejáratkor kell
+		T value; //< A tárolt elem
+		size_t expiry; //< Ebben a tickben jár le. 0: soha
+		TtlItem** slot; //< Az elemet tartalmazó rekesz, vagy nullptr, ha nincs a kerékben
+		TtlItem* prev; //< Előző elem a rekeszben
+		TtlItem* next; //< Következő elem a rekeszben
+		TtlItem(const keyType& key, const T& value) :key(key), value(value), expiry(0), slot(nullptr), prev(nullptr), next(nullptr) {};
+	};
+
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<TtlItem> itemAlloc;
+	typedef std::allocator_traits<itemAlloc> traits;
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<TtlItem*> tableAlloc;
+	typedef HashTable<TtlItem*, keyType, hashFunction, defSize, tableAlloc> table_type;
+
+	itemAlloc alloc; //< Az elemek allokátora
+	table_type table; //< kulcs -> elem
+	TtlItem* wheel[nLevels][nSlots]; //< Az időzítő kerék rekeszei, mindegyik egy kétirányú lista
+	size_t current; //< A jelenlegi tick
+
+	/**
+	 * Beteszi az elemet a lejáratának megfelelő rekeszbe.
+	 */
+	void schedule(TtlItem* item);
+
+	/**
+	 * Kiveszi az elemet a rekeszéből.
+	 */
+	void unschedule(TtlItem* item);
+
+	/**
+	 * Kiveszi a táblából és a kerékből, majd felszabadítja az elemet.
+	 */
+	void destroy(TtlItem* item);
+
+	/**
+	 * Egy magasabb szintű rekesz elemeit újra beosztja az alacsonyabb szintekre.
+	 */
+	void cascade(size_t level, size_t slot);
+
+	TtlHashTable(const TtlHashTable&); //< Másoló konstruktor tiltása
+	TtlHashTable& operator=(const TtlHashTable&); //< Értékadás tiltása
+public:
+	/**
+	 * Konstruktor.
+	 * @param alloc az elemek és a belső tábla allokátora
+	 */
+	explicit TtlHashTable(const Alloc& alloc = Alloc());
+
+	/**
+	 * Berakja az elemet a táblába. Ha már benne van, felülírja az értékét és a lejáratát. Egyszer hashel és egyszer keres.
+	 * @param key az elemhez tartozó kulcs
+	 * @param value Tárolandó elem
+	 * @param ttl ennyi tick múlva jár le. 0: soha
+	 */
+	void put(keyType key, const T& value, size_t ttl = 0);
+
+	/**
+	 * @param key Az elemhez tartozó kulcs.
+	 * @return Visszaadja a kulcshoz tartozó adatra mutató pointert, ha nem találja, vagy már lejárt, nullptr-t.
+	 */
+	T* get(keyType key);
+
+	/**
+	 * Kitörli a kulcs által jelölt elemet. Ha nincs benne, nem csinál semmit.
+	 * @param key Az elemhez tartozó kulcs.
+	 */
+	void remove(keyType key);
+
+	/**
+	 * Léptet egy ticket, és felszabadítja az ekkor lejáró elemeket.
+	 * @return a felszabadított elemek száma
+	 */
+	size_t expire_tick();
+
+	/**
+	 * @return a jelenlegi tick
+	 */
+	size_t now() const;
+
+	/**
+	 * @return Visszaadja a jelenlegi elemszámot, a még fel nem szabadított lejárt elemekkel együtt.
+	 */
+	size_t size() const;
+
+	/**
+	 * Destruktor
+	 */
+	~TtlHashTable();
+};
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline TtlHashTable<T, keyType, hashFunction, defSize, Alloc>::TtlHashTable(const Alloc& alloc)
+	:alloc(alloc), table(tableAlloc(alloc)), current(0)
+{
+	table.setMinLoadFactor(0);
+	for (size_t l = 0; l < nLevels; ++l)
+		for (size_t s = 0; s < nSlots; ++s)
+			wheel[l][s] = nullptr;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline void TtlHashTable<T, keyType, hashFunction, defSize, Alloc>::schedule(TtlItem* item)
+{
+	size_t delta = item->expiry - current;
+	size_t level = 0;
+	while (level + 1 < nLevels && delta >= ((size_t)1 << (slotBits * (level + 1))))
+		++level;
+	// A kerék hatótávolságán túli elem a legfelső szint legtávolabbi rekeszébe kerül, onnan majd újra beosztódik.
+	size_t maxDelta = ((size_t)1 << (slotBits * nLevels)) - 1;
+	size_t at = (delta > maxDelta) ? current + maxDelta : item->expiry;
+	TtlItem** slot = &wheel[level][(at >> (slotBits * level)) & (nSlots - 1)];
+
+	item->slot = slot;
+	item->prev = nullptr;
+	item->next = *slot;
+	if (*slot != nullptr) (*slot)->prev = item;
+	*slot = item;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline void TtlHashTable<T, keyType, hashFunction, defSize, Alloc>::unschedule(TtlItem* item)
+{
+	if (item->slot == nullptr) return;
+	if (item->prev != nullptr) item->prev->next = item->next;
+	else *item->slot = item->next;
+	if (item->next != nullptr) item->next->prev = item->prev;
+	item->slot = nullptr;
+	item->prev = item->next = nullptr;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline void TtlHashTable<T, keyType, hashFunction, defSize, Alloc>::destroy(TtlItem* item)
+{
+	unschedule(item);
+	table.remove(item->key);
+	traits::destroy(alloc, item);
+	traits::deallocate(alloc, item, 1);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline void TtlHashTable<T, keyType, hashFunction, defSize, Alloc>::cascade(size_t level, size_t slot)
+{
+	TtlItem* iter = wheel[level][slot];
+	wheel[level][slot] = nullptr;
+	while (iter != nullptr) {
+		TtlItem* next = iter->next;
+		schedule(iter);
+		iter = next;
+	}
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline void TtlHashTable<T, keyType, hashFunction, defSize, Alloc>::put(keyType key, const T& value, size_t ttl)
+{
+	std::pair<typename table_type::iterator, bool> found = table.find_or_insert(key);
+	TtlItem* item;
+	if (!found.second) {
+		item = found.first->value;
+		item->value = value;
+		unschedule(item);
+	}
+	else {
+		item = nullptr;
+		try {
+			item = traits::allocate(alloc, 1);
+			traits::construct(alloc, item, key, value);
+		}
+		catch (...) {
+			if (item != nullptr) traits::deallocate(alloc, item, 1);
+			table.erase(found.first); // A kulcs ne maradjon elem nélkül a táblában
+			throw;
+		}
+		found.first->value = item;
+	}
+	item->expiry = (ttl == 0) ? 0 : current + ttl;
+	if (ttl != 0)
+		schedule(item);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline T* TtlHashTable<T, keyType, hashFunction, defSize, Alloc>::get(keyType key)
+{
+	TtlItem** found = table.get(key);
+	if (found == nullptr) return nullptr;
+	if ((*found)->expiry != 0 && (*found)->expiry <= current) {
+		// Lejárt, de még nem ért oda az expire_tick()
+		destroy(*found);
+		return nullptr;
+	}
+	return &(*found)->value;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline void TtlHashTable<T, keyType, hashFunction, defSize, Alloc>::remove(keyType key)
+{
+	TtlItem** found = table.get(key);
+	if (found == nullptr) return;
+	destroy(*found);
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline size_t TtlHashTable<T, keyType, hashFunction, defSize, Alloc>::expire_tick()
+{
+	++current;
+	// Ha egy szint körbeért, a következő szint aktuális rekeszét szét kell osztani.
+	for (size_t level = 1; level < nLevels; ++level) {
+		if ((current & (((size_t)1 << (slotBits * level)) - 1)) != 0) break;
+		cascade(level, (current >> (slotBits * level)) & (nSlots - 1));
+	}
+
+	size_t expired = 0;
+	TtlItem* iter = wheel[0][current & (nSlots - 1)];
+	while (iter != nullptr) {
+		TtlItem* next = iter->next;
+		if (iter->expiry <= current) {
+			destroy(iter);
+			++expired;
+		}
+		iter = next;
+	}
+	return expired;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline size_t TtlHashTable<T, keyType, hashFunction, defSize, Alloc>::now() const
+{
+	return current;
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline size_t TtlHashTable<T, keyType, hashFunction, defSize, Alloc>::size() const
+{
+	return table.size();
+}
+
+template<typename T, typename keyType, size_t hashFunction(keyType key, const size_t maxSize), size_t defSize, typename Alloc>
+inline TtlHashTable<T, keyType, hashFunction, defSize, Alloc>::~TtlHashTable()
+{
+	// A tábla csak pointereket tárol, az elemeket itt kell felszabadítani.
+	for (auto iter = table.begin(); iter != table.end(); ++iter) {
+		traits::destroy(alloc, iter->value);
+		traits::deallocate(alloc, iter->value, 1);
+	}
+}
+
+#endif // !TTLHASHTABLE_H
@@ -0,0 +1,512 @@
+﻿/*****************************************************************
+ * @file   unrolledlist.hpp
+ * @brief  Kigöngyölített (unrolled) láncolt lista: egy listaelem több adatot tárol.
+ *
+ * @author Pallos Gábor György
+ * @neptun QN1SXN
+ * @date   April 2023
+ *********************************************************************/
+
+#ifndef UNROLLEDLIST_H
+#define UNROLLEDLIST_H
+#include <memory>
+#include <functional>
+#include <utility>
+
+#include "memtrace.h"
+
+/**
+ * Generikus kigöngyölített láncolt lista. (nem sorrendtartó)
+ * Egy listaelem legfeljebb K adatot tárol egymás mellett, így a keresés kevesebb cache line-t érint,
+ * és K-szor kevesebb foglalás történik. A push és a remove csak az első listaelem méretét változtatja,
+ * így általában az első kivételével mindegyik tele van. Az erase és az erase_if helyben tömörít, utánuk
+ * más listaelem is lehet félig üres, de üres listaelem nem marad.
+ * A LinkedList-tel azonos a felülete, de egy elem törlésekor egy másik elem a helyére költözhet,
+ * ezért a find által visszaadott pointerek egy remove után érvénytelenné válhatnak.
+ * @tparam T a tárolt elemek típusa
+ * @tparam Alloc a listaelemek foglalásához használt allokátor (default: std::allocator<T>)
+ * @tparam K egy listaelemben tárolt adatok száma. Alapból annyi, hogy a listaelem kb. 2 cache line-t töltsön ki, de legalább 2.
+ */
+template<typename T, typename Alloc = std::allocator<T>, size_t K = (128 - 2 * sizeof(void*)) / sizeof(T) < 2 ? 2 : (128 - 2 * sizeof(void*)) / sizeof(T)>
+class UnrolledList {
+	/**
+	 * Listaelem: K darab adatnak helyet tartó blokk.
+	 */
+	struct UnrolledListItem {
+		size_t count; //< A listaelemben lévő adatok száma
+		UnrolledListItem* next; //< A következő listaelemre mutató pointer. Ha nincs következő, akkor nullptr
+		alignas(T) unsigned char storage[K * sizeof(T)]; //< Az adatok helye, csak az első count darab él
+
+		UnrolledListItem() :count(0), next(nullptr) {};
+		/**
+		 * @return az i. adat
+		 */
+		T* item(size_t i) {
+			return reinterpret_cast<T*>(storage) + i;
+		}
+	};
+
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<UnrolledListItem> itemAlloc;
+	typedef std::allocator_traits<itemAlloc> traits;
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<T> dataAlloc;
+	typedef std::allocator_traits<dataAlloc> dataTraits;
+
+	/**
+	 * A listaelemek allokátora.
+	 */
+	itemAlloc alloc;
+
+	/**
+	 * Az első listaelem. A push ebbe ír.
+	 */
+	UnrolledListItem* first;
+	UnrolledList(const UnrolledList&); //< Másoló konstruktor tiltása
+
+	/**
+	 * Megkeresi a megadott elemet.
+	 * @param item a keresett elem
+	 * @param idx ide kerül az elem indexe a listaelemen belül
+	 * @return az elemet tartalmazó listaelem, vagy nullptr
+	 */
+	UnrolledListItem* locate(const T& item, size_t& idx);
+
+	/**
+	 * Felszabadítja a lista összes elemét.
+	 */
+	void clear();
+public:
+	typedef Alloc allocator_type;
+
+	/**
+	 * Egy elem helye a bejárásban: az elemet tartalmazó listaelemre mutató pointer címe, és az index azon belül.
+	 * Ezzel az elem keresés nélkül törölhető. Egy push vagy egy törlés után elavulhat, ezt a getNext és az erase
+	 * észreveszi, és az elejéről keres. Az előző listaelem felszabadulása érvényteleníti.
+	 */
+	class position {
+		friend class UnrolledList;
+		UnrolledListItem** link; //< Az elemet tartalmazó listaelemre mutató pointer címe, vagy nullptr, ha nem ismert
+		size_t idx; //< Az elem indexe a listaelemen belül
+	public:
+		position() :link(nullptr), idx(0) {};
+	};
+private:
+	/**
+	 * Beállítja a pos-t az elem helyére: ha még arra mutat, keresés nélkül, különben megkeresi cím szerint.
+	 * @return benne van-e az elem a listában
+	 */
+	bool locate(const T* item, position& pos);
+public:
+
+	/**
+	 * Default konstruktor.
+	 * @param alloc a listaelemek foglalásához használt allokátor
+	 */
+	UnrolledList(const Alloc& alloc = Alloc()) :alloc(alloc), first(nullptr) {};
+
+	/**
+	 * Lemásolja a listát, nem elvárt, hogy sorrendtartó legyen.
+	 */
+	UnrolledList& operator=(const UnrolledList&);
+
+	/**
+	 * Hozzáad egy elemet a lista elejéhez. Új listaelemet csak akkor foglal, ha az első tele van.
+	 * @param item a tárolandó elem
+	 * @return a tárolt elemre mutató pointer
+	 */
+	T* push(T item);
+
+	/**
+	 * Hozzáad egy elemet a lista elejéhez, és megadja a helyét.
+	 * @param item a tárolandó elem
+	 * @param pos ide kerül a tárolt elem helye
+	 * @return a tárolt elemre mutató pointer
+	 */
+	T* push(T item, position& pos);
+
+	/**
+	 * Kitörli a megadott elemet a listából. A helyére az első listaelem utolsó adata kerül.
+	 * @param item A törlendő elem referenciája.
+	 * @return true, ha benne volt és törölte
+	 */
+	bool remove(const T& item);
+
+	/**
+	 * Kitörli a megadott címen lévő elemet. A helyére a saját listaelemének utolsó adata kerül,
+	 * így a bejárásban még hátralévő elemek közül egy sem kerül a már bejárt részbe.
+	 * @param item a listában lévő elemre mutató pointer
+	 * @return a bejárási sorrendben következő elemre mutató pointer, vagy nullptr, ha ez volt az utolsó
+	 */
+	T* erase(const T* item);
+
+	/**
+	 * Kitörli a megadott címen lévő elemet, mint az erase(item). Ha a pos az elem helye, nem keres.
+	 * @param item a listában lévő elemre mutató pointer
+	 * @param pos az elem helye, a visszatérés után a következő elem helye
+	 * @return a bejárási sorrendben következő elemre mutató pointer, vagy nullptr, ha ez volt az utolsó
+	 */
+	T* erase(const T* item, position& pos);
+
+	/**
+	 * Egyetlen bejárással kitörli az összes elemet, amire a pred igaz.
+	 * A listaelemeken belül a megmaradó elemek előre tömörödnek, a kiürült listaelemek a végén együtt szabadulnak fel.
+	 * @param pred pred(T&) -> bool
+	 * @return a törölt elemek száma
+	 */
+	template<typename F>
+	size_t erase_if(F pred);
+
+	/**
+	 * Egyetlen bejárással átrakja a dst-be az összes elemet, amire a pred igaz.
+	 * Az elemek helyben vannak a listaelemekben, ezért átköltöznek (move), a forrás az erase_if-hez hasonlóan helyben tömörödik.
+	 * A dst csak akkor foglal, ha az első listaeleme betelt.
+	 * @param dst a cél lista
+	 * @param pred pred(T&) -> bool
+	 * @return az átrakott elemek száma
+	 */
+	template<typename F>
+	size_t splice_if(UnrolledList& dst, F pred);
+
+	/**
+	 * Megkeresi a megadott elemet.
+	 * @param item Az elem referenciája.
+	 * @return Az elemre mutató pointer, ha nincs a listában, nullptr-t ad
+	 */
+	T* find(const T& item);
+
+	/**
+	 * Megkeresi a megadott elemet, és megadja a helyét, hogy utána keresés nélkül lehessen törölni.
+	 * @param item Az elem referenciája.
+	 * @param pos ide kerül az elem helye, ha benne van
+	 * @return Az elemre mutató pointer, ha nincs a listában, nullptr-t ad
+	 */
+	T* find(const T& item, position& pos);
+
+	/**
+	 * Megkeresi a lista megadott elem utáni elemét.
+	 * @param item Az elem referenciája.
+	 * @return Visszaadja a következő elemre mutató pointert, ha nem létezik, nullptr-t ad vissza.
+	 */
+	T* getNext(const T& item);
+
+	/**
+	 * A lista megadott elem utáni eleme. Ha a pos az elem helye, nem keres.
+	 * @param item a listában lévő elemre mutató pointer
+	 * @param pos az elem helye, a visszatérés után a következő elem helye
+	 * @return a következő elemre mutató pointer, vagy nullptr
+	 */
+	T* getNext(const T* item, position& pos);
+
+	/**
+	 * @return visszaadja az első elemére mutató ptr-t, vagy nullptr-t, ha üres a lista.
+	 */
+	T* getFirst();
+
+	/**
+	 * @param pos ide kerül az első elem helye
+	 * @return az első elemére mutató ptr, vagy nullptr, ha üres a lista.
+	 */
+	T* getFirst(position& pos);
+
+	/**
+	 * @return visszaadja, hogy üres-e a lista
+	 */
+	bool isEmpty() const;
+
+	/**
+	 * @return a lista elemeinek száma. Csak a listaelemeken megy végig.
+	 */
+	size_t length() const;
+
+	/**
+	 * @return a használt allokátor másolata
+	 */
+	Alloc get_allocator() const;
+
+	/**
+	 * Destruktor
+	 */
+	~UnrolledList();
+};
+
+/**
+ * Kigöngyölített listás vödrök: K elem egy listaelemben, egymás mellett.
+ */
+struct UnrolledChain {
+	template <typename T, typename Alloc>
+	using list = UnrolledList<T, Alloc>;
+};
+
+
+template<typename T, typename Alloc, size_t K>
+inline UnrolledList<T, Alloc, K>& UnrolledList<T, Alloc, K>::operator=(const UnrolledList& rhs)
+{
+	if (this == &rhs) return *this; // önértékadás
+	clear();
+	if constexpr (traits::propagate_on_container_copy_assignment::value)
+		alloc = rhs.alloc;
+	for (UnrolledListItem* iter = rhs.first; iter != nullptr; iter = iter->next) {
+		for (size_t i = 0; i < iter->count; ++i)
+			push(*iter->item(i));
+	}
+	return *this;
+}
+
+template<typename T, typename Alloc, size_t K>
+inline T* UnrolledList<T, Alloc, K>::push(T item)
+{
+	if (first == nullptr || first->count == K) {
+		UnrolledListItem* tmp = first;
+		first = traits::allocate(alloc, 1);
+		traits::construct(alloc, first);
+		first->next = tmp;
+	}
+	dataAlloc da(alloc);
+	dataTraits::construct(da, first->item(first->count), std::move(item));
+	return first->item(first->count++);
+}
+
+template<typename T, typename Alloc, size_t K>
+inline T* UnrolledList<T, Alloc, K>::push(T item, position& pos)
+{
+	T* res = push(item);
+	pos.link = &first;
+	pos.idx = first->count - 1;
+	return res;
+}
+
+template<typename T, typename Alloc, size_t K>
+inline typename UnrolledList<T, Alloc, K>::UnrolledListItem* UnrolledList<T, Alloc, K>::locate(const T& item, size_t& idx)
+{
+	for (UnrolledListItem* iter = first; iter != nullptr; iter = iter->next) {
+		for (size_t i = 0; i < iter->count; ++i) {
+			if (!(*iter->item(i) != item)) {
+				idx = i;
+				return iter;
+			}
+		}
+	}
+	return nullptr;
+}
+
+template<typename T, typename Alloc, size_t K>
+inline bool UnrolledList<T, Alloc, K>::remove(const T& item)
+{
+	size_t idx;
+	UnrolledListItem* iter = locate(item, idx);
+	if (iter == nullptr) return false;
+
+	// Az első listaelem utolsó adata kerül a helyére, így a többi listaelem nem fogy.
+	T* last = first->item(first->count - 1);
+	if (iter->item(idx) != last)
+		*iter->item(idx) = std::move(*last);
+	dataAlloc da(alloc);
+	dataTraits::destroy(da, last);
+	if (--first->count == 0) {
+		UnrolledListItem* next = first->next;
+		traits::destroy(alloc, first);
+		traits::deallocate(alloc, first, 1);
+		first = next;
+	}
+	return true;
+}
+
+template<typename T, typename Alloc, size_t K>
+inline bool UnrolledList<T, Alloc, K>::locate(const T* item, position& pos)
+{
+	if (pos.link != nullptr && *pos.link != nullptr && pos.idx < (*pos.link)->count && (*pos.link)->item(pos.idx) == item)
+		return true;
+	std::less<const T*> before;
+	for (UnrolledListItem** link = &first; *link != nullptr; link = &(*link)->next) {
+		UnrolledListItem* iter = *link;
+		if (before(item, iter->item(0)) || !before(item, iter->item(iter->count))) continue;
+		pos.link = link;
+		pos.idx = (size_t)(item - iter->item(0));
+		return true;
+	}
+	return false;
+}
+
+template<typename T, typename Alloc, size_t K>
+inline T* UnrolledList<T, Alloc, K>::erase(const T* item)
+{
+	position pos;
+	return erase(item, pos);
+}
+
+template<typename T, typename Alloc, size_t K>
+inline T* UnrolledList<T, Alloc, K>::erase(const T* item, position& pos)
+{
+	if (!locate(item, pos)) return nullptr;
+	UnrolledListItem** link = pos.link;
+	UnrolledListItem* iter = *link;
+	T* last = iter->item(iter->count - 1);
+	if (iter->item(pos.idx) != last)
+		*iter->item(pos.idx) = std::move(*last);
+	dataAlloc da(alloc);
+	dataTraits::destroy(da, last);
+	if (--iter->count == 0) {
+		*link = iter->next;
+		traits::destroy(alloc, iter);
+		traits::deallocate(alloc, iter, 1);
+		pos.idx = 0;
+		return *link == nullptr ? nullptr : (*link)->item(0);
+	}
+	if (pos.idx < iter->count) return iter->item(pos.idx); // Ide költözött a következő, még be nem járt elem
+	pos.link = &iter->next;
+	pos.idx = 0;
+	return iter->next == nullptr ? nullptr : iter->next->item(0);
+}
+
+template<typename T, typename Alloc, size_t K>
+template<typename F>
+inline size_t UnrolledList<T, Alloc, K>::erase_if(F pred)
+{
+	dataAlloc da(alloc);
+	UnrolledListItem* garbage = nullptr; // A kiürült listaelemek
+	size_t n = 0;
+	for (UnrolledListItem** link = &first; *link != nullptr;) {
+		UnrolledListItem* iter = *link;
+		size_t kept = 0;
+		for (size_t i = 0; i < iter->count; ++i) {
+			if (pred(*iter->item(i))) {
+				++n;
+				continue;
+			}
+			if (kept != i)
+				*iter->item(kept) = std::move(*iter->item(i));
+			++kept;
+		}
+		for (size_t i = kept; i < iter->count; ++i)
+			dataTraits::destroy(da, iter->item(i));
+		iter->count = kept;
+		if (kept == 0) {
+			*link = iter->next;
+			iter->next = garbage;
+			garbage = iter;
+		}
+		else {
+			link = &iter->next;
+		}
+	}
+	while (garbage != nullptr) {
+		UnrolledListItem* next = garbage->next;
+		traits::destroy(alloc, garbage);
+		traits::deallocate(alloc, garbage, 1);
+		garbage = next;
+	}
+	return n;
+}
+
+template<typename T, typename Alloc, size_t K>
+template<typename F>
+inline size_t UnrolledList<T, Alloc, K>::splice_if(UnrolledList& dst, F pred)
+{
+	return erase_if([&dst, &pred](T& item) {
+		if (!pred(item)) return false;
+		dst.push(std::move(item));
+		return true;
+	});
+}
+
+template<typename T, typename Alloc, size_t K>
+inline T* UnrolledList<T, Alloc, K>::find(const T& item)
+{
+	size_t idx;
+	UnrolledListItem* iter = locate(item, idx);
+	if (iter == nullptr) return nullptr;
+	return iter->item(idx);
+}
+
+template<typename T, typename Alloc, size_t K>
+inline T* UnrolledList<T, Alloc, K>::find(const T& item, position& pos)
+{
+	for (UnrolledListItem** link = &first; *link != nullptr; link = &(*link)->next) {
+		for (size_t i = 0; i < (*link)->count; ++i) {
+			if (!(*(*link)->item(i) != item)) {
+				pos.link = link;
+				pos.idx = i;
+				return (*link)->item(i);
+			}
+		}
+	}
+	return nullptr;
+}
+
+template<typename T, typename Alloc, size_t K>
+inline T* UnrolledList<T, Alloc, K>::getNext(const T& item)
+{
+	size_t idx;
+	UnrolledListItem* iter = locate(item, idx);
+	if (iter == nullptr) return nullptr;
+	if (idx + 1 < iter->count) return iter->item(idx + 1);
+	if (iter->next == nullptr) return nullptr;
+	return iter->next->item(0);
+}
+
+template<typename T, typename Alloc, size_t K>
+inline T* UnrolledList<T, Alloc, K>::getFirst()
+{
+	if (isEmpty()) return nullptr;
+	return first->item(0);
+}
+
+template<typename T, typename Alloc, size_t K>
+inline T* UnrolledList<T, Alloc, K>::getFirst(position& pos)
+{
+	pos.link = &first;
+	pos.idx = 0;
+	return getFirst();
+}
+
+template<typename T, typename Alloc, size_t K>
+inline T* UnrolledList<T, Alloc, K>::getNext(const T* item, position& pos)
+{
+	if (!locate(item, pos)) return nullptr;
+	if (++pos.idx < (*pos.link)->count) return (*pos.link)->item(pos.idx);
+	pos.link = &(*pos.link)->next;
+	pos.idx = 0;
+	return *pos.link == nullptr ? nullptr : (*pos.link)->item(0);
+}
+
+template<typename T, typename Alloc, size_t K>
+inline bool UnrolledList<T, Alloc, K>::isEmpty() const
+{
+	return first == nullptr;
+}
+
+template<typename T, typename Alloc, size_t K>
+inline size_t UnrolledList<T, Alloc, K>::length() const
+{
+	size_t n = 0;
+	for (UnrolledListItem* iter = first; iter != nullptr; iter = iter->next)
+		n += iter->count;
+	return n;
+}
+
+template<typename T, typename Alloc, size_t K>
+inline Alloc UnrolledList<T, Alloc, K>::get_allocator() const
+{
+	return Alloc(alloc);
+}
+
+template<typename T, typename Alloc, size_t K>
+inline void UnrolledList<T, Alloc, K>::clear()
+{
+	dataAlloc da(alloc);
+	while (!isEmpty()) {
+		UnrolledListItem* next = first->next;
+		for (size_t i = 0; i < first->count; ++i)
+			dataTraits::destroy(da, first->item(i));
+		traits::destroy(alloc, first);
+		traits::deallocate(alloc, first, 1);
+		first = next;
+	}
+}
+
+template<typename T, typename Alloc, size_t K>
+inline UnrolledList<T, Alloc, K>::~UnrolledList()
+{
+	clear();
+}
+
+#endif // !UNROLLEDLIST_H